@@ -0,0 +1,218 @@
+#include "net.address_text.h"
+
+#include <cstring>
+
+namespace
+{
+	const char hex_digits[] = "0123456789abcdef";
+
+	// value of each hex digit, -1 for other characters
+	const signed char hex_values[256] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+	};
+}
+
+bool net::address_text::parse_v4(const char* first, const char* last, std::uint8_t* bytes)
+{
+	int parts = 0;
+	const char* p = first;
+	while (parts < 4) {
+		if (p == last || *p < '0' || *p > '9')
+			return false;
+		// a leading zero is only valid as the whole part
+		unsigned int value = *p++ - '0';
+		if (value != 0) {
+			while (p != last && *p >= '0' && *p <= '9') {
+				value = value * 10 + (*p++ - '0');
+				if (value > 255)
+					return false;
+			}
+		}
+		bytes[parts++] = static_cast<std::uint8_t>(value);
+		if (parts < 4) {
+			if (p == last || *p != '.')
+				return false;
+			++p;
+		}
+	}
+	return p == last;
+}
+
+bool net::address_text::parse_v6(const char* first, const char* last, std::uint8_t* bytes)
+{
+	std::uint8_t parsed[16];
+	int count = 0;				// bytes parsed
+	int gap = -1;				// where "::" stands, in bytes
+	const char* group = first;
+	unsigned int value = 0;
+	int digits = 0;
+
+	const char* p = first;
+	if (p == last)
+		return false;
+	if (*p == ':' && (++p == last || *p != ':'))
+		return false;
+
+	while (p != last) {
+		char c = *p++;
+		int h = hex_values[static_cast<unsigned char>(c)];
+		if (h >= 0) {
+			if (++digits > 4)
+				return false;
+			value = (value << 4) | h;
+			continue;
+		}
+		if (c == ':') {
+			group = p;
+			if (digits == 0) {
+				if (gap >= 0)
+					return false;
+				gap = count;
+				continue;
+			}
+			if (p == last || count + 2 > 16)
+				return false;
+			parsed[count++] = static_cast<std::uint8_t>(value >> 8);
+			parsed[count++] = static_cast<std::uint8_t>(value);
+			value = 0;
+			digits = 0;
+			continue;
+		}
+		// a dotted-quad may only form the last 32 bits
+		if (c == '.' && count + 4 <= 16 && parse_v4(group, last, parsed + count)) {
+			count += 4;
+			digits = 0;
+			break;
+		}
+		return false;
+	}
+	if (digits != 0) {
+		if (count + 2 > 16)
+			return false;
+		parsed[count++] = static_cast<std::uint8_t>(value >> 8);
+		parsed[count++] = static_cast<std::uint8_t>(value);
+	}
+
+	if (gap < 0) {
+		if (count != 16)
+			return false;
+		std::memcpy(bytes, parsed, 16);
+		return true;
+	}
+	// "::" stands for at least one group
+	if (count == 16)
+		return false;
+	int fill = 16 - count;
+	std::memcpy(bytes, parsed, gap);
+	std::memset(bytes + gap, 0, fill);
+	std::memcpy(bytes + gap + fill, parsed + gap, count - gap);
+	return true;
+}
+
+int net::address_text::parse(const char* first, const char* last, std::uint8_t* bytes)
+{
+	// a colon must appear within the first five characters of an IPv6
+	// address, and never in an IPv4 one
+	for (const char* p = first; p != last && p - first < 5; ++p) {
+		if (*p == ':')
+			return parse_v6(first, last, bytes) ? 16 : 0;
+	}
+	return parse_v4(first, last, bytes) ? 4 : 0;
+}
+
+char* net::address_text::format_v4(const std::uint8_t* bytes, char* out)
+{
+	for (int i = 0; i < 4; ++i) {
+		if (i != 0)
+			*out++ = '.';
+		unsigned int value = bytes[i];
+		if (value >= 100) {
+			*out++ = static_cast<char>('0' + value / 100);
+			value %= 100;
+			*out++ = static_cast<char>('0' + value / 10);
+		}
+		else if (value >= 10)
+			*out++ = static_cast<char>('0' + value / 10);
+		*out++ = static_cast<char>('0' + value % 10);
+	}
+	return out;
+}
+
+char* net::address_text::format_v6(const std::uint8_t* bytes, char* out)
+{
+	unsigned int groups[8];
+	for (int i = 0; i < 8; ++i)
+		groups[i] = (static_cast<unsigned int>(bytes[2 * i]) << 8) | bytes[2 * i + 1];
+
+	// RFC 5952 section 5: IPv4-mapped addresses keep the dotted-quad
+	if (groups[0] == 0 && groups[1] == 0 && groups[2] == 0 && groups[3] == 0
+		&& groups[4] == 0 && groups[5] == 0xffff) {
+		std::memcpy(out, "::ffff:", 7);
+		return format_v4(bytes + 12, out + 7);
+	}
+
+	// the first longest run of at least two zero groups is compressed
+	int best = -1, best_length = 1;
+	for (int i = 0; i < 8;) {
+		if (groups[i] != 0) {
+			++i;
+			continue;
+		}
+		int j = i;
+		while (j < 8 && groups[j] == 0)
+			++j;
+		if (j - i > best_length) {
+			best = i;
+			best_length = j - i;
+		}
+		i = j;
+	}
+
+	for (int i = 0; i < 8; ++i) {
+		if (i == best) {
+			*out++ = ':';
+			*out++ = ':';
+			i += best_length - 1;
+			continue;
+		}
+		if (i != 0 && i != best + best_length)
+			*out++ = ':';
+		unsigned int value = groups[i];
+		if (value >= 0x1000)
+			*out++ = hex_digits[value >> 12];
+		if (value >= 0x100)
+			*out++ = hex_digits[(value >> 8) & 0xf];
+		if (value >= 0x10)
+			*out++ = hex_digits[(value >> 4) & 0xf];
+		*out++ = hex_digits[value & 0xf];
+	}
+	return out;
+}
+
+char* net::address_text::format_decimal(std::uint32_t value, char* out)
+{
+	char digits[max_decimal_length];
+	int count = 0;
+	do {
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (count > 0)
+		*out++ = digits[--count];
+	return out;
+}
@@ -0,0 +1,73 @@
+#ifndef __NET_ADDRESS_TEXT__
+#define __NET_ADDRESS_TEXT__
+
+#include "net.config.h"
+
+#include <cstdint>
+
+namespace net
+{
+	/**
+	* Parses and formats numeric IP addresses without the system resolver
+	* and without allocating. Parsers accept exactly what inet_pton accepts
+	* and formatters write into caller buffers, returning the end of the
+	* text written; no terminating null is added.
+	*/
+	class address_text
+	{
+	public:
+		/**
+		* Longest text written by format_v4, format_v6 and format_decimal.
+		*/
+		static const int max_v4_length = 15;
+		static const int max_v6_length = 45;
+		static const int max_decimal_length = 10;
+	public:
+		/**
+		* Parses a dotted-quad IPv4 address in [first, last) into the 4
+		* bytes at bytes, network byte order. Returns false, leaving bytes
+		* unspecified, if the text is not exactly four decimal parts of 0
+		* to 255 without leading zeros.
+		*/
+		static bool parse_v4(const char* first, const char* last, std::uint8_t* bytes);
+
+		/**
+		* Parses an IPv6 address in [first, last), optionally ending in a
+		* dotted-quad, into the 16 bytes at bytes. Scope ids are not
+		* accepted.
+		*/
+		static bool parse_v6(const char* first, const char* last, std::uint8_t* bytes);
+
+		/**
+		* Parses an IPv4 or IPv6 address into bytes, which must hold 16
+		* bytes. Returns the length of the address, 4 or 16, or zero if the
+		* text is neither.
+		*/
+		static int parse(const char* first, const char* last, std::uint8_t* bytes);
+
+		/**
+		* Writes the 4 bytes at bytes as a dotted-quad.
+		*/
+		static char* format_v4(const std::uint8_t* bytes, char* out);
+
+		/**
+		* Writes the 16 bytes at bytes in the canonical form of RFC 5952:
+		* lower case, no leading zeros, the longest run of two or more zero
+		* groups compressed to "::", and IPv4-mapped addresses ending in a
+		* dotted-quad.
+		*/
+		static char* format_v6(const std::uint8_t* bytes, char* out);
+
+		/**
+		* Writes value in decimal.
+		*/
+		static char* format_decimal(std::uint32_t value, char* out);
+	private:
+		address_text(void);
+		address_text(const address_text&);
+		address_text& operator=(const address_text&);
+		address_text& operator=(const address_text&&);
+	};
+}
+
+#endif
@@ -0,0 +1,286 @@
+#include "net.buffer_pool.h"
+
+#include <cstdio>
+#include <new>
+
+#if defined(NET_LINUX)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace
+{
+	// blocks start after a cache line holding the node of the slab
+	const std::size_t header_size = 64;
+	const int max_nodes = 64;
+}
+
+thread_local net::buffer_pool::thread_cache net::buffer_pool::cache_;
+
+net::buffer_pool::thread_cache::thread_cache(void)
+	: owner_(nullptr)
+	, node_(0)
+{
+}
+
+net::buffer_pool::thread_cache::~thread_cache(void)
+{
+	if (owner_ == nullptr)
+		return;
+	for (int i = 0; i < class_count; ++i) {
+		while (!blocks_[i].empty())
+			owner_->release(owner_->node_of(blocks_[i].back()), i, blocks_[i], 1);
+	}
+}
+
+net::buffer_pool::buffer_pool(const bool& huge_pages, const int& cache_size)
+	: arenas_()
+	, slabs_mutex_()
+	, slabs_()
+	, huge_pages_(huge_pages)
+	, reserved_bytes_(0)
+	, cache_size_(cache_size)
+{
+	int nodes = count_nodes();
+	for (int i = 0; i < nodes; ++i)
+		arenas_.push_back(std::unique_ptr<arena>(new arena()));
+}
+
+net::buffer_pool::~buffer_pool(void)
+{
+	// blocks cached by other threads must have been returned by now
+	if (cache_.owner_ == this) {
+		cache_.owner_ = nullptr;
+		for (int i = 0; i < class_count; ++i)
+			cache_.blocks_[i].clear();
+	}
+	for (void* slab : slabs_) {
+#if defined(NET_LINUX)
+		::munmap(slab, slab_size);
+#else
+		::operator delete(slab);
+#endif
+	}
+}
+
+net::buffer_pool& net::buffer_pool::get_default(void)
+{
+	static buffer_pool* pool = new buffer_pool();
+	return *pool;
+}
+
+int net::buffer_pool::get_block_size(const int& size)
+{
+	if (size > max_block_size)
+		return size;
+	return min_block_size << get_class(size);
+}
+
+std::uint8_t* net::buffer_pool::allocate(const int& size)
+{
+	if (size > max_block_size)
+		return static_cast<std::uint8_t*>(::operator new(size));
+	int index = get_class(size);
+	thread_cache& cache = cache_;
+	if (cache.owner_ == nullptr && cache_size_ > 0) {
+		cache.owner_ = this;
+		cache.node_ = current_node();
+	}
+	if (cache.owner_ != this) {
+		// the thread caches for another pool, take a block under the lock
+		int node = current_node();
+		arena& a = *arenas_[node];
+		std::lock_guard<std::mutex> lock(a.mutex_);
+		if (a.free_[index].empty())
+			carve(node, index);
+		std::uint8_t* block = a.free_[index].back();
+		a.free_[index].pop_back();
+		return block;
+	}
+	if (cache.blocks_[index].empty())
+		refill(cache, index);
+	std::uint8_t* block = cache.blocks_[index].back();
+	cache.blocks_[index].pop_back();
+	return block;
+}
+
+void net::buffer_pool::deallocate(std::uint8_t* buffer, const int& size)
+{
+	if (buffer == nullptr)
+		return;
+	if (size > max_block_size) {
+		::operator delete(buffer);
+		return;
+	}
+	int index = get_class(size);
+	int node = node_of(buffer);
+	thread_cache& cache = cache_;
+	if (cache.owner_ != this || node != cache.node_) {
+		// blocks of remote nodes go home so they are reused where they live
+		std::vector<std::uint8_t*> blocks(1, buffer);
+		release(node, index, blocks, 1);
+		return;
+	}
+	std::vector<std::uint8_t*>& blocks = cache.blocks_[index];
+	if (static_cast<int>(blocks.size()) >= cache_size_)
+		release(node, index, blocks, blocks.size() / 2);
+	blocks.push_back(buffer);
+}
+
+int net::buffer_pool::get_class(const int& size)
+{
+	int index = 0;
+	while ((min_block_size << index) < size)
+		++index;
+	return index;
+}
+
+int net::buffer_pool::current_node(void) const
+{
+#if defined(NET_LINUX)
+	unsigned cpu = 0;
+	unsigned node = 0;
+	if (arenas_.size() == 1 ||
+			::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 ||
+			node >= arenas_.size())
+		return 0;
+	return static_cast<int>(node);
+#else
+	return 0;
+#endif
+}
+
+int net::buffer_pool::count_nodes(void)
+{
+	int nodes = 1;
+#if defined(NET_LINUX)
+	// lists the possible nodes as ranges, e.g. "0-3" or "0,2-3"
+	FILE* f = std::fopen("/sys/devices/system/node/possible", "r");
+	if (f != nullptr) {
+		int value = 0;
+		int c;
+		while ((c = std::fgetc(f)) != EOF) {
+			if (c >= '0' && c <= '9') {
+				value = value * 10 + (c - '0');
+				continue;
+			}
+			if (value + 1 > nodes)
+				nodes = value + 1;
+			value = 0;
+		}
+		if (value + 1 > nodes)
+			nodes = value + 1;
+		std::fclose(f);
+	}
+#endif
+	return nodes < max_nodes ? nodes : max_nodes;
+}
+
+int net::buffer_pool::node_of(const std::uint8_t* block) const
+{
+#if defined(NET_LINUX)
+	std::uintptr_t slab = reinterpret_cast<std::uintptr_t>(block) &
+		~static_cast<std::uintptr_t>(slab_size - 1);
+	return *reinterpret_cast<const int*>(slab);
+#else
+	(void) block;
+	return 0;
+#endif
+}
+
+void net::buffer_pool::refill(thread_cache& cache, const int& index)
+{
+	// the thread may have migrated, follow it to its current node
+	int node = current_node();
+	if (node != cache.node_) {
+		for (int i = 0; i < class_count; ++i)
+			release(cache.node_, i, cache.blocks_[i], cache.blocks_[i].size());
+		cache.node_ = node;
+	}
+	arena& a = *arenas_[node];
+	std::lock_guard<std::mutex> lock(a.mutex_);
+	std::vector<std::uint8_t*>& free = a.free_[index];
+	if (free.empty())
+		carve(node, index);
+	std::size_t count = static_cast<std::size_t>(cache_size_ / 2 > 0 ? cache_size_ / 2 : 1);
+	while (count-- > 0 && !free.empty()) {
+		cache.blocks_[index].push_back(free.back());
+		free.pop_back();
+	}
+}
+
+void net::buffer_pool::release(const int& node, const int& index,
+	std::vector<std::uint8_t*>& blocks, const std::size_t& count)
+{
+	arena& a = *arenas_[node];
+	std::lock_guard<std::mutex> lock(a.mutex_);
+	for (std::size_t i = 0; i < count && !blocks.empty(); ++i) {
+		a.free_[index].push_back(blocks.back());
+		blocks.pop_back();
+	}
+}
+
+void net::buffer_pool::carve(const int& node, const int& index)
+{
+	std::uint8_t* slab = static_cast<std::uint8_t*>(map_slab(node));
+	*reinterpret_cast<int*>(slab) = node;
+	std::size_t block_size = static_cast<std::size_t>(min_block_size) << index;
+	std::vector<std::uint8_t*>& free = arenas_[node]->free_[index];
+	// hand out low addresses first so untouched pages stay unbacked longer
+	std::size_t count = (slab_size - header_size) / block_size;
+	while (count-- > 0)
+		free.push_back(slab + header_size + count * block_size);
+}
+
+void* net::buffer_pool::map_slab(const int& node)
+{
+	void* slab = nullptr;
+#if defined(NET_LINUX)
+	bool huge_pages = get_huge_pages();
+	void* p = MAP_FAILED;
+	if (huge_pages)
+		p = ::mmap(nullptr, slab_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (p == MAP_FAILED) {
+		// map twice the size and trim it to an aligned slab
+		void* raw = ::mmap(nullptr, 2 * slab_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (raw == MAP_FAILED)
+			throw std::bad_alloc();
+		std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(raw);
+		std::uintptr_t aligned = (begin + slab_size - 1) &
+			~static_cast<std::uintptr_t>(slab_size - 1);
+		if (aligned > begin)
+			::munmap(raw, aligned - begin);
+		std::uintptr_t end = begin + 2 * slab_size;
+		if (end > aligned + slab_size)
+			::munmap(reinterpret_cast<void*>(aligned + slab_size),
+				end - (aligned + slab_size));
+		p = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+		if (huge_pages)
+			::madvise(p, slab_size, MADV_HUGEPAGE);	// transparent huge pages
+#endif
+	}
+	if (arenas_.size() > 1) {
+		// place the pages on the node of the arena whoever touches them
+		unsigned long mask = 1UL << node;
+		::syscall(SYS_mbind, p, slab_size, MPOL_PREFERRED, &mask,
+			sizeof(mask) * 8, 0);
+	}
+	slab = p;
+#else
+	(void) node;
+	slab = ::operator new(slab_size);
+#endif
+	std::lock_guard<std::mutex> lock(slabs_mutex_);
+	slabs_.push_back(slab);
+	reserved_bytes_.fetch_add(slab_size, std::memory_order_relaxed);
+	return slab;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.buffer_pool.inl"
+#endif
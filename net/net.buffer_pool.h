@@ -0,0 +1,129 @@
+#ifndef __NET_BUFFER_POOL__
+#define __NET_BUFFER_POOL__
+
+#include "net.config.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace net
+{
+	/**
+	* Allocates I/O buffers from size-classed slabs. Blocks of 512 bytes up
+	* to 64 KB are carved from 2 MB slabs, one arena per NUMA node, and each
+	* thread keeps a small cache of free blocks per size class so most
+	* allocations take no lock. Larger requests go to the heap.
+	*/
+	class buffer_pool
+	{
+	public:
+		/**
+		* Smallest and largest block sizes served from slabs.
+		*/
+		static const int min_block_size = 512;
+		static const int max_block_size = 65536;
+
+		/**
+		* Size and alignment of a slab.
+		*/
+		static const std::size_t slab_size = 2 * 1024 * 1024;
+	private:
+		static const int class_count = 8;
+		struct arena
+		{
+			std::mutex mutex_;
+			std::vector<std::uint8_t*> free_[class_count];
+		};
+		struct thread_cache
+		{
+			buffer_pool* owner_;
+			int node_;
+			std::vector<std::uint8_t*> blocks_[class_count];
+		public:
+			thread_cache(void);
+			~thread_cache(void);
+		};
+		std::vector<std::unique_ptr<arena>> arenas_;
+		std::mutex slabs_mutex_;
+		std::vector<void*> slabs_;
+		std::atomic<bool> huge_pages_;
+		std::atomic<std::uint64_t> reserved_bytes_;
+		int cache_size_;
+		static thread_local thread_cache cache_;
+	public:
+		/**
+		* Creates a pool whose threads cache up to cache_size free blocks
+		* per size class. With huge_pages the slabs are backed by huge pages
+		* where the platform provides them.
+		*/
+		buffer_pool(const bool& huge_pages = false, const int& cache_size = 32);
+	public:
+		virtual ~buffer_pool(void);
+	public:
+		/**
+		* Returns the pool used by socket streams. It is never destroyed, so
+		* threads may return cached blocks to it until the process exits.
+		* Other pools must outlive the threads which use them.
+		*/
+		static buffer_pool& get_default(void);
+
+		/**
+		* Returns the size of the block which serves a request of size bytes.
+		*/
+		static int get_block_size(const int& size);
+	public:
+		/**
+		* Returns a buffer of at least size bytes, preferably from the arena
+		* of the NUMA node the calling thread runs on.
+		*/
+		std::uint8_t* allocate(const int& size);
+
+		/**
+		* Returns a buffer obtained from allocate with the same size.
+		*/
+		void deallocate(std::uint8_t* buffer, const int& size);
+	public:
+		/**
+		* Enable/disable huge page backing for slabs mapped from now on.
+		*/
+		NET_INLINE void set_huge_pages(const bool& on);
+
+		/**
+		* Tests if slabs are backed by huge pages.
+		*/
+		NET_INLINE bool get_huge_pages(void) const;
+
+		/**
+		* Returns the number of NUMA nodes the pool keeps arenas for.
+		*/
+		NET_INLINE int get_node_count(void) const;
+
+		/**
+		* Returns the number of bytes reserved for slabs.
+		*/
+		NET_INLINE std::uint64_t get_reserved_bytes(void) const;
+	private:
+		static int get_class(const int& size);
+		int current_node(void) const;
+		static int count_nodes(void);
+		int node_of(const std::uint8_t* block) const;
+		void refill(thread_cache& cache, const int& index);
+		void release(const int& node, const int& index,
+			std::vector<std::uint8_t*>& blocks, const std::size_t& count);
+		void carve(const int& node, const int& index);
+		void* map_slab(const int& node);
+	private:
+		buffer_pool(const buffer_pool&);
+		buffer_pool& operator=(const buffer_pool&);
+		buffer_pool& operator=(const buffer_pool&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.buffer_pool.inl"
+#endif
+
+#endif
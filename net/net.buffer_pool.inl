@@ -0,0 +1,19 @@
+NET_INLINE void net::buffer_pool::set_huge_pages(const bool& on)
+{
+	huge_pages_.store(on, std::memory_order_relaxed);
+}
+
+NET_INLINE bool net::buffer_pool::get_huge_pages(void) const
+{
+	return huge_pages_.load(std::memory_order_relaxed);
+}
+
+NET_INLINE int net::buffer_pool::get_node_count(void) const
+{
+	return static_cast<int>(arenas_.size());
+}
+
+NET_INLINE std::uint64_t net::buffer_pool::get_reserved_bytes(void) const
+{
+	return reserved_bytes_.load(std::memory_order_relaxed);
+}
@@ -18,6 +18,14 @@
 #endif
 #endif
 
+#if defined(__linux__)
+#define NET_LINUX
+#endif
+
+#if defined(__cpp_impl_coroutine)
+#define NET_COROUTINES
+#endif
+
 #if defined(NET_LACKS_INLINE_FUNCTIONS) && !defined(NET_NO_INLINE)
 #define NET_NO_INLINE
 #endif
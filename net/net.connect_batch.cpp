@@ -0,0 +1,148 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "net.connect_batch.h"
+#include "net.error.h"
+#include "net.exceptions.h"
+#include "net.timer_wheel.h"
+
+net::connect_batch::connect_batch(const int& max_pending, const int& max_events)
+	: max_pending_(max_pending > 0 ? max_pending : 0)
+	, max_events_(max_events > 0 ? max_events : 256)
+{
+}
+
+net::connect_batch::~connect_batch(void)
+{
+}
+
+std::vector<net::connect_batch::result> net::connect_batch::connect(
+	const std::vector<endpoint>& targets, const int& timeout)
+{
+	std::vector<result> results(targets.size());
+	int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (epfd == -1)
+		throw socket_exception(sio::errno_exception("epoll_create1",
+			sio::socket_errno(errno)).what());
+
+	const std::uint64_t deadline = timeout > 0 ? timer_wheel::now_millis() + timeout : 0;
+	std::vector<struct epoll_event> events(max_events_);
+	std::size_t next = 0;
+	int pending = 0;
+	try {
+		for (;;) {
+			while (next < targets.size() && (max_pending_ == 0 || pending < max_pending_)) {
+				result& r = results[next];
+				if (start(targets[next], r)) {
+					struct epoll_event ev = {};
+					ev.events = EPOLLOUT;
+					ev.data.u64 = next;
+					if (::epoll_ctl(epfd, EPOLL_CTL_ADD,
+						r.sock_->get_impl()->get_native_socket(), &ev) == -1) {
+						r.ec_ = make_socket_error(sio::socket_errno(errno));
+						finish(r);
+					}
+					else
+						++pending;
+				}
+				++next;
+			}
+			if (pending == 0 && next == targets.size())
+				break;
+
+			int wait = -1;
+			if (deadline != 0) {
+				std::uint64_t now = timer_wheel::now_millis();
+				if (now >= deadline)
+					break;
+				wait = static_cast<int>(deadline - now);
+			}
+			int count = ::epoll_wait(epfd, events.data(), max_events_, wait);
+			if (count == -1) {
+				if (errno == EINTR)
+					continue;
+				throw socket_exception(sio::errno_exception("epoll_wait",
+					sio::socket_errno(errno)).what());
+			}
+			for (int i = 0; i < count; ++i) {
+				result& r = results[static_cast<std::size_t>(events[i].data.u64)];
+				::epoll_ctl(epfd, EPOLL_CTL_DEL, r.sock_->get_impl()->get_native_socket(),
+					nullptr);
+				--pending;
+				r.sock_->finish_connect(r.ec_);
+				finish(r);
+			}
+		}
+	}
+	catch (...) {
+		::close(epfd);
+		throw;
+	}
+	::close(epfd);
+
+	// what has not connected by the deadline, started or not, timed out
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		result& r = results[i];
+		if (i < next && r.ec_ != std::errc::operation_in_progress)
+			continue;
+		if (r.sock_ != nullptr) {
+			std::error_code ec;
+			r.sock_->close(ec);
+			r.sock_ = nullptr;
+		}
+		r.ec_ = make_socket_error(ETIMEDOUT);
+	}
+	return results;
+}
+
+std::vector<net::connect_batch::result> net::connect_batch::connect(
+	const std::vector<socket_address>& targets, const int& timeout)
+{
+	std::vector<endpoint> endpoints(targets.size());
+	for (std::size_t i = 0; i < targets.size(); ++i) {
+		std::shared_ptr<net_address> addr = targets[i].get_address();
+		if (addr != nullptr)
+			endpoints[i] = endpoint(ip_address(*addr), targets[i].get_port());
+	}
+	return connect(endpoints, timeout);
+}
+
+bool net::connect_batch::start(const endpoint& target, result& r)
+{
+	if (target.is_unspecified()) {
+		r.ec_ = make_socket_error(EDESTADDRREQ);
+		return false;
+	}
+	r.sock_ = std::make_shared<socket>();
+	// the descriptor exists once the socket is bound
+	r.sock_->bind(endpoint(ip_address::any(target.get_family()), 0), r.ec_);
+	if (!r.ec_)
+		r.sock_->set_non_blocking(true, r.ec_);
+	if (!r.ec_)
+		r.sock_->connect(target, 0, r.ec_);
+	if (r.ec_ == std::errc::operation_in_progress)
+		return true;
+	finish(r);
+	return false;
+}
+
+void net::connect_batch::finish(result& r)
+{
+	if (!r.ec_)
+		r.sock_->set_non_blocking(false, r.ec_);
+	if (r.ec_) {
+		std::error_code ec;
+		r.sock_->close(ec);
+		r.sock_ = nullptr;
+	}
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.connect_batch.inl"
+#endif
+
+#endif
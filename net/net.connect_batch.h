@@ -0,0 +1,92 @@
+#ifndef __NET_CONNECT_BATCH__
+#define __NET_CONNECT_BATCH__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include "net.endpoint.h"
+#include "net.socket.h"
+#include "net.socket_address.h"
+
+namespace net
+{
+	/**
+	* Connects to many peers at once. Every connect is started
+	* non-blocking and the handshakes complete together in one epoll set,
+	* so a fan-out to thousands of peers takes about as long as the
+	* slowest round trip rather than the sum of them.
+	*
+	* Sockets of the io_uring implementation connect on their ring one
+	* after the other instead.
+	*/
+	class connect_batch
+	{
+	public:
+		/**
+		* The outcome of connecting to one target: the connected socket,
+		* in blocking mode, or null and the error. A target which has no
+		* address fails with std::errc::destination_address_required, and
+		* one still connecting at the deadline with std::errc::timed_out.
+		*/
+		struct result
+		{
+			std::shared_ptr<socket> sock_;
+			std::error_code ec_;
+		};
+	private:
+		int max_pending_;
+		int max_events_;
+	public:
+		/**
+		* Creates a batch which keeps at most max_pending connects in
+		* flight, zero meaning no limit, to stay below the descriptor limit
+		* and the number of free ephemeral ports, and collects at most
+		* max_events completions per wakeup.
+		*/
+		connect_batch(const int& max_pending = 4096, const int& max_events = 256);
+	public:
+		virtual ~connect_batch(void);
+	public:
+		/**
+		* Connects to every target within timeout milliseconds, zero
+		* meaning no limit. Returns a result per target, in the order of
+		* targets.
+		*/
+		std::vector<result> connect(const std::vector<endpoint>& targets,
+			const int& timeout = 0);
+
+		/**
+		* Connects to every target within timeout milliseconds, zero
+		* meaning no limit. Targets are connected to the address they were
+		* resolved to.
+		*/
+		std::vector<result> connect(const std::vector<socket_address>& targets,
+			const int& timeout = 0);
+	public:
+		/**
+		* Returns the largest number of connects kept in flight, zero if
+		* there is no limit.
+		*/
+		NET_INLINE int get_max_pending(void) const;
+	private:
+		static bool start(const endpoint& target, result& r);
+		static void finish(result& r);
+	private:
+		connect_batch(const connect_batch&);
+		connect_batch& operator=(const connect_batch&);
+		connect_batch& operator=(const connect_batch&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.connect_batch.inl"
+#endif
+
+#endif
+
+#endif
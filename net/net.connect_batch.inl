@@ -0,0 +1,4 @@
+NET_INLINE int net::connect_batch::get_max_pending(void) const
+{
+	return max_pending_;
+}
@@ -0,0 +1,280 @@
+#include "net.connection_pool.h"
+#include "net.exceptions.h"
+
+#include <chrono>
+#include <vector>
+
+net::connection_pool::connection_pool(const int& max_per_host,
+	const int& idle_timeout, const int& connect_timeout)
+	: max_per_host_(max_per_host > 0 ? max_per_host : 1)
+	, idle_timeout_(idle_timeout)
+	, connect_timeout_(connect_timeout)
+	, is_closed_(false)
+	, mutex_()
+	, hosts_()
+	, in_use_()
+{
+}
+
+net::connection_pool::~connection_pool(void)
+{
+	close();
+}
+
+std::shared_ptr<net::socket> net::connection_pool::acquire(
+	const socket_address& addr, const int& timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	host& h = find_host(addr);
+	std::chrono::steady_clock::time_point deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	for (;;) {
+		if (is_closed_)
+			throw socket_exception("Connection pool is closed");
+		evict(h, now_millis(), false);
+		while (!h.idle_.empty()) {
+			// the most recently used connection is the least likely to be stale
+			std::shared_ptr<socket> sock = h.idle_.back().sock_;
+			h.idle_.pop_back();
+			if (is_reusable(sock)) {
+				in_use_[sock.get()] = &h;
+				return sock;
+			}
+			--h.open_;
+			sock->close();
+		}
+		if (h.open_ < max_per_host_) {
+			++h.open_;
+			lock.unlock();
+			std::shared_ptr<socket> sock;
+			try {
+				sock = connect(h);
+			}
+			catch (...) {
+				lock.lock();
+				--h.open_;
+				h.released_.notify_one();
+				throw;
+			}
+			lock.lock();
+			in_use_[sock.get()] = &h;
+			return sock;
+		}
+		if (timeout <= 0)
+			h.released_.wait(lock);
+		else if (h.released_.wait_until(lock, deadline) == std::cv_status::timeout &&
+				h.idle_.empty() && h.open_ >= max_per_host_)
+			throw socket_timeout_exception("No connection available");
+	}
+}
+
+void net::connection_pool::release(const std::shared_ptr<socket>& sock,
+	const bool& reusable)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	std::unordered_map<const socket*, host*>::iterator it = in_use_.find(sock.get());
+	if (it == in_use_.end())
+		throw socket_exception("Socket does not belong to the pool");
+	host& h = *it->second;
+	in_use_.erase(it);
+	if (is_closed_ || !reusable || sock->is_closed() || !sock->is_connected() ||
+			sock->is_input_shutdown() || sock->is_output_shutdown()) {
+		--h.open_;
+		h.released_.notify_one();
+		lock.unlock();
+		sock->close();
+		return;
+	}
+	sock->release_stream_buffers();	// idle connections hold no buffers
+	idle_connection c;
+	c.sock_ = sock;
+	c.since_ = now_millis();
+	h.idle_.push_back(c);
+	h.released_.notify_one();
+}
+
+void net::connection_pool::prewarm(const socket_address& addr,
+	const int& min_idle)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (is_closed_)
+		throw socket_exception("Connection pool is closed");
+	host& h = find_host(addr);
+	h.min_idle_ = min_idle < max_per_host_ ? min_idle : max_per_host_;
+	fill(lock, h);
+}
+
+int net::connection_pool::evict(void)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	std::uint64_t now = now_millis();
+	int closed = 0;
+	// hosts are never removed, but fill drops the lock and others may be added
+	std::vector<host*> hosts;
+	for (std::unordered_map<std::string, std::unique_ptr<host>>::iterator it =
+			hosts_.begin(); it != hosts_.end(); ++it) {
+		closed += evict(*it->second, now, true);
+		hosts.push_back(it->second.get());
+	}
+	for (std::size_t i = 0; i < hosts.size(); ++i) {
+		try {
+			fill(lock, *hosts[i]);
+		}
+		catch (const socket_exception&) {
+			// the host is unreachable for now, try again on the next call
+		}
+	}
+	return closed;
+}
+
+void net::connection_pool::close(void)
+{
+	std::deque<std::shared_ptr<socket>> closing;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		is_closed_ = true;
+		for (std::unordered_map<std::string, std::unique_ptr<host>>::iterator it =
+				hosts_.begin(); it != hosts_.end(); ++it) {
+			host& h = *it->second;
+			while (!h.idle_.empty()) {
+				closing.push_back(h.idle_.front().sock_);
+				h.idle_.pop_front();
+				--h.open_;
+			}
+			h.released_.notify_all();
+		}
+	}
+	for (std::size_t i = 0; i < closing.size(); ++i)
+		closing[i]->close();
+}
+
+std::size_t net::connection_pool::get_idle_count(void)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::size_t count = 0;
+	for (std::unordered_map<std::string, std::unique_ptr<host>>::iterator it =
+			hosts_.begin(); it != hosts_.end(); ++it)
+		count += it->second->idle_.size();
+	return count;
+}
+
+std::size_t net::connection_pool::get_open_count(void)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::size_t count = 0;
+	for (std::unordered_map<std::string, std::unique_ptr<host>>::iterator it =
+			hosts_.begin(); it != hosts_.end(); ++it)
+		count += static_cast<std::size_t>(it->second->open_);
+	return count;
+}
+
+net::connection_pool::host& net::connection_pool::find_host(
+	const socket_address& addr)
+{
+	std::string key = key_of(addr);
+	std::unique_ptr<host>& h = hosts_[key];
+	if (h == nullptr) {
+		h.reset(new host());
+		h->addr_ = addr;
+		h->open_ = 0;
+		h->min_idle_ = 0;
+	}
+	return *h;
+}
+
+std::shared_ptr<net::socket> net::connection_pool::connect(host& h)
+{
+	std::shared_ptr<socket> sock = std::make_shared<socket>();
+	sock->connect(h.addr_, connect_timeout_);
+	return sock;
+}
+
+void net::connection_pool::fill(std::unique_lock<std::mutex>& lock, host& h)
+{
+	// connections are made without the lock, count them as open meanwhile
+	while (!is_closed_ && static_cast<int>(h.idle_.size()) < h.min_idle_ &&
+			h.open_ < max_per_host_) {
+		++h.open_;
+		lock.unlock();
+		std::shared_ptr<socket> sock;
+		try {
+			sock = connect(h);
+		}
+		catch (...) {
+			lock.lock();
+			--h.open_;
+			throw;
+		}
+		lock.lock();
+		idle_connection c;
+		c.sock_ = sock;
+		c.since_ = now_millis();
+		h.idle_.push_back(c);
+		h.released_.notify_one();
+	}
+}
+
+int net::connection_pool::evict(host& h, const std::uint64_t& now,
+	const bool& probe)
+{
+	int closed = 0;
+	std::deque<idle_connection>::iterator it = h.idle_.begin();
+	while (it != h.idle_.end()) {
+		bool expired = idle_timeout_ > 0 &&
+			now - it->since_ >= static_cast<std::uint64_t>(idle_timeout_);
+		if (!expired && (!probe || is_reusable(it->sock_))) {
+			++it;
+			continue;
+		}
+		it->sock_->close();
+		it = h.idle_.erase(it);
+		--h.open_;
+		++closed;
+	}
+	if (closed > 0)
+		h.released_.notify_all();
+	return closed;
+}
+
+std::string net::connection_pool::key_of(const socket_address& addr)
+{
+	std::shared_ptr<net_address> a = addr.get_address();
+	if (a == nullptr)
+		throw unknown_host_exception(addr.get_host_name());
+	std::vector<std::uint8_t> bytes = a->get_address();
+	std::string key(bytes.begin(), bytes.end());
+	key.push_back(static_cast<char>(addr.get_port() >> 8));
+	key.push_back(static_cast<char>(addr.get_port() & 0xff));
+	return key;
+}
+
+bool net::connection_pool::is_reusable(const std::shared_ptr<socket>& sock)
+{
+	if (sock->is_closed() || !sock->is_connected() ||
+			sock->is_input_shutdown() || sock->is_output_shutdown())
+		return false;
+	// leftover input means the previous exchange was not read to the end
+	if (sock->get_stream()->in_avail() != 0)
+		return false;
+	sio::socket_t fd = sock->get_impl()->get_native_socket();
+#if defined(MSG_DONTWAIT)
+	char c;
+	if (::recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0)
+		return false;	// closed by the peer
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#else
+	// readable without pending bytes means end of stream or an error
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(fd, &readable);
+	struct timeval tv = { 0, 0 };
+	return ::select(static_cast<int>(fd) + 1, &readable, nullptr, nullptr, &tv) == 0;
+#endif
+}
+
+std::uint64_t net::connection_pool::now_millis(void)
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+}
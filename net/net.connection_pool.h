@@ -0,0 +1,116 @@
+#ifndef __NET_CONNECTION_POOL__
+#define __NET_CONNECTION_POOL__
+
+#include "net.config.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "net.socket.h"
+#include "net.socket_address.h"
+
+namespace net
+{
+	class connection_pool
+	{
+		struct idle_connection
+		{
+			std::shared_ptr<socket> sock_;
+			std::uint64_t since_;
+		};
+		struct host
+		{
+			socket_address addr_;
+			std::deque<idle_connection> idle_;
+			int open_;		// idle, in use and being connected
+			int min_idle_;
+			std::condition_variable released_;
+		};
+		int max_per_host_;
+		int idle_timeout_;
+		int connect_timeout_;
+		bool is_closed_;
+		std::mutex mutex_;
+		std::unordered_map<std::string, std::unique_ptr<host>> hosts_;
+		std::unordered_map<const socket*, host*> in_use_;
+	public:
+		/**
+		* Creates a pool which keeps at most max_per_host connections per
+		* remote address, closes connections idle for longer than
+		* idle_timeout milliseconds and connects with connect_timeout
+		* milliseconds, zero meaning no timeout.
+		*/
+		connection_pool(const int& max_per_host = 8, const int& idle_timeout = 60000,
+			const int& connect_timeout = 0);
+	public:
+		virtual ~connection_pool(void);
+	public:
+		/**
+		* Returns a connected socket to addr. An idle connection which is
+		* still open and has no unread data is reused, the most recently
+		* used first; otherwise a new connection is made unless max_per_host
+		* connections are open, in which case the call waits up to timeout
+		* milliseconds, zero meaning no limit, for one to be released.
+		* Throws socket_timeout_exception if none became available.
+		*/
+		std::shared_ptr<socket> acquire(const socket_address& addr,
+			const int& timeout = 0);
+
+		/**
+		* Hands a socket obtained from acquire back to the pool. Pass
+		* reusable as false if the exchange on it did not complete, the
+		* socket is then closed instead of being kept.
+		*/
+		void release(const std::shared_ptr<socket>& sock,
+			const bool& reusable = true);
+
+		/**
+		* Opens connections to addr until min_idle are idle and keeps
+		* that many ready from now on.
+		*/
+		void prewarm(const socket_address& addr, const int& min_idle);
+
+		/**
+		* Closes the connections which were idle for too long or were
+		* closed by the peer, and reopens connections for addresses which
+		* were prewarmed. Returns the number of connections closed. Call it
+		* periodically.
+		*/
+		int evict(void);
+
+		/**
+		* Closes all idle connections. Sockets still in use are closed when
+		* they are released.
+		*/
+		void close(void);
+	public:
+		/**
+		* Returns the number of idle connections.
+		*/
+		std::size_t get_idle_count(void);
+
+		/**
+		* Returns the number of open connections, idle or in use.
+		*/
+		std::size_t get_open_count(void);
+	private:
+		host& find_host(const socket_address& addr);
+		std::shared_ptr<socket> connect(host& h);
+		void fill(std::unique_lock<std::mutex>& lock, host& h);
+		int evict(host& h, const std::uint64_t& now, const bool& probe);
+		static std::string key_of(const socket_address& addr);
+		static bool is_reusable(const std::shared_ptr<socket>& sock);
+		static std::uint64_t now_millis(void);
+	private:
+		connection_pool(const connection_pool&);
+		connection_pool& operator=(const connection_pool&);
+		connection_pool& operator=(const connection_pool&&);
+	};
+}
+
+#endif
@@ -0,0 +1,430 @@
+#include <ios>
+#include <stdexcept>
+
+#include "net.datagram_socket.h"
+#include "net.error.h"
+#include "net.exceptions.h"
+#include "net.net4_address.h"
+#include "net.net6_address.h"
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#endif
+
+namespace
+{
+	void throw_socket_error(const char* call, const std::error_code& ec)
+	{
+		throw net::socket_exception(sio::errno_exception(call, ec.value()).what());
+	}
+
+	// what the throwing transfers return for a result of the error_code ones
+	int transferred(const char* call, const int& result, const std::error_code& ec,
+		const bool& non_blocking)
+	{
+		if (ec)
+			throw std::ios_base::failure(sio::errno_exception(call, ec.value()).what(), ec);
+		if (result == net::socket_impl::would_block && !non_blocking)
+			throw net::socket_timeout_exception(std::string(call) + " timed out");
+		return result;
+	}
+
+	net::endpoint endpoint_of(const net::socket_address& addr)
+	{
+		std::shared_ptr<net::net_address> a = addr.get_address();
+		if (a == nullptr)
+			throw net::unknown_host_exception(addr.get_host_name());
+		return net::endpoint(net::ip_address(*a), addr.get_port());
+	}
+}
+
+net::datagram_socket::datagram_socket(const bool& prefer_ipv6)
+	: impl_(std::make_shared<default_datagram_socket_impl>())
+	, is_bound_(false)
+	, is_connected_(false)
+	, is_closed_(false)
+{
+	impl_->create(prefer_ipv6 ? AF_INET6 : AF_INET);
+}
+
+net::datagram_socket::datagram_socket(const std::uint16_t& port,
+	const std::shared_ptr<net::net_address>& localaddr)
+	: datagram_socket(endpoint(ip_address(localaddr == nullptr ?
+		*net4_address::ANY : *localaddr), port))
+{
+}
+
+net::datagram_socket::datagram_socket(const endpoint& local)
+	: impl_(std::make_shared<default_datagram_socket_impl>())
+	, is_bound_(false)
+	, is_connected_(false)
+	, is_closed_(false)
+{
+	if (local.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+	impl_->create(local.get_family());
+	try {
+		bind(local);
+	}
+	catch (const socket_exception&) {
+		impl_->close();
+		throw;
+	}
+}
+
+net::datagram_socket::~datagram_socket(void)
+{
+}
+
+void net::datagram_socket::bind(const socket_address& localaddr)
+{
+	bind(endpoint_of(localaddr));
+}
+
+void net::datagram_socket::bind(const endpoint& localaddr)
+{
+	check_open();
+	if (is_bound())
+		throw socket_exception("Socket is already bound");
+	std::error_code ec;
+	impl_->bind(localaddr, ec);
+	if (ec)
+		throw_socket_error("bind", ec);
+	is_bound_ = true;
+}
+
+void net::datagram_socket::connect(const socket_address& remoteaddr)
+{
+	connect(endpoint_of(remoteaddr));
+}
+
+void net::datagram_socket::connect(const endpoint& remoteaddr)
+{
+	if (remoteaddr.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+	check_open();
+	std::error_code ec;
+	impl_->connect(remoteaddr, 0, ec);
+	if (ec)
+		throw_socket_error("connect", ec);
+	is_connected_ = true;
+}
+
+void net::datagram_socket::close(void)
+{
+	is_closed_ = true;
+	impl_->close();
+}
+
+int net::datagram_socket::send_to(const std::uint8_t* buffer, const int& nbytes,
+	const socket_address& remote)
+{
+	return send_to(buffer, nbytes, endpoint_of(remote));
+}
+
+int net::datagram_socket::send_to(const std::uint8_t* buffer, const int& nbytes,
+	const endpoint& remote)
+{
+	if (remote.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+	check_open();
+	std::error_code ec;
+	int sent = impl_->send_to(buffer, nbytes, remote, ec);
+	return transferred("send", sent, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::send(const std::uint8_t* buffer, const int& nbytes)
+{
+	check_open();
+	if (!is_connected())
+		throw socket_exception("Socket is not connected");
+	std::error_code ec;
+	int sent = impl_->send_to(buffer, nbytes, endpoint(), ec);
+	return transferred("send", sent, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::receive_from(std::uint8_t* buffer, const int& nbytes,
+	endpoint& remote)
+{
+	check_open();
+	std::error_code ec;
+	int received = impl_->receive_from(buffer, nbytes, remote, ec);
+	return transferred("recv", received, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::receive(std::uint8_t* buffer, const int& nbytes)
+{
+	endpoint remote;
+	return receive_from(buffer, nbytes, remote);
+}
+
+int net::datagram_socket::send_many(datagram* msgs, const int& count)
+{
+	check_open();
+	std::error_code ec;
+	int sent = impl_->send_many(msgs, count, ec);
+	return transferred("send", sent, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::receive_many(datagram* msgs, const int& count)
+{
+	check_open();
+	std::error_code ec;
+	int received = impl_->receive_many(msgs, count, ec);
+	return transferred("recv", received, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::send_segments(const std::uint8_t* buffer, const int& nbytes,
+	const int& segment_size, const endpoint& remote)
+{
+	if (remote.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+	if (segment_size < 1)
+		throw std::invalid_argument("segment_size < 1");
+	check_open();
+	std::error_code ec;
+	int sent = impl_->send_segments(buffer, nbytes, segment_size, remote, ec);
+	return transferred("send", sent, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::send_segments(const std::uint8_t* buffer, const int& nbytes,
+	const int& segment_size)
+{
+	if (segment_size < 1)
+		throw std::invalid_argument("segment_size < 1");
+	check_open();
+	if (!is_connected())
+		throw socket_exception("Socket is not connected");
+	std::error_code ec;
+	int sent = impl_->send_segments(buffer, nbytes, segment_size, endpoint(), ec);
+	return transferred("send", sent, ec, impl_->is_non_blocking());
+}
+
+int net::datagram_socket::receive_segments(std::uint8_t* buffer, const int& nbytes,
+	endpoint& remote, int& segment_size)
+{
+	check_open();
+	std::error_code ec;
+	int received = impl_->receive_segments(buffer, nbytes, remote, segment_size, ec);
+	return transferred("recv", received, ec, impl_->is_non_blocking());
+}
+
+bool net::datagram_socket::is_non_blocking(void) const
+{
+	return impl_->is_non_blocking();
+}
+
+void net::datagram_socket::set_non_blocking(const bool& on)
+{
+	check_open();
+	std::error_code ec;
+	impl_->set_non_blocking(on, ec);
+	if (ec)
+		throw_socket_error("set_non_blocking", ec);
+}
+
+int net::datagram_socket::send_to(const std::uint8_t* buffer, const int& nbytes,
+	const endpoint& remote, std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->send_to(buffer, nbytes, remote, ec);
+}
+
+int net::datagram_socket::receive_from(std::uint8_t* buffer, const int& nbytes,
+	endpoint& remote, std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->receive_from(buffer, nbytes, remote, ec);
+}
+
+int net::datagram_socket::send_many(datagram* msgs, const int& count,
+	std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->send_many(msgs, count, ec);
+}
+
+int net::datagram_socket::receive_many(datagram* msgs, const int& count,
+	std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->receive_many(msgs, count, ec);
+}
+
+int net::datagram_socket::send_segments(const std::uint8_t* buffer, const int& nbytes,
+	const int& segment_size, const endpoint& remote, std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->send_segments(buffer, nbytes, segment_size, remote, ec);
+}
+
+int net::datagram_socket::receive_segments(std::uint8_t* buffer, const int& nbytes,
+	endpoint& remote, int& segment_size, std::error_code& ec) noexcept
+{
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return socket_impl::failed;
+	}
+	return impl_->receive_segments(buffer, nbytes, remote, segment_size, ec);
+}
+
+int net::datagram_socket::get_receive_buffer_size(void)
+{
+	return get_option(SOL_SOCKET, SO_RCVBUF);
+}
+
+void net::datagram_socket::set_receive_buffer_size(const int& size)
+{
+	if (size < 1)
+		throw std::invalid_argument("size < 1");
+	set_option(SOL_SOCKET, SO_RCVBUF, size);
+}
+
+int net::datagram_socket::get_send_buffer_size(void)
+{
+	return get_option(SOL_SOCKET, SO_SNDBUF);
+}
+
+void net::datagram_socket::set_send_buffer_size(const int& size)
+{
+	if (size < 1)
+		throw std::invalid_argument("size < 1");
+	set_option(SOL_SOCKET, SO_SNDBUF, size);
+}
+
+int net::datagram_socket::get_receive_timeout(void)
+{
+	return get_option(SOL_SOCKET, SO_RCVTIMEO);
+}
+
+void net::datagram_socket::set_receive_timeout(const int& timeout)
+{
+	if (timeout < 0)
+		throw std::invalid_argument("timeout < 0");
+	set_option(SOL_SOCKET, SO_RCVTIMEO, timeout);
+}
+
+bool net::datagram_socket::get_reuse_address(void)
+{
+	return get_option(SOL_SOCKET, SO_REUSEADDR) != 0;
+}
+
+void net::datagram_socket::set_reuse_address(const bool& reuse)
+{
+	set_option(SOL_SOCKET, SO_REUSEADDR, reuse ? 1 : 0);
+}
+
+bool net::datagram_socket::get_broadcast(void)
+{
+	return get_option(SOL_SOCKET, SO_BROADCAST) != 0;
+}
+
+void net::datagram_socket::set_broadcast(const bool& on)
+{
+	set_option(SOL_SOCKET, SO_BROADCAST, on ? 1 : 0);
+}
+
+bool net::datagram_socket::get_udp_gro(void)
+{
+#if defined(NET_LINUX)
+	return get_option(SOL_UDP, UDP_GRO) != 0;
+#else
+	return false;
+#endif
+}
+
+void net::datagram_socket::set_udp_gro(const bool& on)
+{
+#if defined(NET_LINUX)
+	set_option(SOL_UDP, UDP_GRO, on ? 1 : 0);
+#else
+	if (on)
+		throw_socket_error("setsockopt", make_socket_error(EOPNOTSUPP));
+#endif
+}
+
+net::endpoint net::datagram_socket::get_local_endpoint(void) const
+{
+	if (is_closed())
+		return endpoint();
+	if (!impl_->get_local_endpoint().is_unspecified())
+		return impl_->get_local_endpoint();
+	// the system binds an unbound socket on its first send
+	endpoint local;
+	socklen_t salen = endpoint::capacity();
+	if (::getsockname(impl_->get_native_socket(), local.data(), &salen) != 0
+		|| local.get_port() == 0)
+		return endpoint();
+	return local;
+}
+
+std::uint16_t net::datagram_socket::get_local_port(void) const
+{
+	return get_local_endpoint().get_port();
+}
+
+net::endpoint net::datagram_socket::get_remote_endpoint(void) const
+{
+	if (!is_connected())
+		return endpoint();
+	return impl_->get_remote_endpoint();
+}
+
+bool net::datagram_socket::is_bound(void) const
+{
+	return is_bound_ || !get_local_endpoint().is_unspecified();
+}
+
+bool net::datagram_socket::is_connected(void) const
+{
+	return is_connected_;
+}
+
+bool net::datagram_socket::is_closed(void) const
+{
+	return is_closed_;
+}
+
+void net::datagram_socket::check_open(void) const
+{
+	if (is_closed())
+		throw socket_exception("Socket is closed");
+}
+
+int net::datagram_socket::get_option(const int& level, const int& id)
+{
+	check_open();
+	std::error_code ec;
+	int value = impl_->get_option_int(level, id, ec);
+	if (ec)
+		throw_socket_error("getsockopt", ec);
+	return value;
+}
+
+void net::datagram_socket::set_option(const int& level, const int& id, const int& value)
+{
+	check_open();
+	std::error_code ec;
+	impl_->set_option_int(level, id, value, ec);
+	if (ec)
+		throw_socket_error("setsockopt", ec);
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.datagram_socket.inl"
+#endif
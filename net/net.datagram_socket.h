@@ -0,0 +1,253 @@
+#ifndef __NET_DATAGRAM_SOCKET__
+#define __NET_DATAGRAM_SOCKET__
+
+#include <memory>
+#include <system_error>
+
+#include "net.default_datagram_socket_impl.h"
+#include "net.endpoint.h"
+#include "net.net_address.h"
+#include "net.socket_address.h"
+
+namespace net
+{
+	/**
+	* A UDP socket. Datagrams are sent to and received from any peer, or
+	* only the peer the socket is connected to. send_many and
+	* receive_many move a batch of datagrams described by a caller-owned
+	* array with a single system call on Linux, so the datagram rate is
+	* not bound by the cost of a call per datagram.
+	*
+	* For bulk transfers to one peer, send_segments hands the kernel up
+	* to 64 datagrams of equal size as one buffer, and with UDP GRO
+	* enabled receive_segments returns consecutive datagrams of one
+	* sender coalesced, so the stack is traversed once per run rather
+	* than once per datagram on both sides.
+	*
+	* Failures throw std::ios_base::failure for transfers and
+	* socket_exception otherwise; a receive timeout on a blocking socket
+	* throws socket_timeout_exception. A non-blocking socket returns
+	* socket_impl::would_block instead of waiting.
+	*/
+	class datagram_socket
+	{
+		std::shared_ptr<default_datagram_socket_impl> impl_;
+		volatile bool is_bound_;
+		volatile bool is_connected_;
+		volatile bool is_closed_;
+	public:
+		/**
+		* Creates an unbound socket. The system binds it to an ephemeral
+		* port on the first send.
+		*/
+		datagram_socket(const bool& prefer_ipv6 = false);
+
+		/**
+		* Creates a socket bound to the given local address and port. If
+		* localaddr is null, the ANY address is used. If port is zero, a
+		* port will be assigned by the OS.
+		*/
+		datagram_socket(const std::uint16_t& port,
+			const std::shared_ptr<net_address>& localaddr);
+
+		/**
+		* Creates a socket bound to a local endpoint.
+		*/
+		explicit datagram_socket(const endpoint& local);
+	public:
+		virtual ~datagram_socket(void);
+	public:
+		/**
+		* Binds the socket to a local address.
+		*/
+		virtual void bind(const socket_address& localaddr);
+		virtual void bind(const endpoint& localaddr);
+
+		/**
+		* Connects the socket to a peer: send() goes to it and only its
+		* datagrams are received. Nothing is sent.
+		*/
+		virtual void connect(const socket_address& remoteaddr);
+		virtual void connect(const endpoint& remoteaddr);
+
+		/**
+		* Closes this socket.
+		*/
+		virtual void close(void);
+	public:
+		/**
+		* Sends nbytes of buffer as one datagram to remote. Returns the
+		* number of bytes sent or socket_impl::would_block.
+		*/
+		virtual int send_to(const std::uint8_t* buffer, const int& nbytes,
+			const socket_address& remote);
+		virtual int send_to(const std::uint8_t* buffer, const int& nbytes,
+			const endpoint& remote);
+
+		/**
+		* Sends nbytes of buffer as one datagram to the connected peer.
+		*/
+		virtual int send(const std::uint8_t* buffer, const int& nbytes);
+
+		/**
+		* Receives one datagram into buffer, truncated to nbytes, and its
+		* sender into remote. Returns the number of bytes received or
+		* socket_impl::would_block.
+		*/
+		virtual int receive_from(std::uint8_t* buffer, const int& nbytes,
+			endpoint& remote);
+
+		/**
+		* Receives one datagram into buffer, truncated to nbytes.
+		*/
+		virtual int receive(std::uint8_t* buffer, const int& nbytes);
+
+		/**
+		* Sends the count datagrams of msgs in order and sets their length.
+		* Returns the number of datagrams sent, less than count if the send
+		* buffer of a non-blocking socket filled up, or
+		* socket_impl::would_block if none could be sent.
+		*/
+		virtual int send_many(datagram* msgs, const int& count);
+
+		/**
+		* Waits for a datagram and receives it and those queued behind it,
+		* up to count, into msgs. Returns the number of datagrams received
+		* or socket_impl::would_block.
+		*/
+		virtual int receive_many(datagram* msgs, const int& count);
+
+		/**
+		* Sends nbytes of buffer to remote as datagrams of segment_size
+		* bytes, the last one shorter if nbytes is not a multiple of it,
+		* using UDP segmentation offload on Linux. Returns the number of
+		* bytes sent, less than nbytes if the send buffer of a
+		* non-blocking socket filled up, or socket_impl::would_block.
+		*/
+		virtual int send_segments(const std::uint8_t* buffer, const int& nbytes,
+			const int& segment_size, const endpoint& remote);
+
+		/**
+		* Sends nbytes of buffer to the connected peer as datagrams of
+		* segment_size bytes.
+		*/
+		virtual int send_segments(const std::uint8_t* buffer, const int& nbytes,
+			const int& segment_size);
+
+		/**
+		* Receives into buffer one datagram, or consecutive datagrams of one
+		* sender which the kernel coalesced once set_udp_gro(true) was
+		* called. The payload splits into datagrams at every segment_size
+		* bytes, the last being shorter; a single datagram sets
+		* segment_size to its length. buffer should hold 65535 bytes.
+		* Returns the number of bytes received or socket_impl::would_block.
+		*/
+		virtual int receive_segments(std::uint8_t* buffer, const int& nbytes,
+			endpoint& remote, int& segment_size);
+
+		/**
+		* Tests if the socket is in non-blocking mode.
+		*/
+		virtual bool is_non_blocking(void) const;
+
+		/**
+		* Enable/disable non-blocking mode.
+		*/
+		virtual void set_non_blocking(const bool& on);
+	public:
+		/**
+		* The overloads below report failures in ec instead of throwing, and
+		* clear it on success, as those of net::socket do. Transfers return
+		* socket_impl::failed when they set ec.
+		*/
+		virtual int send_to(const std::uint8_t* buffer, const int& nbytes,
+			const endpoint& remote, std::error_code& ec) noexcept;
+		virtual int receive_from(std::uint8_t* buffer, const int& nbytes,
+			endpoint& remote, std::error_code& ec) noexcept;
+		virtual int send_many(datagram* msgs, const int& count,
+			std::error_code& ec) noexcept;
+		virtual int receive_many(datagram* msgs, const int& count,
+			std::error_code& ec) noexcept;
+		virtual int send_segments(const std::uint8_t* buffer, const int& nbytes,
+			const int& segment_size, const endpoint& remote, std::error_code& ec) noexcept;
+		virtual int receive_segments(std::uint8_t* buffer, const int& nbytes,
+			endpoint& remote, int& segment_size, std::error_code& ec) noexcept;
+	public:
+		/**
+		* Gets and sets SO_RCVBUF, which bounds the datagrams queued for
+		* receive_many; bursts beyond it are dropped by the kernel.
+		*/
+		virtual int get_receive_buffer_size(void);
+		virtual void set_receive_buffer_size(const int& size);
+
+		/**
+		* Gets and sets SO_SNDBUF.
+		*/
+		virtual int get_send_buffer_size(void);
+		virtual void set_send_buffer_size(const int& size);
+
+		/**
+		* Gets and sets the receive timeout in milliseconds, zero meaning
+		* none.
+		*/
+		virtual int get_receive_timeout(void);
+		virtual void set_receive_timeout(const int& timeout);
+
+		/**
+		* Tests and enables/disables SO_REUSEADDR.
+		*/
+		virtual bool get_reuse_address(void);
+		virtual void set_reuse_address(const bool& reuse);
+
+		/**
+		* Tests and enables/disables sending to broadcast addresses.
+		*/
+		virtual bool get_broadcast(void);
+		virtual void set_broadcast(const bool& on);
+
+		/**
+		* Tests and enables/disables UDP_GRO, which lets the kernel coalesce
+		* datagrams for receive_segments. Other receives then get the
+		* coalesced payload too. Not supported outside Linux.
+		*/
+		virtual bool get_udp_gro(void);
+		virtual void set_udp_gro(const bool& on);
+	public:
+		/**
+		* Returns the endpoint this socket is bound to, or an unspecified
+		* endpoint if it is not bound yet.
+		*/
+		virtual endpoint get_local_endpoint(void) const;
+
+		/**
+		* Returns the local port number, zero if the socket is not bound.
+		*/
+		virtual std::uint16_t get_local_port(void) const;
+
+		/**
+		* Returns the endpoint this socket is connected to, or an
+		* unspecified endpoint if it is unconnected.
+		*/
+		virtual endpoint get_remote_endpoint(void) const;
+	public:
+		virtual bool is_bound(void) const;
+		virtual bool is_connected(void) const;
+		virtual bool is_closed(void) const;
+	public:
+		NET_INLINE std::shared_ptr<default_datagram_socket_impl>& get_impl(void);
+	protected:
+		void check_open(void) const;
+		int get_option(const int& level, const int& id);
+		void set_option(const int& level, const int& id, const int& value);
+	private:
+		datagram_socket(const datagram_socket&);
+		datagram_socket& operator=(const datagram_socket&);
+		datagram_socket& operator=(const datagram_socket&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.datagram_socket.inl"
+#endif
+
+#endif
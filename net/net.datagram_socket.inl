@@ -0,0 +1,5 @@
+NET_INLINE std::shared_ptr<net::default_datagram_socket_impl>&
+net::datagram_socket::get_impl(void)
+{
+	return impl_;
+}
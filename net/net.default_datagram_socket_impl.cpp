@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <cstring>
+
+#include "net.default_datagram_socket_impl.h"
+#include "net.error.h"
+#include "net.exceptions.h"
+
+namespace
+{
+	// largest UDP payload over IPv4; a run of segments is one datagram
+	// to the kernel until it splits it
+	const int max_payload = 65507;
+}
+
+// limits are passed by reference, which needs their definitions
+const int net::default_datagram_socket_impl::max_segments;
+
+net::default_datagram_socket_impl::default_datagram_socket_impl(void)
+	: default_socket_impl()
+#if defined(NET_LINUX)
+	, send_headers_()
+	, send_vectors_()
+	, receive_headers_()
+	, receive_vectors_()
+	, controls_()
+	, segmentation_(true)
+#else
+	, segmentation_(false)
+#endif
+	, count_drops_(false)
+	, dropped_(0)
+{
+}
+
+net::default_datagram_socket_impl::~default_datagram_socket_impl(void)
+{
+}
+
+void net::default_datagram_socket_impl::create(const int& family)
+{
+	try {
+		sock_ = sio::socket(family, SOCK_DGRAM, 0);
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+}
+
+void net::default_datagram_socket_impl::create(const int& family,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	sio::socket_t sock = ::socket(family, SOCK_DGRAM, 0);
+	if (sock == sio::invalid_socket) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	sock_ = sock;
+}
+
+int net::default_datagram_socket_impl::send_to(const std::uint8_t* buffer,
+	const int& nbytes, const endpoint& remote, std::error_code& ec) noexcept
+{
+	ec.clear();
+	for (;;) {
+		int sent = remote.is_unspecified() ?
+			(int) ::send(sock_, (const char*) buffer, nbytes, 0) :
+			(int) ::sendto(sock_, (const char*) buffer, nbytes, 0, remote.data(),
+				remote.size());
+		if (sent >= 0)
+			return sent;
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+int net::default_datagram_socket_impl::receive_from(std::uint8_t* buffer,
+	const int& nbytes, endpoint& remote, std::error_code& ec) noexcept
+{
+#if defined(NET_LINUX)
+	// the drop count comes with the datagram as control data
+	if (count_drops_) {
+		int segment_size = 0;
+		return receive_segments(buffer, nbytes, remote, segment_size, ec);
+	}
+#endif
+	ec.clear();
+	for (;;) {
+		socklen_t salen = endpoint::capacity();
+		remote = endpoint();
+		int count = (int) ::recvfrom(sock_, (char*) buffer, nbytes, 0, remote.data(),
+			&salen);
+		if (count >= 0)
+			return count;
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+int net::default_datagram_socket_impl::send_many(datagram* msgs, const int& count,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (count <= 0)
+		return 0;
+#if defined(NET_LINUX)
+	if (send_headers_.size() < static_cast<std::size_t>(count)) {
+		send_headers_.resize(count);
+		send_vectors_.resize(count);
+	}
+	for (int i = 0; i < count; ++i) {
+		send_vectors_[i].iov_base = msgs[i].buffer;
+		send_vectors_[i].iov_len = static_cast<std::size_t>(msgs[i].nbytes);
+		struct msghdr& h = send_headers_[i].msg_hdr;
+		h = msghdr();
+		if (!msgs[i].peer.is_unspecified()) {
+			h.msg_name = msgs[i].peer.data();
+			h.msg_namelen = msgs[i].peer.size();
+		}
+		h.msg_iov = &send_vectors_[i];
+		h.msg_iovlen = 1;
+	}
+	for (;;) {
+		int sent = ::sendmmsg(sock_, send_headers_.data(), static_cast<unsigned int>(count), 0);
+		if (sent >= 0) {
+			for (int i = 0; i < sent; ++i)
+				msgs[i].length = static_cast<int>(send_headers_[i].msg_len);
+			return sent;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+#else
+	for (int i = 0; i < count; ++i) {
+		int sent = send_to(msgs[i].buffer, msgs[i].nbytes, msgs[i].peer, ec);
+		if (sent < 0) {
+			// report what was sent; the failure recurs on the next call
+			if (i > 0)
+				ec.clear();
+			return i > 0 ? i : sent;
+		}
+		msgs[i].length = sent;
+	}
+	return count;
+#endif
+}
+
+int net::default_datagram_socket_impl::receive_many(datagram* msgs, const int& count,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (count <= 0)
+		return 0;
+#if defined(NET_LINUX)
+	if (receive_headers_.size() < static_cast<std::size_t>(count)) {
+		receive_headers_.resize(count);
+		receive_vectors_.resize(count);
+	}
+	const std::size_t space = CMSG_SPACE(sizeof(std::uint32_t));
+	if (count_drops_ && controls_.size() < count * space)
+		controls_.resize(count * space);
+	for (int i = 0; i < count; ++i) {
+		receive_vectors_[i].iov_base = msgs[i].buffer;
+		receive_vectors_[i].iov_len = static_cast<std::size_t>(msgs[i].nbytes);
+		msgs[i].peer = endpoint();
+		struct msghdr& h = receive_headers_[i].msg_hdr;
+		h = msghdr();
+		h.msg_name = msgs[i].peer.data();
+		h.msg_namelen = endpoint::capacity();
+		h.msg_iov = &receive_vectors_[i];
+		h.msg_iovlen = 1;
+		if (count_drops_) {
+			h.msg_control = &controls_[i * space];
+			h.msg_controllen = space;
+		}
+	}
+	for (;;) {
+		// block for the first datagram only, then take what is queued
+		int received = ::recvmmsg(sock_, receive_headers_.data(), static_cast<unsigned int>(count),
+			MSG_WAITFORONE, nullptr);
+		if (received >= 0) {
+			for (int i = 0; i < received; ++i) {
+				msgs[i].length = static_cast<int>(receive_headers_[i].msg_len);
+				msgs[i].truncated = (receive_headers_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+				if (count_drops_)
+					read_drops(receive_headers_[i].msg_hdr);
+			}
+			return received;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+#else
+	int received = 0;
+	while (received < count && (received == 0 || non_blocking_)) {
+		datagram& msg = msgs[received];
+		int length = receive_from(msg.buffer, msg.nbytes, msg.peer, ec);
+		if (length < 0) {
+			if (received > 0)
+				ec.clear();
+			return received > 0 ? received : length;
+		}
+		msg.length = length;
+		msg.truncated = false;
+		++received;
+	}
+	return received;
+#endif
+}
+
+int net::default_datagram_socket_impl::send_segments(const std::uint8_t* buffer,
+	const int& nbytes, const int& segment_size, const endpoint& remote,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (segment_size <= 0 || nbytes < 0) {
+		ec = make_socket_error(EINVAL);
+		return failed;
+	}
+	const int run = std::max(1, std::min(max_segments, max_payload / segment_size))
+		* segment_size;
+	int total = 0;
+	while (total < nbytes) {
+		int length = std::min(nbytes - total, run);
+		int sent = send_segment_run(buffer + total, length, segment_size, remote, ec);
+		if (sent < 0) {
+			// report what was sent; the failure recurs on the next call
+			if (total > 0)
+				ec.clear();
+			return total > 0 ? total : sent;
+		}
+		total += sent;
+		if (sent < length)
+			break;
+	}
+	return total;
+}
+
+int net::default_datagram_socket_impl::receive_segments(std::uint8_t* buffer,
+	const int& nbytes, endpoint& remote, int& segment_size, std::error_code& ec) noexcept
+{
+	ec.clear();
+	segment_size = 0;
+#if defined(NET_LINUX)
+	struct iovec v;
+	v.iov_base = buffer;
+	v.iov_len = static_cast<std::size_t>(nbytes);
+	union
+	{
+		char buffer_[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(std::uint32_t))];
+		struct cmsghdr align_;
+	} control;
+	for (;;) {
+		remote = endpoint();
+		struct msghdr h = msghdr();
+		h.msg_name = remote.data();
+		h.msg_namelen = endpoint::capacity();
+		h.msg_iov = &v;
+		h.msg_iovlen = 1;
+		h.msg_control = control.buffer_;
+		h.msg_controllen = sizeof(control.buffer_);
+		int count = (int) ::recvmsg(sock_, &h, 0);
+		if (count >= 0) {
+			segment_size = count;
+			for (struct cmsghdr* cm = CMSG_FIRSTHDR(&h); cm != nullptr; cm = CMSG_NXTHDR(&h, cm)) {
+				if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+					std::memcpy(&segment_size, CMSG_DATA(cm), sizeof(segment_size));
+			}
+			if (count_drops_)
+				read_drops(h);
+			return count;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+#else
+	int count = receive_from(buffer, nbytes, remote, ec);
+	if (count >= 0)
+		segment_size = count;
+	return count;
+#endif
+}
+
+void net::default_datagram_socket_impl::set_drop_counting(const bool& on,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+#if defined(NET_LINUX)
+	set_option_int(SOL_SOCKET, SO_RXQ_OVFL, on ? 1 : 0, ec);
+	if (!ec)
+		count_drops_ = on;
+#else
+	if (on)
+		ec = make_socket_error(EOPNOTSUPP);
+#endif
+}
+
+std::uint32_t net::default_datagram_socket_impl::get_dropped(void) const
+{
+	return dropped_;
+}
+
+#if defined(NET_LINUX)
+void net::default_datagram_socket_impl::read_drops(struct msghdr& h)
+{
+	// the count comes only once the kernel dropped something, and never
+	// decreases but by wrapping
+	for (struct cmsghdr* cm = CMSG_FIRSTHDR(&h); cm != nullptr; cm = CMSG_NXTHDR(&h, cm)) {
+		if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SO_RXQ_OVFL)
+			std::memcpy(&dropped_, CMSG_DATA(cm), sizeof(dropped_));
+	}
+}
+#endif
+
+int net::default_datagram_socket_impl::send_segment_run(const std::uint8_t* buffer,
+	const int& nbytes, const int& segment_size, const endpoint& remote,
+	std::error_code& ec) noexcept
+{
+#if defined(NET_LINUX)
+	if (segmentation_ && nbytes > segment_size) {
+		struct iovec v;
+		v.iov_base = const_cast<std::uint8_t*>(buffer);
+		v.iov_len = static_cast<std::size_t>(nbytes);
+		union
+		{
+			char buffer_[CMSG_SPACE(sizeof(std::uint16_t))];
+			struct cmsghdr align_;
+		} control;
+		std::memset(&control, 0, sizeof(control));
+		struct msghdr h = msghdr();
+		if (!remote.is_unspecified()) {
+			h.msg_name = const_cast<sio::sockaddr_t*>(remote.data());
+			h.msg_namelen = remote.size();
+		}
+		h.msg_iov = &v;
+		h.msg_iovlen = 1;
+		h.msg_control = control.buffer_;
+		h.msg_controllen = sizeof(control.buffer_);
+		struct cmsghdr* cm = CMSG_FIRSTHDR(&h);
+		cm->cmsg_level = SOL_UDP;
+		cm->cmsg_type = UDP_SEGMENT;
+		cm->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+		std::uint16_t size = static_cast<std::uint16_t>(segment_size);
+		std::memcpy(CMSG_DATA(cm), &size, sizeof(size));
+		for (;;) {
+			int sent = (int) ::sendmsg(sock_, &h, 0);
+			if (sent >= 0)
+				return sent;
+			int error = last_error();
+			if (error == EINTR)
+				continue;
+			if (is_would_block(error))
+				return would_block;
+			// the kernel or the device cannot segment: stop trying
+			if (error == EIO || error == ENOPROTOOPT || error == EOPNOTSUPP) {
+				segmentation_ = false;
+				break;
+			}
+			// segments larger than the path MTU are sent as datagrams, which
+			// the stack fragments
+			if (error == EINVAL || error == EMSGSIZE)
+				break;
+			ec = make_socket_error(error);
+			return failed;
+		}
+	}
+#endif
+	datagram msgs[max_segments];
+	int count = 0;
+	for (int offset = 0; offset < nbytes; offset += segment_size) {
+		datagram& msg = msgs[count++];
+		msg.buffer = const_cast<std::uint8_t*>(buffer) + offset;
+		msg.nbytes = std::min(segment_size, nbytes - offset);
+		msg.length = 0;
+		msg.peer = remote;
+		msg.truncated = false;
+	}
+	int sent = send_many(msgs, count, ec);
+	if (sent < 0)
+		return sent;
+	int bytes = 0;
+	for (int i = 0; i < sent; ++i)
+		bytes += msgs[i].length;
+	return bytes;
+}
@@ -0,0 +1,147 @@
+#ifndef __NET_DEFAULT_DATAGRAM_SOCKET_IMPL__
+#define __NET_DEFAULT_DATAGRAM_SOCKET_IMPL__
+
+#include <vector>
+
+#include "net.default_socket_impl.h"
+#include "net.socket_impl.h"
+
+#if defined(NET_LINUX)
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#if !defined(UDP_GRO)
+#define UDP_GRO 104
+#endif
+#if !defined(SO_RXQ_OVFL)
+#define SO_RXQ_OVFL 40
+#endif
+#endif
+
+namespace net
+{
+	/**
+	* A socket_impl of SOCK_DGRAM sockets. Binding, connecting to a
+	* default peer, blocking mode and options are those of
+	* default_socket_impl; the calls below move datagrams.
+	*
+	* The results are those of the std::error_code overloads of
+	* socket_impl: the number of bytes or datagrams moved, would_block if
+	* the socket is non-blocking or its receive timeout expired, or
+	* failed with ec set.
+	*
+	* One thread may send while another receives, as on a stream socket:
+	* sends and receives batch through separate scratch arrays. Two sends,
+	* or two receives, must not run at once.
+	*/
+	class default_datagram_socket_impl : public default_socket_impl
+	{
+	public:
+		/**
+		* Most segments the kernel builds from one send with segmentation
+		* offload.
+		*/
+		static const int max_segments = 64;
+	private:
+#if defined(NET_LINUX)
+		std::vector<struct mmsghdr> send_headers_;
+		std::vector<struct iovec> send_vectors_;
+		std::vector<struct mmsghdr> receive_headers_;
+		std::vector<struct iovec> receive_vectors_;
+		std::vector<char> controls_;	// receive only
+#endif
+		bool segmentation_;	// UDP_SEGMENT works on this socket
+		bool count_drops_;	// receives read SO_RXQ_OVFL
+		std::uint32_t dropped_;
+	public:
+		default_datagram_socket_impl(void);
+	public:
+		virtual ~default_datagram_socket_impl(void);
+	public:
+		void create(const int& family);
+		void create(const int& family, std::error_code& ec) noexcept;
+	public:
+		/**
+		* Sends nbytes of buffer as one datagram to remote, or to the
+		* connected peer if remote is unspecified.
+		*/
+		int send_to(const std::uint8_t* buffer, const int& nbytes,
+			const endpoint& remote, std::error_code& ec) noexcept;
+
+		/**
+		* Receives one datagram into buffer and its sender into remote.
+		* A datagram longer than nbytes is truncated.
+		*/
+		int receive_from(std::uint8_t* buffer, const int& nbytes, endpoint& remote,
+			std::error_code& ec) noexcept;
+
+		/**
+		* Sends the count datagrams of msgs in order, with sendmmsg on
+		* Linux. Returns the number sent, which is less than count if the
+		* send buffer filled up or one failed after others were sent.
+		*/
+		int send_many(datagram* msgs, const int& count, std::error_code& ec) noexcept;
+
+		/**
+		* Receives up to count datagrams into msgs, waiting for the first
+		* one only, with recvmmsg on Linux; elsewhere a blocking socket
+		* receives one datagram per call. Returns the number received.
+		*/
+		int receive_many(datagram* msgs, const int& count, std::error_code& ec) noexcept;
+
+		/**
+		* Sends nbytes of buffer to remote, or to the connected peer if
+		* remote is unspecified, as datagrams of segment_size bytes, the
+		* last one shorter if nbytes is not a multiple of it. On Linux the
+		* kernel splits each run of up to max_segments segments (UDP_SEGMENT),
+		* so the stack is traversed once per run instead of once per
+		* datagram; where that is not available, or the segments do not fit
+		* the path MTU, the datagrams are sent with send_many. Returns the
+		* number of bytes sent, less than nbytes if the send buffer of a
+		* non-blocking socket filled up.
+		*/
+		int send_segments(const std::uint8_t* buffer, const int& nbytes,
+			const int& segment_size, const endpoint& remote, std::error_code& ec) noexcept;
+
+		/**
+		* Receives into buffer what the kernel coalesced from consecutive
+		* datagrams of one sender once UDP_GRO is enabled, and sets
+		* segment_size to the size of these datagrams: the payload splits
+		* at every segment_size bytes, the last datagram being shorter. A
+		* single datagram sets it to its length. buffer should hold 65535
+		* bytes; coalesced datagrams which do not fit are truncated.
+		*/
+		int receive_segments(std::uint8_t* buffer, const int& nbytes, endpoint& remote,
+			int& segment_size, std::error_code& ec) noexcept;
+	public:
+		/**
+		* Enables/disables SO_RXQ_OVFL: every datagram then carries the
+		* number of datagrams the kernel dropped on this socket so far for
+		* want of receive buffer space, which the receives above keep.
+		* Not supported outside Linux.
+		*/
+		void set_drop_counting(const bool& on, std::error_code& ec) noexcept;
+
+		/**
+		* Returns the drop count carried by the latest datagram received
+		* with drop counting enabled, which the kernel set when queueing it.
+		* The kernel counts modulo 2^32.
+		*/
+		std::uint32_t get_dropped(void) const;
+	private:
+#if defined(NET_LINUX)
+		void read_drops(struct msghdr& h);
+#endif
+		int send_segment_run(const std::uint8_t* buffer, const int& nbytes,
+			const int& segment_size, const endpoint& remote, std::error_code& ec) noexcept;
+	private:
+		default_datagram_socket_impl(const default_datagram_socket_impl&);
+		default_datagram_socket_impl& operator=(const default_datagram_socket_impl&);
+		default_datagram_socket_impl& operator=(const default_datagram_socket_impl&&);
+	};
+}
+
+#endif
@@ -26,3 +26,10 @@ void net::default_server_socket_impl::create(const int& family)
 	default_socket_impl::create(family);
 	set_option_bool(SO_REUSEADDR, true);
 }
+
+void net::default_server_socket_impl::create(const int& family, std::error_code& ec) noexcept
+{
+	default_socket_impl::create(family, ec);
+	if (!ec)
+		set_option_bool(SOL_SOCKET, SO_REUSEADDR, true, ec);
+}
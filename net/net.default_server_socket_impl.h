@@ -17,6 +17,7 @@ namespace net
 		static std::shared_ptr<socket_impl> of(const sio::socket_t& sock);
 	public:
 		void create(const int& family);
+		void create(const int& family, std::error_code& ec) noexcept;
 	private:
 		default_server_socket_impl(const default_server_socket_impl&);
 		default_server_socket_impl& operator=(const default_server_socket_impl&);
@@ -1,11 +1,65 @@
+#include <algorithm>
+#include <cstring>
 #include <ios>
+#include <limits>
 #include <vector>
 
+#include "net.error.h"
 #include "net.exceptions.h"
 #include "net.net_address.h"
 #include "net.net4_address.h"
 #include "net.net6_address.h"
 #include "net.default_socket_impl.h"
+#include "net.buffer_pool.h"
+#include "net.socket_filter.h"
+#include "net.timer_wheel.h"
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#if defined(NET_LINUX)
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(MSG_NOSIGNAL)
+#define NET_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define NET_SEND_FLAGS 0
+#endif
+
+#if defined(NET_LINUX) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define NET_ZERO_COPY
+#endif
+
+namespace
+{
+	// what the throwing overloads raise for an error of the error_code ones
+	std::ios_base::failure io_failure(const char* call, const std::error_code& ec)
+	{
+		return std::ios_base::failure(sio::errno_exception(call, ec.value()).what(), ec);
+	}
+
+	bool is_timeout(const std::error_code& ec)
+	{
+		return ec == std::errc::timed_out;
+	}
+}
+
+#if defined(NET_LINUX)
+#if !defined(SO_ATTACH_REUSEPORT_CBPF)
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+#if !defined(SO_DETACH_REUSEPORT_BPF)
+#define SO_DETACH_REUSEPORT_BPF 68
+#endif
+#endif
 
 net::default_socket_impl::default_socket_impl(void)
 	: default_socket_impl(sio::invalid_socket)
@@ -23,6 +77,15 @@ net::default_socket_impl::default_socket_impl(const sio::socket_t& sock,
 	const std::uint16_t& port)
 	: socket_impl(sock, localport, addr, port)
 	, shutdown_input_(false)
+	, zero_copy_(false)
+	, zero_copy_copied_(false)
+	, zero_copy_next_(0)
+	, zero_copy_pending_()
+	, zero_copy_bytes_(0)
+	, copied_bytes_(0)
+	, splice_read_(-1)
+	, splice_write_(-1)
+	, splice_pending_(0)
 {
 }
 
@@ -46,21 +109,27 @@ std::shared_ptr<net::socket_impl> net::default_socket_impl::of(const sio::socket
 void net::default_socket_impl::accept(std::shared_ptr<net::socket_impl>& new_impl)
 {
 	try {
-		socket_address peer_address;
-		sio::socket_t sock = accept(sock_, peer_address, localaddr_->get_family());
+		endpoint peer;
+		sio::socket_t sock;
+		std::int32_t tag = 0;
+		do
+			sock = accept(sock_, peer);
+		while (!admit(sock, peer, tag));
 		new_impl->set_native_socket(sock);
-		new_impl->set_address(peer_address.get_address());
-		new_impl->set_port(peer_address.get_port());
+		new_impl->set_remote_endpoint(peer);
+		new_impl->set_tag(tag);
 	}
 	catch (const sio::errno_exception& e) {
 		if (e.get_errno() == EAGAIN || e.get_errno() == EWOULDBLOCK)
 			throw socket_timeout_exception(e.what());
 		throw socket_exception(e.what());
 	}
-	new_impl->set_local_port(get_socket_local_port(
-		new_impl->get_native_socket(), localaddr_->get_family()));
-	new_impl->set_local_address(get_socket_local_address(
-		new_impl->get_native_socket(), localaddr_->get_family()));
+	try {
+		assign_local_endpoint(new_impl);
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
 }
 
 int net::default_socket_impl::available(void) const
@@ -88,14 +157,43 @@ void net::default_socket_impl::bind(const std::shared_ptr<net::net_address>& add
 		else
 			localport_ = get_socket_local_port(sock_, addr->get_family());
 		localaddr_ = get_socket_local_address(sock_, addr->get_family());
+		local_ = get_socket_local_endpoint(sock_);
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+}
+
+void net::default_socket_impl::bind(const endpoint& local)
+{
+	try {
+		sio::bind(sock_, local.data(), local.size());
+		set_local_endpoint(get_socket_local_endpoint(sock_));
 	}
 	catch (const sio::errno_exception& e) {
 		throw socket_exception(e.what());
 	}
 }
 
+void net::default_socket_impl::bind(const endpoint& local, std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (::bind(sock_, local.data(), local.size()) != 0) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	endpoint bound;
+	socklen_t salen = endpoint::capacity();
+	if (::getsockname(sock_, bound.data(), &salen) != 0) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	set_local_endpoint(bound);
+}
+
 void net::default_socket_impl::close(void)
 {
+	close_splice_pipe();
 	if (sock_ == sio::invalid_socket)
 		return;
 	try {
@@ -107,6 +205,19 @@ void net::default_socket_impl::close(void)
 	}
 }
 
+void net::default_socket_impl::close(std::error_code& ec) noexcept
+{
+	ec.clear();
+	close_splice_pipe();
+	if (sock_ == sio::invalid_socket)
+		return;
+	// the descriptor is released even if the call reports an error
+	int error = close_socket(sock_);
+	sock_ = sio::invalid_socket;
+	if (error != 0)
+		ec = make_socket_error(error);
+}
+
 void net::default_socket_impl::connect(const std::string& hostname,
 	const std::uint16_t& port)
 {
@@ -125,22 +236,106 @@ void net::default_socket_impl::connect(const std::shared_ptr<net::net_address>&
 	std::shared_ptr<net::net_address> normal = addr->is_any_local_address() ?
 		addr->get_local_host() : addr;
 	try {
-		connect(sock_, normal, port, timeout);
+		connect(sock_, normal, port, timeout, non_blocking_);
+		set_address(normal);
+		set_port(port);
 	}
 	catch (const sio::errno_exception& e) {
 		throw socket_exception(e.what());
 	}
-	catch (const socket_timeout_exception& e) {
-		throw e;
-	}
-	catch (const socket_exception& e) {
-		throw e;
+	catch (const socket_exception&) {
+		throw;
 	}
 	catch (const std::exception&) {
 		throw socket_exception("unknown exception");
 	}
 }
 
+void net::default_socket_impl::connect(const endpoint& remote, const int& timeout)
+{
+	endpoint target = remote;
+	if (remote.get_address().is_any_local_address())
+		target = endpoint(ip_address::loopback(remote.get_family()), remote.get_port());
+	int error = connect(sock_, target.data(), target.size(), timeout, non_blocking_);
+	if (error == ETIMEDOUT && timeout != 0)
+		throw socket_timeout_exception("connect timed out");
+	if (error != 0)
+		throw socket_exception(sio::errno_exception("connect", error).what());
+	set_remote_endpoint(target);
+}
+
+void net::default_socket_impl::connect(const endpoint& remote, const int& timeout,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	endpoint target = remote;
+	if (remote.get_address().is_any_local_address())
+		target = endpoint(ip_address::loopback(remote.get_family()), remote.get_port());
+	int error = connect(sock_, target.data(), target.size(), timeout, non_blocking_);
+#if defined(_WIN32)
+	if (non_blocking_ && is_would_block(error))
+		error = EINPROGRESS;	// Windows reports an attempt in progress as WSAEWOULDBLOCK
+#endif
+	if (error == 0 || error == EINPROGRESS)
+		set_remote_endpoint(target);	// an attempt in progress is completed by finish_connect
+	if (error != 0)
+		ec = make_socket_error(error);
+}
+
+bool net::default_socket_impl::try_connect(const std::shared_ptr<net::net_address>& addr,
+	const std::uint16_t& port)
+{
+	std::shared_ptr<net::net_address> normal = addr->is_any_local_address() ?
+		addr->get_local_host() : addr;
+	try {
+		int on = 1;
+		sio::ioctlsocket(sock_, sio::sio_nbio, &on);
+		try {
+			connect(sock_, normal, port, 0, true);
+		}
+		catch (const sio::errno_exception& e) {
+			if (!sio::inprogress(e))
+				throw;
+			return false;
+		}
+		on = non_blocking_ ? 1 : 0;
+		sio::ioctlsocket(sock_, sio::sio_nbio, &on);
+		return true;
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+}
+
+void net::default_socket_impl::finish_connect(void)
+{
+	try {
+		int error = 0;
+		int size = sizeof(error);
+		sio::getsockopt(sock_, SOL_SOCKET, SO_ERROR, &error, &size);
+		if (error != 0)
+			throw sio::errno_exception("connect", sio::socket_errno(error));
+		int on = non_blocking_ ? 1 : 0;
+		sio::ioctlsocket(sock_, sio::sio_nbio, &on);
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+}
+
+void net::default_socket_impl::finish_connect(std::error_code& ec) noexcept
+{
+	ec.clear();
+	int error = 0;
+	socklen_t size = sizeof(error);
+	if (::getsockopt(sock_, SOL_SOCKET, SO_ERROR, (char*) &error, &size) != 0)
+		error = last_error();
+	else
+		error = sio::socket_errno(error);
+	if (error != 0)
+		ec = make_socket_error(error);
+}
+
 void net::default_socket_impl::create(const int& family)
 {
 	try {
@@ -151,37 +346,457 @@ void net::default_socket_impl::create(const int& family)
 	}
 }
 
+void net::default_socket_impl::create(const int& family, std::error_code& ec) noexcept
+{
+	ec.clear();
+	sio::socket_t sock = ::socket(family, SOCK_STREAM, 0);
+	if (sock == sio::invalid_socket) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	sock_ = sock;
+}
+
 int net::default_socket_impl::read(std::uint8_t* buffer, const int& nbytes)
+{
+	int read_count = try_read(buffer, nbytes);
+	return read_count == would_block ? 0 : read_count;
+}
+
+void net::default_socket_impl::write(const std::uint8_t* buffer, const int& nbytes)
 {
 	if (nbytes == 0)
+		return;
+	try {
+		send(sock_, buffer, nbytes, 0);
+	}
+	catch (const sio::errno_exception& e) {
+		throw std::ios_base::failure(e.what());
+	}
+}
+
+int net::default_socket_impl::read_v(const io_vector* vec, const int& count)
+{
+	std::error_code ec;
+	int read_count = read_v(vec, count, ec);
+	if (ec)
+		throw io_failure("recvmsg", ec);
+	return read_count;
+}
+
+int net::default_socket_impl::write_v(const const_io_vector* vec, const int& count)
+{
+	std::error_code ec;
+	int written = write_v(vec, count, ec);
+	if (ec)
+		throw io_failure("sendmsg", ec);
+	return written;
+}
+
+int net::default_socket_impl::read_v(const io_vector* vec, const int& count,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (count == 0)
 		return 0;
 	if (shutdown_input_)
-		return -1;
-	try {
-		int read_count = recv(sock_, buffer, nbytes, 0);
-		if (read_count == -1)
+		return end_of_stream;
+	for (;;) {
+		int read_count = recv_v(sock_, vec, count);
+		if (read_count > 0)
+			return read_count;
+		if (read_count == 0) {
 			shutdown_input_ = true;	// peer closed
-		return read_count;
+			return end_of_stream;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+int net::default_socket_impl::write_v(const const_io_vector* vec, const int& count,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	int total = 0;
+	int index = 0;
+	int skip = 0;	// bytes of vec[index] which were already written
+	for (;;) {
+		// step over the buffers which are complete
+		while (index < count && skip >= vec[index].nbytes) {
+			skip -= vec[index].nbytes;
+			++index;
+		}
+		if (index == count)
+			return total;
+		int written = send_v(sock_, vec + index, count - index, skip);
+		if (written >= 0) {
+			total += written;
+			skip += written;
+			continue;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error)) {
+			if (total > 0)
+				return total;
+			if (non_blocking_)
+				return would_block;
+			ec = make_socket_error(ETIMEDOUT);
+			return failed;
+		}
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+void net::default_socket_impl::set_zero_copy(const bool& on, std::error_code& ec) noexcept
+{
+	ec.clear();
+#if defined(NET_ZERO_COPY)
+	int optval = on ? 1 : 0;
+	if (::setsockopt(sock_, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval)) != 0) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	zero_copy_ = on;
+	zero_copy_copied_ = false;
+#else
+	if (on)
+		ec = std::make_error_code(std::errc::operation_not_supported);
+#endif
+}
+
+void net::default_socket_impl::set_zero_copy(const bool& on)
+{
+#if defined(NET_ZERO_COPY)
+	try {
+		int optval = on ? 1 : 0;
+		sio::setsockopt(sock_, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval));
 	}
 	catch (const sio::errno_exception& e) {
-		if (e.get_errno() == EAGAIN || e.get_errno() == EWOULDBLOCK)
-			return 0;
-		throw std::ios_base::failure(e.what());
+		throw socket_exception(e.what());
 	}
+	zero_copy_ = on;
+	zero_copy_copied_ = false;
+#else
+	if (on)
+		throw socket_exception("zero-copy send is not supported");
+#endif
 }
 
-void net::default_socket_impl::write(const std::uint8_t* buffer, const int& nbytes)
+bool net::default_socket_impl::get_zero_copy(void) const
+{
+	return zero_copy_;
+}
+
+int net::default_socket_impl::send_zero_copy(const std::uint8_t* buffer,
+	const int& nbytes, const std::uint64_t& tag)
+{
+	std::error_code ec;
+	int written = send_zero_copy(buffer, nbytes, tag, ec);
+	if (is_timeout(ec))
+		throw socket_timeout_exception("send timed out");
+	if (ec)
+		throw io_failure("send", ec);
+	return written;
+}
+
+int net::default_socket_impl::send_zero_copy(const std::uint8_t* buffer,
+	const int& nbytes, const std::uint64_t& tag, std::error_code& ec) noexcept
+{
+	ec.clear();
+	// once the kernel reported that it had to copy anyway, as it does on
+	// loopback or without scatter/gather offload, plain sends are cheaper
+	bool zero_copy = zero_copy_ && !zero_copy_copied_ &&
+		nbytes >= zero_copy_threshold;
+	int flags = NET_SEND_FLAGS;
+#if defined(NET_ZERO_COPY)
+	if (zero_copy)
+		flags |= MSG_ZEROCOPY;
+#endif
+	zero_copy_send entry;
+	entry.tag_ = tag;
+	entry.bytes_ = 0;
+	entry.first_ = zero_copy_next_;
+	entry.count_ = 0;
+	entry.done_ = 0;
+	entry.copied_ = !zero_copy;
+	int error = 0;
+	while (entry.bytes_ < nbytes) {
+		int written = (int) ::send(sock_, (const char*) buffer + entry.bytes_,
+			nbytes - entry.bytes_, flags);
+		if (written >= 0) {
+			entry.bytes_ += written;
+			if (flags != NET_SEND_FLAGS)
+				++entry.count_;	// every zero-copy call gets a notification id
+			continue;
+		}
+		error = last_error();
+		if (error == EINTR) {
+			error = 0;
+			continue;
+		}
+#if defined(NET_ZERO_COPY)
+		if (error == ENOBUFS && flags != NET_SEND_FLAGS) {
+			// out of memory for notifications, copy the rest
+			flags = NET_SEND_FLAGS;
+			entry.copied_ = true;
+			error = 0;
+			continue;
+		}
+#endif
+		break;
+	}
+	zero_copy_next_ += entry.count_;
+	if (entry.bytes_ > 0)
+		zero_copy_pending_.push_back(entry);
+	if (error == 0)
+		return entry.bytes_;
+	if (is_would_block(error)) {
+		if (entry.bytes_ > 0)
+			return entry.bytes_;
+		if (non_blocking_)
+			return would_block;
+		error = ETIMEDOUT;
+	}
+	ec = make_socket_error(error);
+	return failed;
+}
+
+int net::default_socket_impl::reap_zero_copy(std::vector<std::uint64_t>& tags,
+	const int& timeout)
+{
+	int released = release_zero_copy(tags);
+	if (released > 0 || zero_copy_pending_.empty())
+		return released;
+	read_zero_copy_notifications();
+	released = release_zero_copy(tags);
+#if defined(NET_ZERO_COPY)
+	std::uint64_t deadline = now_millis() + (timeout > 0 ? timeout : 0);
+	while (released == 0 && timeout > 0) {
+		std::uint64_t now = now_millis();
+		if (now >= deadline)
+			break;
+		// a pending notification marks the socket with POLLERR
+		struct pollfd pfd;
+		pfd.fd = sock_;
+		pfd.events = 0;
+		pfd.revents = 0;
+		int ready = ::poll(&pfd, 1, (int) (deadline - now));
+		if (ready < 0 && errno != EINTR)
+			break;
+		if (ready > 0 && (pfd.revents & POLLERR) == 0)
+			break;	// hung up, no notification will arrive
+		read_zero_copy_notifications();
+		released = release_zero_copy(tags);
+	}
+#endif
+	return released;
+}
+
+std::uint64_t net::default_socket_impl::get_zero_copy_bytes(void) const
+{
+	return zero_copy_bytes_;
+}
+
+std::uint64_t net::default_socket_impl::get_copied_bytes(void) const
+{
+	return copied_bytes_;
+}
+
+std::int64_t net::default_socket_impl::send_file(const int& fd,
+	const std::int64_t& offset, const std::int64_t& length)
+{
+	std::error_code ec;
+	std::int64_t sent = send_file(fd, offset, length, ec);
+	if (is_timeout(ec))
+		throw socket_timeout_exception("send timed out");
+	if (ec)
+		throw io_failure("send_file", ec);
+	return sent;
+}
+
+std::int64_t net::default_socket_impl::send_file(const int& fd,
+	const std::int64_t& offset, const std::int64_t& length,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (length == 0)
+		return 0;
+	int error = 0;
+	std::int64_t sent = send_file(sock_, fd, offset, length, error);
+#if defined(NET_LINUX)
+	if (error == EINVAL || error == ENOSYS || error == ESPIPE) {
+		// sendfile cannot read from this kind of file, move it through a pipe
+		error = 0;
+		sent += splice_file(fd, offset + sent,
+			length < 0 ? length : length - sent, error);
+	}
+#endif
+	if (error == 0)
+		return sent;
+	if (is_would_block(error)) {
+		if (sent > 0)
+			return sent;	// partial progress, the caller resumes at offset + sent
+		if (non_blocking_)
+			return would_block;
+		error = ETIMEDOUT;
+	}
+	ec = make_socket_error(error);
+	return failed;
+}
+
+int net::default_socket_impl::try_read(std::uint8_t* buffer, const int& nbytes)
+{
+	std::error_code ec;
+	int read_count = try_read(buffer, nbytes, ec);
+	if (ec)
+		throw io_failure("recv", ec);
+	return read_count;
+}
+
+int net::default_socket_impl::try_write(const std::uint8_t* buffer, const int& nbytes)
+{
+	std::error_code ec;
+	int written = try_write(buffer, nbytes, ec);
+	if (ec)
+		throw io_failure("send", ec);
+	return written;
+}
+
+int net::default_socket_impl::try_accept(std::shared_ptr<net::socket_impl>& new_impl)
+{
+	std::error_code ec;
+	int result = try_accept(new_impl, ec);
+	if (ec)
+		throw socket_exception(sio::errno_exception("accept", ec.value()).what());
+	return result;
+}
+
+int net::default_socket_impl::try_read(std::uint8_t* buffer, const int& nbytes,
+	std::error_code& ec) noexcept
 {
+	ec.clear();
 	if (nbytes == 0)
-		return;
+		return 0;
+	if (shutdown_input_)
+		return end_of_stream;
+	for (;;) {
+		int read_count = (int) ::recv(sock_, (char*) buffer, nbytes, 0);
+		if (read_count > 0)
+			return read_count;
+		if (read_count == 0) {
+			shutdown_input_ = true;	// peer closed
+			return end_of_stream;
+		}
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+int net::default_socket_impl::try_write(const std::uint8_t* buffer, const int& nbytes,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (nbytes == 0)
+		return 0;
+	for (;;) {
+		int written = (int) ::send(sock_, (const char*) buffer, nbytes, NET_SEND_FLAGS);
+		if (written >= 0)
+			return written;
+		int error = last_error();
+		if (error == EINTR)
+			continue;
+		if (is_would_block(error))
+			return would_block;
+		ec = make_socket_error(error);
+		return failed;
+	}
+}
+
+int net::default_socket_impl::try_accept(std::shared_ptr<net::socket_impl>& new_impl,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	endpoint peer;
+	sio::socket_t sock;
+	std::int32_t tag = 0;
+	do {
+		int error = 0;
+		sock = try_accept(sock_, peer, non_blocking_, error);
+		if (sock == sio::invalid_socket) {
+			if (is_would_block(error))
+				return would_block;
+			ec = make_socket_error(error);
+			return failed;
+		}
+	} while (!admit(sock, peer, tag));
+	new_impl->set_native_socket(sock);
+	new_impl->set_remote_endpoint(peer);
+	new_impl->set_tag(tag);
+	if (non_blocking_)
+		new_impl->set_non_blocking_flag(true);	// inherited through accept4
+	assign_local_endpoint(new_impl, ec);
+	return ec ? failed : 0;
+}
+
+void net::default_socket_impl::accept(std::shared_ptr<net::socket_impl>& new_impl,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	endpoint peer;
+	sio::socket_t sock;
+	std::int32_t tag = 0;
+	do {
+		int error = 0;
+		sock = try_accept(sock_, peer, false, error);
+		if (sock == sio::invalid_socket) {
+			// a blocking listener only gives up when its receive timeout expires
+			ec = make_socket_error(is_would_block(error) ? ETIMEDOUT : error);
+			return;
+		}
+	} while (!admit(sock, peer, tag));
+	new_impl->set_native_socket(sock);
+	new_impl->set_remote_endpoint(peer);
+	new_impl->set_tag(tag);
+	assign_local_endpoint(new_impl, ec);
+}
+
+void net::default_socket_impl::set_non_blocking(const bool& on)
+{
 	try {
-		send(sock_, buffer, nbytes, 0);
+		int arg = on ? 1 : 0;
+		sio::ioctlsocket(sock_, sio::sio_nbio, &arg);
+		non_blocking_ = on;
 	}
 	catch (const sio::errno_exception& e) {
-		throw std::ios_base::failure(e.what());
+		throw socket_exception(e.what());
 	}
 }
 
+void net::default_socket_impl::set_non_blocking(const bool& on, std::error_code& ec) noexcept
+{
+	ec.clear();
+	int error = set_socket_non_blocking(sock_, on);
+	if (error != 0) {
+		ec = make_socket_error(error);
+		return;
+	}
+	non_blocking_ = on;
+}
+
 bool net::default_socket_impl::supports_urgent_data() const
 {
 	return true;
@@ -198,6 +813,20 @@ void net::default_socket_impl::send_urgent_data(const int& value)
 	}
 }
 
+void net::default_socket_impl::send_urgent_data(const int& value,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	char data = (char) value;
+	while (::send(sock_, &data, 1, MSG_OOB | NET_SEND_FLAGS) < 0) {
+		int error = last_error();
+		if (error != EINTR) {
+			ec = make_socket_error(error);
+			return;
+		}
+	}
+}
+
 void net::default_socket_impl::listen(const int& backlog)
 {
 	try {
@@ -208,6 +837,53 @@ void net::default_socket_impl::listen(const int& backlog)
 	}
 }
 
+void net::default_socket_impl::listen(const int& backlog, std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (::listen(sock_, backlog) != 0)
+		ec = make_socket_error(last_error());
+}
+
+void net::default_socket_impl::attach_filter(const socket_filter& filter,
+	const bool& reuseport)
+{
+#if defined(NET_LINUX)
+	std::vector<socket_filter::instruction> code = filter.compile();
+	static_assert(sizeof(socket_filter::instruction) == sizeof(sock_filter),
+		"socket_filter::instruction must match sock_filter");
+	sock_fprog prog;
+	prog.len = static_cast<unsigned short>(code.size());
+	prog.filter = reinterpret_cast<sock_filter*>(code.data());
+	try {
+		sio::setsockopt(sock_, SOL_SOCKET,
+			reuseport ? SO_ATTACH_REUSEPORT_CBPF : SO_ATTACH_FILTER,
+			&prog, sizeof(prog));
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+#else
+	throw socket_exception("socket filters are not supported");
+#endif
+}
+
+void net::default_socket_impl::detach_filter(const bool& reuseport)
+{
+#if defined(NET_LINUX)
+	try {
+		int optval = 0;
+		sio::setsockopt(sock_, SOL_SOCKET,
+			reuseport ? SO_DETACH_REUSEPORT_BPF : SO_DETACH_FILTER,
+			&optval, sizeof(optval));
+	}
+	catch (const sio::errno_exception& e) {
+		throw socket_exception(e.what());
+	}
+#else
+	throw socket_exception("socket filters are not supported");
+#endif
+}
+
 void net::default_socket_impl::shutdown_input()
 {
 	shutdown_input_ = true;
@@ -229,6 +905,21 @@ void net::default_socket_impl::shutdown_output()
 	}
 }
 
+void net::default_socket_impl::shutdown_input(std::error_code& ec) noexcept
+{
+	ec.clear();
+	shutdown_input_ = true;
+	if (::shutdown(sock_, SIO_SHUTDOWN_READ) != 0)
+		ec = make_socket_error(last_error());
+}
+
+void net::default_socket_impl::shutdown_output(std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (::shutdown(sock_, SIO_SHUTDOWN_WRITE) != 0)
+		ec = make_socket_error(last_error());
+}
+
 bool net::default_socket_impl::get_option_bool(const int& id)
 {
 	try {
@@ -279,28 +970,129 @@ void net::default_socket_impl::set_option_int(const int& id, const int& val)
 	}
 }
 
+bool net::default_socket_impl::get_option_bool(const int& level, const int& id,
+	std::error_code& ec) noexcept
+{
+	int value = get_option_int(level, id, ec);
+	if (ec)
+		return false;
+	if (level == SOL_SOCKET && id == SO_LINGER)
+		return value >= 0;
+	return value != 0;
+}
+
+int net::default_socket_impl::get_option_int(const int& level, const int& id,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	int rc = 0;
+	int value = 0;
+	if (level == SOL_SOCKET && id == SO_LINGER) {
+		struct linger optval;
+		socklen_t size = sizeof(optval);
+		rc = ::getsockopt(sock_, level, id, (char*) &optval, &size);
+		if (rc == 0)
+			value = optval.l_onoff ? optval.l_linger : -1;
+	}
+#if !defined(_WIN32)
+	else if (level == SOL_SOCKET && (id == SO_RCVTIMEO || id == SO_SNDTIMEO)) {
+		// Windows takes milliseconds, everyone else a timeval
+		struct timeval optval;
+		socklen_t size = sizeof(optval);
+		rc = ::getsockopt(sock_, level, id, &optval, &size);
+		if (rc == 0)
+			value = (int) (optval.tv_sec * 1000 + optval.tv_usec / 1000);
+	}
+#endif
+	else {
+		socklen_t size = sizeof(value);
+		rc = ::getsockopt(sock_, level, id, (char*) &value, &size);
+	}
+	if (rc != 0) {
+		ec = make_socket_error(last_error());
+		return 0;
+	}
+	return value;
+}
+
+void net::default_socket_impl::set_option_bool(const int& level, const int& id,
+	const bool& val, std::error_code& ec) noexcept
+{
+	ec.clear();
+	int rc = 0;
+	if (level == SOL_SOCKET && id == SO_LINGER) {
+		struct linger optval;
+		optval.l_onoff = val ? 1 : 0;
+		optval.l_linger = 0;
+		rc = ::setsockopt(sock_, level, id, (const char*) &optval, sizeof(optval));
+	}
+	else {
+		int optval = val ? 1 : 0;
+		rc = ::setsockopt(sock_, level, id, (const char*) &optval, sizeof(optval));
+	}
+	if (rc != 0)
+		ec = make_socket_error(last_error());
+}
 
-sio::socket_t net::default_socket_impl::accept(const sio::socket_t& sockfd,
-	socket_address& addr, const int& family)
+void net::default_socket_impl::set_option_int(const int& level, const int& id,
+	const int& val, std::error_code& ec) noexcept
 {
-	sio::socket_t sock = sio::invalid_socket;
-	if (family == AF_INET) {
-		sio::sock_addr4 sa;
-		int salen = sizeof(sa);
-		sock = sio::accept(sockfd, sa, &salen);
-		addr.set_port(sa.get_port());
-		addr.set_address(std::make_shared<net4_address>(sa.get_addr(), ""));
+	ec.clear();
+	int rc = 0;
+	if (level == SOL_SOCKET && id == SO_LINGER) {
+		struct linger optval;
+		optval.l_onoff = 1;
+		optval.l_linger = val;
+		rc = ::setsockopt(sock_, level, id, (const char*) &optval, sizeof(optval));
 	}
-	else if (family == AF_INET6) {
-		sio::sock_addr6 sa;
-		int salen = sizeof(sa);
-		sock = sio::accept(sockfd, sa, &salen);
-		addr.set_port(sa.get_port());
-		addr.set_address(std::make_shared<net6_address>(sa.get_addr(), 16, ""));
+#if !defined(_WIN32)
+	else if (level == SOL_SOCKET && (id == SO_RCVTIMEO || id == SO_SNDTIMEO)) {
+		struct timeval optval;
+		optval.tv_sec = val / 1000;
+		optval.tv_usec = (val % 1000) * 1000;
+		rc = ::setsockopt(sock_, level, id, &optval, sizeof(optval));
 	}
+#endif
+	else
+		rc = ::setsockopt(sock_, level, id, (const char*) &val, sizeof(val));
+	if (rc != 0)
+		ec = make_socket_error(last_error());
+}
+
+
+sio::socket_t net::default_socket_impl::accept(const sio::socket_t& sockfd,
+	endpoint& addr)
+{
+	int error = 0;
+	sio::socket_t sock = try_accept(sockfd, addr, false, error);
+	if (sock == sio::invalid_socket)
+		throw sio::errno_exception("accept", error);
 	return sock;
 }
 
+sio::socket_t net::default_socket_impl::try_accept(const sio::socket_t& sockfd,
+	endpoint& addr, const bool& non_blocking, int& error) noexcept
+{
+	for (;;) {
+		socklen_t salen = endpoint::capacity();
+#if defined(NET_LINUX)
+		// accept4 sets the descriptor flags without extra fcntl/ioctl calls
+		int flags = SOCK_CLOEXEC | (non_blocking ? SOCK_NONBLOCK : 0);
+		sio::socket_t sock = ::accept4(sockfd, addr.data(), &salen, flags);
+#else
+		sio::socket_t sock = ::accept(sockfd, addr.data(), &salen);
+		if (sock != sio::invalid_socket && non_blocking)
+			set_socket_non_blocking(sock, true);
+#endif
+		if (sock != sio::invalid_socket)
+			return sock;
+		error = last_error();
+		if (error == EINTR || error == ECONNABORTED)
+			continue;
+		return sio::invalid_socket;
+	}
+}
+
 void net::default_socket_impl::bind(const sio::socket_t& sockfd,
 	const std::shared_ptr<net::net_address>& addr, const std::uint16_t& port)
 {
@@ -316,72 +1108,74 @@ void net::default_socket_impl::bind(const sio::socket_t& sockfd,
 
 void net::default_socket_impl::connect(const sio::socket_t& sockfd,
 	const std::shared_ptr<net_address>& addr, const std::uint16_t& port,
-	const int& timeout)
+	const int& timeout, const bool& non_blocking)
 {
+	int error = 0;
 	if (addr->get_family() == AF_INET) {
 		sio::sock_addr4 sa(addr->get_address(), port);
-		connect(sockfd, sa, sizeof(sa), timeout);
+		error = connect(sockfd, sa, sizeof(sa), timeout, non_blocking);
 	}
 	else if (addr->get_family() == AF_INET6) {
 		sio::sock_addr6 sa(addr->get_address(), port);
-		connect(sockfd, sa, sizeof(sa), timeout);
+		error = connect(sockfd, sa, sizeof(sa), timeout, non_blocking);
 	}
+	if (error == ETIMEDOUT && timeout != 0)
+		throw socket_timeout_exception("connect timed out");
+	if (error != 0)
+		throw sio::errno_exception("connect", error);
 }
 
-void net::default_socket_impl::connect(const sio::socket_t& sockfd,
-	const sio::sockaddr_t* addr, const int& len, const int& timeout)
+int net::default_socket_impl::connect(const sio::socket_t& sockfd,
+	const sio::sockaddr_t* addr, const int& len, const int& timeout,
+	const bool& non_blocking) noexcept
 {
-	if (timeout == 0)
-		sio::connect(sockfd, addr, len);
-	else {
-		int on = 1;
-		sio::ioctlsocket(sockfd, sio::sio_nbio, &on);
-		on = 0;
-		std::uint64_t finish = now_millis() + timeout;
-		try {
-			sio::connect(sockfd, addr, len);
-			sio::ioctlsocket(sockfd, sio::sio_nbio, &on);
-			return;
-		}
-		catch (const sio::errno_exception& e) {
-			if (!sio::inprogress(e))
-				throw e;
-		}
-
-		int remaining;
-		do {
-			remaining = static_cast<int>(finish - now_millis());
-			if (remaining <= 0)
-				throw socket_timeout_exception("connect timed out");
-		} while (!is_connected(sockfd, addr, timeout, remaining));
-		sio::ioctlsocket(sockfd, sio::sio_nbio, &on);
+	if (timeout == 0) {
+		if (::connect(sockfd, addr, len) == 0)
+			return 0;
+		return last_error();
+	}
+	int error = set_socket_non_blocking(sockfd, true);
+	if (error != 0)
+		return error;
+	if (::connect(sockfd, addr, len) != 0) {
+		error = last_error();
+		if (error == EINPROGRESS || is_would_block(error))
+			error = wait_connected(sockfd, timeout);
 	}
+	int restored = set_socket_non_blocking(sockfd, non_blocking);
+	return error != 0 ? error : restored;
 }
 
-bool net::default_socket_impl::is_connected(const sio::socket_t& sockfd,
-	const sio::sockaddr_t* addr, const int& timeout, const int& remaining)
+int net::default_socket_impl::wait_connected(const sio::socket_t& sockfd,
+	const int& timeout) noexcept
 {
-	try {
-		sio::reactor sr;
-		sr.select(sockfd, sio::reactor::out);
-		sio::reactor::event ev[1], *pev = ev;
-		int rc = sr.poll(pev, 1, remaining);
-		if (rc == 0)
-			return false;
-		int error;
-		int size = sizeof(error);
-		sio::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &size);
-		if (error == 0)
-			return true;
-		throw sio::errno_exception("is_connected", sio::socket_errno(error));
-	}
-	catch (const sio::errno_exception& e) {
-		if (e.get_errno() == EINTR)
-			return false;
-		else if (e.get_errno() == ETIMEDOUT)
-			throw socket_timeout_exception("connect timed out");
-		else
-			throw socket_exception(e.what());
+	std::uint64_t deadline = now_millis() + timeout;
+	for (;;) {
+		std::uint64_t now = now_millis();
+		if (now >= deadline)
+			return ETIMEDOUT;
+		struct pollfd pfd;
+		pfd.fd = sockfd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+#if defined(_WIN32)
+		int ready = ::WSAPoll(&pfd, 1, (int) (deadline - now));
+#else
+		int ready = ::poll(&pfd, 1, (int) (deadline - now));
+#endif
+		if (ready == 0)
+			return ETIMEDOUT;
+		if (ready < 0) {
+			int error = last_error();
+			if (error == EINTR)
+				continue;
+			return error;
+		}
+		int error = 0;
+		socklen_t size = sizeof(error);
+		if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, (char*) &error, &size) != 0)
+			return last_error();
+		return sio::socket_errno(error);
 	}
 }
 
@@ -403,6 +1197,335 @@ void net::default_socket_impl::send(const sio::socket_t& sockfd,
 	}
 }
 
+void net::default_socket_impl::read_zero_copy_notifications(void)
+{
+#if defined(NET_ZERO_COPY)
+	for (;;) {
+		char control[256];
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (::recvmsg(sock_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			int error = last_error();
+			if (error == EINTR)
+				continue;
+			if (is_would_block(error))
+				return;
+			throw std::ios_base::failure(sio::errno_exception("recvmsg", error).what());
+		}
+		for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+				cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+					!(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+				continue;
+			struct sock_extended_err err;
+			std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+			if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+			complete_zero_copy(err.ee_info, err.ee_data,
+				(err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+		}
+	}
+#endif
+}
+
+void net::default_socket_impl::complete_zero_copy(const std::uint32_t& lo,
+	const std::uint32_t& hi, const bool& copied)
+{
+	if (copied)
+		zero_copy_copied_ = true;
+	std::uint32_t range = hi - lo + 1;
+	for (std::deque<zero_copy_send>::iterator it = zero_copy_pending_.begin();
+			it != zero_copy_pending_.end(); ++it) {
+		for (std::uint32_t i = 0; i < it->count_; ++i) {
+			// ids wrap around, compare the distance from lo
+			if ((std::uint32_t) (it->first_ + i - lo) < range) {
+				++it->done_;
+				it->copied_ = it->copied_ || copied;
+			}
+		}
+	}
+}
+
+int net::default_socket_impl::release_zero_copy(std::vector<std::uint64_t>& tags)
+{
+	int released = 0;
+	std::deque<zero_copy_send>::iterator it = zero_copy_pending_.begin();
+	while (it != zero_copy_pending_.end()) {
+		if (it->done_ < it->count_) {
+			++it;
+			continue;
+		}
+		if (it->copied_)
+			copied_bytes_ += it->bytes_;
+		else
+			zero_copy_bytes_ += it->bytes_;
+		tags.push_back(it->tag_);
+		it = zero_copy_pending_.erase(it);
+		++released;
+	}
+	return released;
+}
+
+int net::default_socket_impl::recv_v(const sio::socket_t& sockfd,
+	const io_vector* vec, const int& count)
+{
+	const int max_vectors = 64;
+	int n = count < max_vectors ? count : max_vectors;
+#if defined(_WIN32)
+	WSABUF bufs[max_vectors];
+	for (int i = 0; i < n; ++i) {
+		bufs[i].buf = (CHAR*) vec[i].buffer;
+		bufs[i].len = (ULONG) vec[i].nbytes;
+	}
+	DWORD received = 0;
+	DWORD flags = 0;
+	if (::WSARecv(sockfd, bufs, (DWORD) n, &received, &flags, nullptr, nullptr) != 0)
+		return -1;
+	return (int) received;
+#else
+	struct iovec iov[max_vectors];
+	for (int i = 0; i < n; ++i) {
+		iov[i].iov_base = vec[i].buffer;
+		iov[i].iov_len = (std::size_t) vec[i].nbytes;
+	}
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = n;
+	return (int) ::recvmsg(sockfd, &msg, 0);
+#endif
+}
+
+int net::default_socket_impl::send_v(const sio::socket_t& sockfd,
+	const const_io_vector* vec, const int& count, const int& skip)
+{
+	// the first buffer starts skip bytes in; the rest are sent whole
+	const int max_vectors = 64;
+	int n = count < max_vectors ? count : max_vectors;
+#if defined(_WIN32)
+	WSABUF bufs[max_vectors];
+	for (int i = 0; i < n; ++i) {
+		int offset = i == 0 ? skip : 0;
+		bufs[i].buf = (CHAR*) vec[i].buffer + offset;
+		bufs[i].len = (ULONG) (vec[i].nbytes - offset);
+	}
+	DWORD sent = 0;
+	if (::WSASend(sockfd, bufs, (DWORD) n, &sent, 0, nullptr, nullptr) != 0)
+		return -1;
+	return (int) sent;
+#else
+	struct iovec iov[max_vectors];
+	for (int i = 0; i < n; ++i) {
+		int offset = i == 0 ? skip : 0;
+		iov[i].iov_base = const_cast<std::uint8_t*>(vec[i].buffer) + offset;
+		iov[i].iov_len = (std::size_t) (vec[i].nbytes - offset);
+	}
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = n;
+	return (int) ::sendmsg(sockfd, &msg, NET_SEND_FLAGS);
+#endif
+}
+
+std::int64_t net::default_socket_impl::send_file(const sio::socket_t& sockfd,
+	const int& fd, const std::int64_t& offset, const std::int64_t& length,
+	int& error)
+{
+	const std::int64_t max_chunk = 1 << 30;
+	std::int64_t remaining = length < 0 ?
+		std::numeric_limits<std::int64_t>::max() : length;
+	std::int64_t sent = 0;
+#if defined(NET_LINUX)
+	off_t position = (off_t) offset;
+	while (remaining > 0) {
+		ssize_t n = ::sendfile(sockfd, fd, &position,
+			(std::size_t) std::min(remaining, max_chunk));
+		if (n > 0) {
+			sent += n;
+			remaining -= n;
+			continue;
+		}
+		if (n == 0)
+			break;	// end of file
+		if (errno == EINTR)
+			continue;
+		error = errno;
+		break;
+	}
+#elif !defined(_WIN32)
+	// no kernel file transmission, copy through a user space buffer
+	const int buffer_size = buffer_pool::max_block_size;
+	std::uint8_t* buffer = buffer_pool::get_default().allocate(buffer_size);
+	while (remaining > 0) {
+		ssize_t n = ::pread(fd, buffer,
+			(std::size_t) std::min(remaining, (std::int64_t) buffer_size),
+			(off_t) (offset + sent));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			error = errno;
+			break;
+		}
+		if (n == 0)
+			break;	// end of file
+		ssize_t written = 0;
+		while (written < n) {
+			ssize_t w = ::send(sockfd, (const char*) buffer + written,
+				(std::size_t) (n - written), NET_SEND_FLAGS);
+			if (w < 0 && errno == EINTR)
+				continue;
+			if (w < 0) {
+				error = errno;
+				break;
+			}
+			written += w;
+		}
+		sent += written;
+		remaining -= written;
+		if (error != 0)
+			break;
+	}
+	buffer_pool::get_default().deallocate(buffer, buffer_size);
+	(void) max_chunk;
+#else
+	(void) sockfd; (void) fd; (void) offset; (void) remaining; (void) max_chunk;
+	error = ENOSYS;
+#endif
+	return sent;
+}
+
+#if defined(NET_LINUX)
+std::int64_t net::default_socket_impl::splice_file(const int& fd,
+	const std::int64_t& offset, const std::int64_t& length, int& error)
+{
+	const std::int64_t max_chunk = 1 << 16;	// default pipe capacity
+	std::int64_t remaining = length < 0 ?
+		std::numeric_limits<std::int64_t>::max() : length;
+	std::int64_t sent = 0;
+	// bytes an earlier call read from an unseekable file but could not
+	// send are still in the pipe and go out first
+	while (splice_pending_ > 0 && remaining > 0) {
+		ssize_t out = ::splice(splice_read_, nullptr, sock_, nullptr,
+			(std::size_t) std::min(splice_pending_, remaining), SPLICE_F_MOVE);
+		if (out < 0 && errno == EINTR)
+			continue;
+		if (out < 0) {
+			error = errno;
+			return sent;
+		}
+		splice_pending_ -= out;
+		sent += out;
+		remaining -= out;
+	}
+	if (splice_pending_ > 0)
+		return sent;
+	if (splice_read_ == -1) {
+		int pipefd[2];
+		if (::pipe2(pipefd, O_CLOEXEC) != 0) {
+			error = errno;
+			return sent;
+		}
+		splice_read_ = pipefd[0];
+		splice_write_ = pipefd[1];
+	}
+	// pipes and sockets have no offset and are read from where they are
+	struct stat st;
+	bool seekable = ::fstat(fd, &st) == 0 &&
+		!S_ISFIFO(st.st_mode) && !S_ISSOCK(st.st_mode);
+	loff_t position = (loff_t) offset;
+	while (remaining > 0) {
+		ssize_t in = ::splice(fd, seekable ? &position : nullptr, splice_write_,
+			nullptr, (std::size_t) std::min(remaining, max_chunk), SPLICE_F_MOVE);
+		if (in < 0 && errno == EINTR)
+			continue;
+		if (in < 0) {
+			error = errno;
+			break;
+		}
+		if (in == 0)
+			break;	// end of file
+		while (in > 0) {
+			ssize_t out = ::splice(splice_read_, nullptr, sock_, nullptr,
+				(std::size_t) in, SPLICE_F_MOVE |
+				(remaining > in ? SPLICE_F_MORE : 0));
+			if (out < 0 && errno == EINTR)
+				continue;
+			if (out < 0) {
+				error = errno;
+				break;
+			}
+			in -= out;
+			sent += out;
+			remaining -= out;
+		}
+		if (error != 0) {
+			// a seekable file is resumed at offset + sent, the bytes of any
+			// other file are gone from it and wait in the pipe instead
+			if (!seekable)
+				splice_pending_ = in;
+			break;
+		}
+	}
+	if (splice_pending_ == 0)
+		close_splice_pipe();
+	return sent;
+}
+#endif
+
+void net::default_socket_impl::close_splice_pipe(void) noexcept
+{
+#if defined(NET_LINUX)
+	if (splice_read_ != -1) {
+		::close(splice_read_);
+		::close(splice_write_);
+		splice_read_ = -1;
+		splice_write_ = -1;
+	}
+	splice_pending_ = 0;
+#endif
+}
+
+void net::default_socket_impl::assign_local_endpoint(
+	const std::shared_ptr<net::socket_impl>& new_impl) const
+{
+	// a connection accepted on a specific address shares the local endpoint
+	// of the listener, so getsockname is only needed for wildcard listeners
+	if (!local_.is_unspecified() && !local_.get_address().is_any_local_address()) {
+		new_impl->set_local_endpoint(local_);
+		return;
+	}
+	new_impl->set_local_endpoint(get_socket_local_endpoint(new_impl->get_native_socket()));
+}
+
+void net::default_socket_impl::assign_local_endpoint(
+	const std::shared_ptr<net::socket_impl>& new_impl, std::error_code& ec) const noexcept
+{
+	ec.clear();
+	if (!local_.is_unspecified() && !local_.get_address().is_any_local_address()) {
+		new_impl->set_local_endpoint(local_);
+		return;
+	}
+	endpoint addr;
+	socklen_t salen = endpoint::capacity();
+	if (::getsockname(new_impl->get_native_socket(), addr.data(), &salen) != 0) {
+		ec = make_socket_error(last_error());
+		return;
+	}
+	new_impl->set_local_endpoint(addr);
+}
+
+net::endpoint net::default_socket_impl::get_socket_local_endpoint(
+	const sio::socket_t& sockfd)
+{
+	endpoint addr;
+	int salen = endpoint::capacity();
+	sio::getsockname(sockfd, addr.data(), &salen);
+	return addr;
+}
+
 std::uint16_t net::default_socket_impl::get_socket_local_port(
 	const sio::socket_t& sockfd, const int& family)
 {
@@ -442,8 +1565,46 @@ net::default_socket_impl::get_socket_local_address(const sio::socket_t& sockfd,
 
 std::uint64_t net::default_socket_impl::now_millis(void)
 {
-	sio::timeval_t tv;
-	sio::gettimeofday(&tv, nullptr);
-	return static_cast<std::uint64_t>(tv.tv_sec) * 1000 +
-		tv.tv_usec / 1000;
+	return timer_wheel::now_millis();
+}
+
+int net::default_socket_impl::last_error(void)
+{
+#if defined(_WIN32)
+	return sio::socket_errno(::WSAGetLastError());
+#else
+	return errno;
+#endif
+}
+
+int net::default_socket_impl::close_socket(const sio::socket_t& sockfd) noexcept
+{
+#if defined(_WIN32)
+	if (::closesocket(sockfd) != 0)
+		return last_error();
+#else
+	if (::close(sockfd) != 0 && errno != EINTR)
+		return errno;
+#endif
+	return 0;
+}
+
+int net::default_socket_impl::set_socket_non_blocking(const sio::socket_t& sockfd,
+	const bool& on) noexcept
+{
+#if defined(_WIN32)
+	u_long arg = on ? 1 : 0;
+	if (::ioctlsocket(sockfd, FIONBIO, &arg) != 0)
+		return last_error();
+#else
+	int arg = on ? 1 : 0;
+	if (::ioctl(sockfd, FIONBIO, &arg) != 0)
+		return errno;
+#endif
+	return 0;
+}
+
+bool net::default_socket_impl::is_would_block(const int& error)
+{
+	return error == EAGAIN || error == EWOULDBLOCK;
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #ifndef __NET_DEFAULT_SOCKET_IMPL__
 #define __NET_DEFAULT_SOCKET_IMPL__
 
+#include <deque>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "net.net_address.h"
 #include "net.socket_address.h"
@@ -12,7 +14,32 @@ namespace net
 {
 	class default_socket_impl : public socket_impl
 	{
+	public:
+		/**
+		* Payloads smaller than this are copied by send_zero_copy, pinning
+		* the pages and reaping the completion would cost more.
+		*/
+		static const int zero_copy_threshold = 65536;
+	protected:
+		struct zero_copy_send
+		{
+			std::uint64_t tag_;
+			int bytes_;
+			std::uint32_t first_;	// notification id of the first send call
+			std::uint32_t count_;	// zero-copy send calls made for the buffer
+			std::uint32_t done_;	// of these, the ones which completed
+			bool copied_;
+		};
 		bool shutdown_input_;
+		bool zero_copy_;
+		bool zero_copy_copied_;
+		std::uint32_t zero_copy_next_;
+		std::deque<zero_copy_send> zero_copy_pending_;
+		std::uint64_t zero_copy_bytes_;
+		std::uint64_t copied_bytes_;
+		int splice_read_;
+		int splice_write_;
+		std::int64_t splice_pending_;	// bytes of an unseekable file left in the pipe
 	public:
 		default_socket_impl(void);
 		default_socket_impl(const sio::socket_t& sock);
@@ -29,18 +56,40 @@ namespace net
 		int available(void) const;
 		void bind(const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port);
+		void bind(const endpoint& local);
 		void close(void);
 		void connect(const std::string& hostname, const std::uint16_t& port);
 		void connect(const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port);
 		void connect(const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port, const int& timeout);
+		void connect(const endpoint& remote, const int& timeout);
+		bool try_connect(const std::shared_ptr<net_address>& addr,
+			const std::uint16_t& port);
+		void finish_connect(void);
 		void create(const int& family);
 		int read(std::uint8_t* buffer, const int& nbytes);
 		void write(const std::uint8_t* buffer, const int& nbytes);
+		int read_v(const io_vector* vec, const int& count);
+		int write_v(const const_io_vector* vec, const int& count);
+		void set_zero_copy(const bool& on);
+		bool get_zero_copy(void) const;
+		int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag);
+		int reap_zero_copy(std::vector<std::uint64_t>& tags, const int& timeout);
+		std::uint64_t get_zero_copy_bytes(void) const;
+		std::uint64_t get_copied_bytes(void) const;
+		std::int64_t send_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length);
+		int try_read(std::uint8_t* buffer, const int& nbytes);
+		int try_write(const std::uint8_t* buffer, const int& nbytes);
+		int try_accept(std::shared_ptr<socket_impl>& new_socket);
+		void set_non_blocking(const bool& on);
 		bool supports_urgent_data(void) const;
 		void send_urgent_data(const int& value);
 		void listen(const int& backlog);
+		void attach_filter(const socket_filter& filter, const bool& reuseport);
+		void detach_filter(const bool& reuseport);
 		void shutdown_input();
 		void shutdown_output();
 	public:
@@ -48,26 +97,87 @@ namespace net
 		void set_option_bool(const int& id, const bool& val);
 		int get_option_int(const int& id);
 		void set_option_int(const int& id, const int& val);
-	private:
-		static sio::socket_t accept(const sio::socket_t& sockfd, socket_address& addr,
-			const int& family);
+	public:
+		void accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept;
+		void bind(const endpoint& local, std::error_code& ec) noexcept;
+		void close(std::error_code& ec) noexcept;
+		void connect(const endpoint& remote, const int& timeout,
+			std::error_code& ec) noexcept;
+		void finish_connect(std::error_code& ec) noexcept;
+		void create(const int& family, std::error_code& ec) noexcept;
+		int read_v(const io_vector* vec, const int& count,
+			std::error_code& ec) noexcept;
+		int write_v(const const_io_vector* vec, const int& count,
+			std::error_code& ec) noexcept;
+		void set_zero_copy(const bool& on, std::error_code& ec) noexcept;
+		int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag, std::error_code& ec) noexcept;
+		std::int64_t send_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length, std::error_code& ec) noexcept;
+		int try_read(std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept;
+		int try_write(const std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept;
+		int try_accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept;
+		void set_non_blocking(const bool& on, std::error_code& ec) noexcept;
+		void send_urgent_data(const int& value, std::error_code& ec) noexcept;
+		void listen(const int& backlog, std::error_code& ec) noexcept;
+		void shutdown_input(std::error_code& ec) noexcept;
+		void shutdown_output(std::error_code& ec) noexcept;
+		bool get_option_bool(const int& level, const int& id,
+			std::error_code& ec) noexcept;
+		int get_option_int(const int& level, const int& id,
+			std::error_code& ec) noexcept;
+		void set_option_bool(const int& level, const int& id, const bool& val,
+			std::error_code& ec) noexcept;
+		void set_option_int(const int& level, const int& id, const int& val,
+			std::error_code& ec) noexcept;
+	protected:
+		static sio::socket_t accept(const sio::socket_t& sockfd, endpoint& addr);
+		static sio::socket_t try_accept(const sio::socket_t& sockfd,
+			endpoint& addr, const bool& non_blocking, int& error) noexcept;
 		static void bind(const sio::socket_t& sockfd, const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port);
 		static void connect(const sio::socket_t& sockfd, const std::shared_ptr<net_address>& addr,
-			const std::uint16_t& port, const int& timeout);
-		static void connect(const sio::socket_t& sockfd, const sio::sockaddr_t* addr,
-			const int& len, const int& timeout);
-		static bool is_connected(const sio::socket_t& sockfd, const sio::sockaddr_t* addr,
-			const int& timeout, const int& remaining);
+			const std::uint16_t& port, const int& timeout, const bool& non_blocking);
+		static int connect(const sio::socket_t& sockfd, const sio::sockaddr_t* addr,
+			const int& len, const int& timeout, const bool& non_blocking) noexcept;
+		static int wait_connected(const sio::socket_t& sockfd, const int& timeout) noexcept;
 		static int recv(const sio::socket_t& sockfd, std::uint8_t* buffer,
 			const int& bytes, const int& flags);
 		static void send(const sio::socket_t& sockfd, const std::uint8_t* buffer,
 			const int& bytes, const int& flags);
+		void read_zero_copy_notifications(void);
+		void complete_zero_copy(const std::uint32_t& lo, const std::uint32_t& hi,
+			const bool& copied);
+		int release_zero_copy(std::vector<std::uint64_t>& tags);
+		static int recv_v(const sio::socket_t& sockfd, const io_vector* vec,
+			const int& count);
+		static int send_v(const sio::socket_t& sockfd, const const_io_vector* vec,
+			const int& count, const int& skip);
+		static std::int64_t send_file(const sio::socket_t& sockfd, const int& fd,
+			const std::int64_t& offset, const std::int64_t& length, int& error);
+#if defined(NET_LINUX)
+		std::int64_t splice_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length, int& error);
+#endif
+		void close_splice_pipe(void) noexcept;
+		void assign_local_endpoint(const std::shared_ptr<socket_impl>& new_impl) const;
+		void assign_local_endpoint(const std::shared_ptr<socket_impl>& new_impl,
+			std::error_code& ec) const noexcept;
+		static endpoint get_socket_local_endpoint(const sio::socket_t& sockfd);
 		static std::uint16_t get_socket_local_port(const sio::socket_t& sockfd,
 			const int& family);
 		static std::shared_ptr<net_address> get_socket_local_address(
 			const sio::socket_t& sockfd, const int& family);
 		static std::uint64_t now_millis(void);
+		static int last_error(void);
+		static int close_socket(const sio::socket_t& sockfd) noexcept;
+		static int set_socket_non_blocking(const sio::socket_t& sockfd,
+			const bool& on) noexcept;
+		static bool is_would_block(const int& error);
 	private:
 		default_socket_impl(const default_socket_impl&);
 		default_socket_impl& operator=(const default_socket_impl&);
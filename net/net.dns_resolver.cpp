@@ -0,0 +1,850 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/epoll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "net.exceptions.h"
+#include "net.dns_resolver.h"
+
+namespace
+{
+	const std::uint16_t type_a = 1;
+	const std::uint16_t type_aaaa = 28;
+	const std::uint16_t class_in = 1;
+	const std::size_t header_size = 12;
+	const int max_events = 64;
+}
+
+net::dns_resolver::dns_resolver(void)
+	: servers_()
+	, timeout_(5000)
+	, attempts_(2)
+	, max_in_flight_(1024)
+	, hosts_()
+	, epfd_(-1)
+	, udp4_fd_(-1)
+	, udp6_fd_(-1)
+	, mutex_()
+	, progress_()
+	, driving_(false)
+	, random_(std::random_device()())
+	, queries_()
+	, tcp_queries_()
+	, backlog_()
+	, unsent_()
+	, timers_()
+	, completed_()
+	, buffer_(65536)
+{
+	load_resolv_conf("/etc/resolv.conf");
+	if (servers_.empty())
+		add_server(socket_address(net_address::of("127.0.0.1"), 53));
+	load_hosts("/etc/hosts");
+	open();
+}
+
+net::dns_resolver::dns_resolver(const std::vector<socket_address>& servers,
+	const int& timeout, const int& attempts)
+	: servers_()
+	, timeout_(timeout > 0 ? timeout : 2000)
+	, attempts_(attempts > 0 ? attempts : 1)
+	, max_in_flight_(1024)
+	, hosts_()
+	, epfd_(-1)
+	, udp4_fd_(-1)
+	, udp6_fd_(-1)
+	, mutex_()
+	, progress_()
+	, driving_(false)
+	, random_(std::random_device()())
+	, queries_()
+	, tcp_queries_()
+	, backlog_()
+	, unsent_()
+	, timers_()
+	, completed_()
+	, buffer_(65536)
+{
+	for (std::size_t i = 0; i < servers.size(); ++i)
+		add_server(servers[i]);
+	if (servers_.empty())
+		throw socket_exception("No name server");
+	open();
+}
+
+net::dns_resolver::~dns_resolver(void)
+{
+	for (auto it = tcp_queries_.begin(); it != tcp_queries_.end(); ++it)
+		::close(it->first);
+	if (udp4_fd_ != -1)
+		::close(udp4_fd_);
+	if (udp6_fd_ != -1)
+		::close(udp6_fd_);
+	::close(epfd_);
+}
+
+void net::dns_resolver::resolve_async(const std::string& hostname,
+	const resolve_handler& handler)
+{
+	start(hostname, handler);
+}
+
+std::shared_ptr<net::dns_resolver::lookup>
+net::dns_resolver::start(const std::string& hostname, const resolve_handler& handler)
+{
+	std::shared_ptr<lookup> l = std::make_shared<lookup>();
+	l->hostname_ = hostname;
+	l->handler_ = handler;
+	l->pending_ = 0;
+	l->answered_ = false;
+	std::vector<std::shared_ptr<lookup>> done;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::string name = normalize(hostname);
+		if (answer_locally(l)) {
+			l->answered_ = true;
+			done.push_back(l);
+		}
+		else {
+			std::shared_ptr<query> queries[2];
+			const std::uint16_t types[2] = { type_a, type_aaaa };
+			for (int i = 0; i < 2; ++i) {
+				std::shared_ptr<query> q = std::make_shared<query>();
+				q->lookup_ = l;
+				q->id_ = 0;
+				q->type_ = types[i];
+				q->deadline_ = 0;
+				q->server_ = 0;
+				q->tries_ = 0;
+				q->done_ = false;
+				q->tcp_fd_ = -1;
+				q->tcp_sent_ = 0;
+				if (!encode_query(name, q->type_, q->packet_)) {
+					l->answered_ = true;	// not a valid domain name
+					done.push_back(l);
+					break;
+				}
+				queries[i] = q;
+			}
+			if (done.empty()) {
+				l->pending_ = 2;
+				submit(queries[0]);
+				submit(queries[1]);
+			}
+		}
+	}
+	deliver(done);
+	return l;
+}
+
+std::vector<std::shared_ptr<net::net_address>>
+net::dns_resolver::resolve(const std::string& hostname)
+{
+	struct result
+	{
+		bool done_;
+		std::vector<std::shared_ptr<net_address>> addresses_;
+	};
+	std::shared_ptr<result> r = std::make_shared<result>();
+	r->done_ = false;
+	std::shared_ptr<lookup> l = start(hostname, [this, r](const std::string&,
+		const std::vector<std::shared_ptr<net_address>>& addresses) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		r->done_ = true;
+		r->addresses_ = addresses;
+	});
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!r->done_) {
+		if (driving_) {
+			// another thread polls, it wakes us after every round
+			progress_.wait(lock);
+			continue;
+		}
+		driving_ = true;
+		int timeout = next_timeout(now_millis());
+		lock.unlock();
+		struct pollfd pfd = {};
+		pfd.fd = epfd_;
+		pfd.events = POLLIN;
+		::poll(&pfd, 1, timeout);
+		try {
+			process();
+		}
+		catch (...) {
+			lock.lock();
+			driving_ = false;
+			progress_.notify_all();
+			throw;
+		}
+		lock.lock();
+		driving_ = false;
+		progress_.notify_all();
+	}
+	if (r->addresses_.empty()) {
+		// an outage says nothing about the name, so it must not be
+		// mistaken for one which does not exist
+		if (!l->answered_)
+			throw socket_timeout_exception("No name server answered for " + hostname);
+		throw unknown_host_exception(hostname);
+	}
+	return r->addresses_;
+}
+
+void net::dns_resolver::install(resolver_cache& cache)
+{
+	cache.set_lookup([this](const std::string& hostname) {
+		return resolve(hostname);
+	});
+}
+
+int net::dns_resolver::process(void)
+{
+	std::vector<std::shared_ptr<lookup>> done;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		struct epoll_event events[max_events];
+		int count = ::epoll_wait(epfd_, events, max_events, 0);
+		std::uint64_t now = now_millis();
+		for (int i = 0; i < count; ++i) {
+			int fd = events[i].data.fd;
+			if (fd == udp4_fd_ || fd == udp6_fd_) {
+				if (events[i].events & EPOLLIN)
+					receive_udp(fd, now);
+				if (events[i].events & EPOLLOUT)
+					send_unsent(fd, now);
+			}
+			else
+				process_tcp(fd, events[i].events, now);
+		}
+		// timers are ordered by deadline, stale entries are skipped
+		while (!timers_.empty() && timers_.front().first <= now) {
+			std::shared_ptr<query> q = timers_.front().second;
+			std::uint64_t deadline = timers_.front().first;
+			timers_.pop_front();
+			if (!q->done_ && q->deadline_ == deadline)
+				retry(q, now);
+		}
+		while (!backlog_.empty() && queries_.size() < max_in_flight_) {
+			std::shared_ptr<query> q = backlog_.front();
+			backlog_.pop_front();
+			submit(q);
+		}
+		done.swap(completed_);
+	}
+	deliver(done);
+	if (!done.empty())
+		progress_.notify_all();
+	return static_cast<int>(done.size());
+}
+
+int net::dns_resolver::get_timeout(void)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return next_timeout(now_millis());
+}
+
+void net::dns_resolver::load_hosts(const std::string& path)
+{
+	std::ifstream in(path.c_str());
+	std::string line;
+	std::lock_guard<std::mutex> lock(mutex_);
+	while (std::getline(in, line)) {
+		std::string::size_type hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+		std::istringstream tokens(line);
+		std::string address;
+		if (!(tokens >> address))
+			continue;
+		std::vector<std::uint8_t> bytes;
+		std::uint8_t buf[16];
+		if (::inet_pton(AF_INET, address.c_str(), buf) == 1)
+			bytes.assign(buf, buf + 4);
+		else if (::inet_pton(AF_INET6, address.c_str(), buf) == 1)
+			bytes.assign(buf, buf + 16);
+		else
+			continue;
+		std::string name;
+		while (tokens >> name)
+			hosts_[normalize(name)].push_back(bytes);
+	}
+}
+
+void net::dns_resolver::add_host(const std::string& hostname,
+	const std::shared_ptr<net_address>& addr)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	hosts_[normalize(hostname)].push_back(addr->get_address());
+}
+
+void net::dns_resolver::set_max_in_flight(const std::size_t& count)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	max_in_flight_ = count > 0 ? count : 1;
+}
+
+void net::dns_resolver::open(void)
+{
+	if ((epfd_ = ::epoll_create1(EPOLL_CLOEXEC)) == -1)
+		throw socket_exception(sio::errno_exception("epoll_create1",
+			sio::socket_errno(errno)).what());
+}
+
+void net::dns_resolver::add_server(const socket_address& addr)
+{
+	std::shared_ptr<net_address> address = addr.get_address();
+	if (address == nullptr)
+		return;
+	name_server server = {};
+	if (address->get_family() == AF_INET) {
+		sio::sock_addr4 sa(address->get_address(), addr.get_port());
+		std::memcpy(&server.addr_, &sa, sizeof(struct sockaddr_in));
+		server.len_ = sizeof(struct sockaddr_in);
+	}
+	else {
+		sio::sock_addr6 sa(address->get_address(), addr.get_port());
+		std::memcpy(&server.addr_, &sa, sizeof(struct sockaddr_in6));
+		server.len_ = sizeof(struct sockaddr_in6);
+	}
+	servers_.push_back(server);
+}
+
+void net::dns_resolver::load_resolv_conf(const std::string& path)
+{
+	std::ifstream in(path.c_str());
+	std::string line;
+	while (std::getline(in, line)) {
+		std::string::size_type comment = line.find_first_of("#;");
+		if (comment != std::string::npos)
+			line.erase(comment);
+		std::istringstream tokens(line);
+		std::string keyword;
+		if (!(tokens >> keyword))
+			continue;
+		if (keyword == "nameserver") {
+			std::string address;
+			if (!(tokens >> address))
+				continue;
+			// drop an IPv6 zone, the servers are asked on the default route
+			std::string::size_type zone = address.find('%');
+			if (zone != std::string::npos)
+				address.erase(zone);
+			std::uint8_t buf[16];
+			if (::inet_pton(AF_INET, address.c_str(), buf) == 1)
+				add_server(socket_address(net_address::of(
+					std::vector<std::uint8_t>(buf, buf + 4)), 53));
+			else if (::inet_pton(AF_INET6, address.c_str(), buf) == 1)
+				add_server(socket_address(net_address::of(
+					std::vector<std::uint8_t>(buf, buf + 16)), 53));
+		}
+		else if (keyword == "options") {
+			std::string option;
+			while (tokens >> option) {
+				if (option.compare(0, 8, "timeout:") == 0)
+					timeout_ = std::max(1, std::atoi(option.c_str() + 8)) * 1000;
+				else if (option.compare(0, 9, "attempts:") == 0)
+					attempts_ = std::max(1, std::atoi(option.c_str() + 9));
+			}
+		}
+	}
+}
+
+bool net::dns_resolver::answer_locally(const std::shared_ptr<lookup>& l)
+{
+	std::uint8_t buf[16];
+	if (::inet_pton(AF_INET, l->hostname_.c_str(), buf) == 1) {
+		l->addresses_[0].push_back(std::vector<std::uint8_t>(buf, buf + 4));
+		return true;
+	}
+	if (::inet_pton(AF_INET6, l->hostname_.c_str(), buf) == 1) {
+		l->addresses_[1].push_back(std::vector<std::uint8_t>(buf, buf + 16));
+		return true;
+	}
+	auto it = hosts_.find(normalize(l->hostname_));
+	if (it == hosts_.end())
+		return false;
+	for (std::size_t i = 0; i < it->second.size(); ++i)
+		l->addresses_[it->second[i].size() == 4 ? 0 : 1].push_back(it->second[i]);
+	return true;
+}
+
+void net::dns_resolver::submit(const std::shared_ptr<query>& q)
+{
+	if (queries_.size() >= max_in_flight_ || queries_.size() >= 0xffff) {
+		backlog_.push_back(q);
+		return;
+	}
+	// random ids make spoofed answers harder to match
+	std::uniform_int_distribution<int> ids(0, 0xffff);
+	do {
+		q->id_ = static_cast<std::uint16_t>(ids(random_));
+	} while (queries_.find(q->id_) != queries_.end());
+	q->packet_[0] = static_cast<std::uint8_t>(q->id_ >> 8);
+	q->packet_[1] = static_cast<std::uint8_t>(q->id_);
+	q->server_ = static_cast<int>(q->id_ % servers_.size());
+	queries_[q->id_] = q;
+	send(q, now_millis());
+}
+
+void net::dns_resolver::send(const std::shared_ptr<query>& q, const std::uint64_t& now)
+{
+	const name_server& server = servers_[q->server_];
+	int fd = udp_socket(server.addr_.ss_family);
+	if (fd != -1) {
+		std::deque<std::shared_ptr<query>>& unsent =
+			unsent_[server.addr_.ss_family == AF_INET ? 0 : 1];
+		bool sent = unsent.empty() && ::sendto(fd, q->packet_.data(), q->packet_.size(),
+			MSG_NOSIGNAL, reinterpret_cast<const struct sockaddr*>(&server.addr_),
+			server.len_) != -1;
+		if (!sent && (!unsent.empty() || is_full(errno))) {
+			// a burst filled the send buffer, go on when it drains
+			if (unsent.empty())
+				watch(fd, EPOLLIN | EPOLLOUT);
+			unsent.push_back(q);
+			return;
+		}
+		if (sent) {
+			q->deadline_ = now + static_cast<std::uint64_t>(timeout_);
+			timers_.push_back(std::make_pair(q->deadline_, q));
+			return;
+		}
+	}
+	// no answer can come from a server the query did not reach, ask the
+	// next one at once
+	retry(q, now);
+}
+
+void net::dns_resolver::send_unsent(const int& fd, const std::uint64_t& now)
+{
+	std::deque<std::shared_ptr<query>>& unsent = unsent_[fd == udp4_fd_ ? 0 : 1];
+	while (!unsent.empty()) {
+		std::shared_ptr<query> q = unsent.front();
+		const name_server& server = servers_[q->server_];
+		int rc = (int) ::sendto(fd, q->packet_.data(), q->packet_.size(), MSG_NOSIGNAL,
+			reinterpret_cast<const struct sockaddr*>(&server.addr_), server.len_);
+		if (rc == -1 && is_full(errno))
+			return;
+		unsent.pop_front();
+		if (rc == -1) {
+			retry(q, now);
+			continue;
+		}
+		q->deadline_ = now + static_cast<std::uint64_t>(timeout_);
+		timers_.push_back(std::make_pair(q->deadline_, q));
+	}
+	watch(fd, EPOLLIN);
+}
+
+void net::dns_resolver::retry(const std::shared_ptr<query>& q, const std::uint64_t& now)
+{
+	close_tcp(q);
+	if (++q->tries_ >= attempts_ * static_cast<int>(servers_.size())) {
+		finish(q, std::vector<std::vector<std::uint8_t>>());
+		return;
+	}
+	q->server_ = (q->server_ + 1) % static_cast<int>(servers_.size());
+	send(q, now);
+}
+
+void net::dns_resolver::finish(const std::shared_ptr<query>& q,
+	const std::vector<std::vector<std::uint8_t>>& addresses)
+{
+	close_tcp(q);
+	q->done_ = true;
+	queries_.erase(q->id_);
+	lookup& l = *q->lookup_;
+	std::vector<std::vector<std::uint8_t>>& target =
+		l.addresses_[q->type_ == type_a ? 0 : 1];
+	target.insert(target.end(), addresses.begin(), addresses.end());
+	if (--l.pending_ == 0)
+		completed_.push_back(q->lookup_);
+	if (!backlog_.empty() && queries_.size() < max_in_flight_) {
+		std::shared_ptr<query> next = backlog_.front();
+		backlog_.pop_front();
+		submit(next);
+	}
+}
+
+void net::dns_resolver::receive_udp(const int& fd, const std::uint64_t& now)
+{
+	for (;;) {
+		struct sockaddr_storage from;
+		socklen_t len = sizeof(from);
+		ssize_t size = ::recvfrom(fd, buffer_.data(), buffer_.size(), MSG_DONTWAIT,
+			reinterpret_cast<struct sockaddr*>(&from), &len);
+		if (size == -1) {
+			if (errno == EINTR)
+				continue;
+			return;		// drained, or an ICMP error for an earlier send
+		}
+		if (static_cast<std::size_t>(size) < header_size)
+			continue;
+		std::uint16_t id = static_cast<std::uint16_t>((buffer_[0] << 8) | buffer_[1]);
+		auto it = queries_.find(id);
+		if (it == queries_.end())
+			continue;
+		std::shared_ptr<query> q = it->second;
+		if (q->tcp_fd_ != -1 || !is_from(servers_[q->server_], from))
+			continue;
+		handle_answer(q, buffer_.data(), static_cast<std::size_t>(size), false, now);
+	}
+}
+
+void net::dns_resolver::start_tcp(const std::shared_ptr<query>& q, const std::uint64_t& now)
+{
+	const name_server& server = servers_[q->server_];
+	int fd = ::socket(server.addr_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1) {
+		retry(q, now);
+		return;
+	}
+	if (::connect(fd, reinterpret_cast<const struct sockaddr*>(&server.addr_),
+			server.len_) == -1 && errno != EINPROGRESS) {
+		::close(fd);
+		retry(q, now);
+		return;
+	}
+	struct epoll_event ev = {};
+	ev.events = EPOLLOUT | EPOLLIN;
+	ev.data.fd = fd;
+	if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		::close(fd);
+		retry(q, now);
+		return;
+	}
+	// over TCP the message is preceded by its length
+	q->tcp_fd_ = fd;
+	q->tcp_buffer_.clear();
+	q->tcp_buffer_.push_back(static_cast<std::uint8_t>(q->packet_.size() >> 8));
+	q->tcp_buffer_.push_back(static_cast<std::uint8_t>(q->packet_.size()));
+	q->tcp_buffer_.insert(q->tcp_buffer_.end(), q->packet_.begin(), q->packet_.end());
+	q->tcp_sent_ = 0;
+	tcp_queries_[fd] = q;
+	q->deadline_ = now + static_cast<std::uint64_t>(timeout_);
+	timers_.push_back(std::make_pair(q->deadline_, q));
+}
+
+void net::dns_resolver::process_tcp(const int& fd, const std::uint32_t& events,
+	const std::uint64_t& now)
+{
+	auto it = tcp_queries_.find(fd);
+	if (it == tcp_queries_.end())
+		return;
+	std::shared_ptr<query> q = it->second;
+	std::size_t length = q->packet_.size() + 2;
+	if (q->tcp_sent_ < length && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+		while (q->tcp_sent_ < q->tcp_buffer_.size()) {
+			ssize_t count = ::send(fd, q->tcp_buffer_.data() + q->tcp_sent_,
+				q->tcp_buffer_.size() - q->tcp_sent_, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if (count > 0) {
+				q->tcp_sent_ += static_cast<std::size_t>(count);
+				continue;
+			}
+			if (count == -1 && errno == EINTR)
+				continue;
+			if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				return;
+			retry(q, now);	// refused or reset
+			return;
+		}
+		// sent: the buffer now collects the answer
+		q->tcp_buffer_.clear();
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+	}
+	if (q->tcp_sent_ < length)
+		return;
+	for (;;) {
+		std::uint8_t chunk[4096];
+		ssize_t count = ::recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+		if (count > 0) {
+			q->tcp_buffer_.insert(q->tcp_buffer_.end(), chunk, chunk + count);
+			if (q->tcp_buffer_.size() < 2)
+				continue;
+			std::size_t size = (static_cast<std::size_t>(q->tcp_buffer_[0]) << 8) |
+				q->tcp_buffer_[1];
+			if (q->tcp_buffer_.size() < size + 2)
+				continue;
+			std::vector<std::uint8_t> message(q->tcp_buffer_.begin() + 2,
+				q->tcp_buffer_.begin() + 2 + size);
+			close_tcp(q);
+			handle_answer(q, message.data(), message.size(), true, now);
+			return;
+		}
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		retry(q, now);	// closed before the whole answer arrived
+		return;
+	}
+}
+
+void net::dns_resolver::close_tcp(const std::shared_ptr<query>& q)
+{
+	if (q->tcp_fd_ == -1)
+		return;
+	::epoll_ctl(epfd_, EPOLL_CTL_DEL, q->tcp_fd_, nullptr);
+	::close(q->tcp_fd_);
+	tcp_queries_.erase(q->tcp_fd_);
+	q->tcp_fd_ = -1;
+	q->tcp_buffer_.clear();
+	q->tcp_sent_ = 0;
+}
+
+void net::dns_resolver::handle_answer(const std::shared_ptr<query>& q,
+	const std::uint8_t* data, const std::size_t& size, const bool& over_tcp,
+	const std::uint64_t& now)
+{
+	std::vector<std::vector<std::uint8_t>> addresses;
+	switch (parse_answer(*q, data, size, addresses)) {
+	case answer_ok:
+		q->lookup_->answered_ = true;
+		finish(q, addresses);
+		break;
+	case answer_truncated:
+		if (over_tcp) {
+			q->lookup_->answered_ = true;
+			finish(q, addresses);
+		}
+		else
+			start_tcp(q, now);
+		break;
+	case answer_retry:
+		retry(q, now);
+		break;
+	case answer_ignore:
+		break;
+	}
+}
+
+int net::dns_resolver::udp_socket(const int& family)
+{
+	int& fd = family == AF_INET ? udp4_fd_ : udp6_fd_;
+	if (fd != -1)
+		return fd;
+	fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return -1;
+	// room for the bursts of a large batch, as far as the limits allow
+	int size = 1024 * 1024;
+	::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		::close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+void net::dns_resolver::watch(const int& fd, const std::uint32_t& events)
+{
+	struct epoll_event ev = {};
+	ev.events = events;
+	ev.data.fd = fd;
+	::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+}
+
+int net::dns_resolver::next_timeout(const std::uint64_t& now) const
+{
+	if (!completed_.empty())
+		return 0;
+	if (timers_.empty())
+		return -1;
+	std::uint64_t deadline = timers_.front().first;
+	return deadline <= now ? 0 : static_cast<int>(deadline - now);
+}
+
+void net::dns_resolver::deliver(const std::vector<std::shared_ptr<lookup>>& done)
+{
+	for (std::size_t i = 0; i < done.size(); ++i) {
+		lookup& l = *done[i];
+		std::vector<std::shared_ptr<net_address>> addresses;
+		for (int family = 0; family < 2; ++family) {
+			for (std::size_t j = 0; j < l.addresses_[family].size(); ++j)
+				addresses.push_back(net_address::of(l.addresses_[family][j]));
+		}
+		if (l.handler_ != nullptr)
+			l.handler_(l.hostname_, addresses);
+	}
+}
+
+bool net::dns_resolver::encode_query(const std::string& hostname,
+	const std::uint16_t& type, std::vector<std::uint8_t>& packet)
+{
+	if (hostname.empty() || hostname.size() > 253)
+		return false;
+	// id, recursion desired, one question
+	const std::uint8_t header[header_size] = { 0, 0, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0 };
+	packet.assign(header, header + header_size);
+	std::string::size_type begin = 0;
+	while (begin <= hostname.size()) {
+		std::string::size_type end = hostname.find('.', begin);
+		if (end == std::string::npos)
+			end = hostname.size();
+		std::size_t length = end - begin;
+		if (length == 0 || length > 63)
+			return false;
+		packet.push_back(static_cast<std::uint8_t>(length));
+		packet.insert(packet.end(), hostname.begin() + begin, hostname.begin() + end);
+		begin = end + 1;
+	}
+	packet.push_back(0);
+	packet.push_back(static_cast<std::uint8_t>(type >> 8));
+	packet.push_back(static_cast<std::uint8_t>(type));
+	packet.push_back(static_cast<std::uint8_t>(class_in >> 8));
+	packet.push_back(static_cast<std::uint8_t>(class_in));
+	return true;
+}
+
+net::dns_resolver::answer net::dns_resolver::parse_answer(const query& q,
+	const std::uint8_t* data, const std::size_t& size,
+	std::vector<std::vector<std::uint8_t>>& addresses)
+{
+	if (size < header_size || (data[2] & 0x80) == 0)
+		return answer_ignore;			// not a response
+	int qdcount = (data[4] << 8) | data[5];
+	int ancount = (data[6] << 8) | data[7];
+	if (qdcount != 1)
+		return answer_ignore;
+	std::size_t offset = header_size;
+	std::string name;
+	if (!read_name(data, size, offset, &name) || offset + 4 > size)
+		return answer_ignore;
+	std::uint16_t type = static_cast<std::uint16_t>((data[offset] << 8) | data[offset + 1]);
+	offset += 4;
+	// the question must be ours, otherwise the packet answers something else
+	std::string asked;
+	std::size_t asked_offset = header_size;
+	read_name(q.packet_.data(), q.packet_.size(), asked_offset, &asked);
+	if (type != q.type_ || normalize(name) != asked)
+		return answer_ignore;
+	if (data[2] & 0x02)
+		return answer_truncated;
+	switch (data[3] & 0x0f) {
+	case 0:				// no error
+		break;
+	case 3:				// no such name
+		return answer_ok;
+	default:			// server failure, refused, ...
+		return answer_retry;
+	}
+	for (int i = 0; i < ancount; ++i) {
+		if (!read_name(data, size, offset, nullptr) || offset + 10 > size)
+			return answer_retry;
+		std::uint16_t rtype = static_cast<std::uint16_t>((data[offset] << 8) | data[offset + 1]);
+		std::uint16_t rclass = static_cast<std::uint16_t>((data[offset + 2] << 8) | data[offset + 3]);
+		std::size_t rdlength = (static_cast<std::size_t>(data[offset + 8]) << 8) | data[offset + 9];
+		offset += 10;
+		if (offset + rdlength > size)
+			return answer_retry;
+		// aliases come first, the records of the final name follow
+		if (rtype == q.type_ && rclass == class_in &&
+				rdlength == (q.type_ == type_a ? 4u : 16u))
+			addresses.push_back(std::vector<std::uint8_t>(data + offset,
+				data + offset + rdlength));
+		offset += rdlength;
+	}
+	return answer_ok;
+}
+
+bool net::dns_resolver::read_name(const std::uint8_t* data, const std::size_t& size,
+	std::size_t& offset, std::string* name)
+{
+	std::size_t position = offset;
+	bool jumped = false;
+	for (int labels = 0; labels < 128; ++labels) {
+		if (position >= size)
+			return false;
+		std::uint8_t length = data[position];
+		if ((length & 0xc0) == 0xc0) {
+			// compressed: the rest of the name is elsewhere in the message
+			if (position + 1 >= size)
+				return false;
+			if (!jumped)
+				offset = position + 2;
+			jumped = true;
+			position = (static_cast<std::size_t>(length & 0x3f) << 8) | data[position + 1];
+			continue;
+		}
+		if ((length & 0xc0) != 0)
+			return false;
+		if (length == 0) {
+			if (!jumped)
+				offset = position + 1;
+			return true;
+		}
+		if (position + 1 + length > size)
+			return false;
+		if (name != nullptr) {
+			if (!name->empty())
+				name->push_back('.');
+			name->append(reinterpret_cast<const char*>(data + position + 1), length);
+		}
+		position += 1 + length;
+	}
+	return false;
+}
+
+bool net::dns_resolver::is_full(const int& error)
+{
+	return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS;
+}
+
+bool net::dns_resolver::is_from(const name_server& server,
+	const struct sockaddr_storage& addr)
+{
+	if (server.addr_.ss_family != addr.ss_family)
+		return false;
+	if (addr.ss_family == AF_INET) {
+		const struct sockaddr_in& a = reinterpret_cast<const struct sockaddr_in&>(server.addr_);
+		const struct sockaddr_in& b = reinterpret_cast<const struct sockaddr_in&>(addr);
+		return a.sin_port == b.sin_port && a.sin_addr.s_addr == b.sin_addr.s_addr;
+	}
+	const struct sockaddr_in6& a = reinterpret_cast<const struct sockaddr_in6&>(server.addr_);
+	const struct sockaddr_in6& b = reinterpret_cast<const struct sockaddr_in6&>(addr);
+	return a.sin6_port == b.sin6_port &&
+		std::memcmp(&a.sin6_addr, &b.sin6_addr, sizeof(a.sin6_addr)) == 0;
+}
+
+std::string net::dns_resolver::normalize(const std::string& hostname)
+{
+	std::string name(hostname);
+	if (!name.empty() && name[name.size() - 1] == '.')
+		name.erase(name.size() - 1);
+	for (std::size_t i = 0; i < name.size(); ++i)
+		name[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+	return name;
+}
+
+std::uint64_t net::dns_resolver::now_millis(void)
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.dns_resolver.inl"
+#endif
+
+#endif
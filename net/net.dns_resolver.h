@@ -0,0 +1,229 @@
+#ifndef __NET_DNS_RESOLVER__
+#define __NET_DNS_RESOLVER__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/socket.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "net.net_address.h"
+#include "net.resolver_cache.h"
+#include "net.socket_address.h"
+
+namespace net
+{
+	/**
+	* Asynchronous stub resolver. Names are answered from the hosts file or
+	* by sending A and AAAA queries over UDP to the configured name servers,
+	* many queries in flight at once on one socket per address family.
+	* Unanswered queries are retried on the next server and truncated
+	* answers are fetched again over TCP.
+	*
+	* The resolver does not own a thread: register get_descriptor() with a
+	* readiness loop, call process() when it is readable or when
+	* get_timeout() milliseconds have passed, or let resolve() drive it.
+	*/
+	class dns_resolver
+	{
+	public:
+		/**
+		* Invoked once per name with its addresses, IPv4 first. The list is
+		* empty if the name does not exist or no server answered.
+		*/
+		typedef std::function<void(const std::string&,
+			const std::vector<std::shared_ptr<net_address>>&)> resolve_handler;
+	private:
+		enum answer
+		{
+			answer_ok,
+			answer_truncated,
+			answer_retry,
+			answer_ignore
+		};
+		struct lookup
+		{
+			std::string hostname_;
+			resolve_handler handler_;
+			std::vector<std::vector<std::uint8_t>> addresses_[2];
+			int pending_;
+			bool answered_;		// a server, the hosts file or the name itself
+		};
+		struct query
+		{
+			std::shared_ptr<lookup> lookup_;
+			std::uint16_t id_;
+			std::uint16_t type_;
+			std::vector<std::uint8_t> packet_;
+			std::uint64_t deadline_;
+			int server_;
+			int tries_;
+			bool done_;
+			int tcp_fd_;				// -1 unless the answer is read over TCP
+			std::vector<std::uint8_t> tcp_buffer_;
+			std::size_t tcp_sent_;
+		};
+		struct name_server
+		{
+			struct sockaddr_storage addr_;
+			socklen_t len_;
+		};
+		std::vector<name_server> servers_;
+		int timeout_;
+		int attempts_;
+		std::size_t max_in_flight_;
+		std::unordered_map<std::string, std::vector<std::vector<std::uint8_t>>> hosts_;
+		int epfd_;
+		int udp4_fd_;
+		int udp6_fd_;
+		std::mutex mutex_;
+		std::condition_variable progress_;
+		bool driving_;
+		std::mt19937 random_;
+		std::unordered_map<std::uint16_t, std::shared_ptr<query>> queries_;
+		std::unordered_map<int, std::shared_ptr<query>> tcp_queries_;
+		std::deque<std::shared_ptr<query>> backlog_;
+		std::deque<std::shared_ptr<query>> unsent_[2];
+		std::deque<std::pair<std::uint64_t, std::shared_ptr<query>>> timers_;
+		std::vector<std::shared_ptr<lookup>> completed_;
+		std::vector<std::uint8_t> buffer_;
+	public:
+		/**
+		* Creates a resolver configured from /etc/resolv.conf, honouring its
+		* nameserver lines and the timeout and attempts options, which
+		* answers the names listed in /etc/hosts itself.
+		*/
+		dns_resolver(void);
+
+		/**
+		* Creates a resolver asking servers, waiting timeout milliseconds
+		* for each answer and trying every server attempts times. No hosts
+		* file is read.
+		*/
+		dns_resolver(const std::vector<socket_address>& servers,
+			const int& timeout = 2000, const int& attempts = 2);
+	public:
+		virtual ~dns_resolver(void);
+	public:
+		/**
+		* Starts resolving hostname and returns immediately. The handler is
+		* called from process(), or before resolve_async returns when the
+		* name is numeric or listed in the hosts file. Handlers of names
+		* still pending when the resolver is destroyed are not called.
+		*/
+		void resolve_async(const std::string& hostname, const resolve_handler& handler);
+
+		/**
+		* Resolves hostname and waits for the answer, throwing
+		* unknown_host_exception if it has no addresses, or
+		* socket_timeout_exception if no server answered at all. Any number
+		* of threads may wait at once, one of them drives the resolver.
+		*/
+		std::vector<std::shared_ptr<net_address>> resolve(const std::string& hostname);
+
+		/**
+		* Makes cache pass the names it misses to this resolver, which must
+		* outlive it.
+		*/
+		void install(resolver_cache& cache = resolver_cache::get_default());
+
+		/**
+		* Reads the answers which arrived, retries the queries which timed
+		* out and calls the handlers of the names which completed. Never
+		* blocks. Returns the number of names completed.
+		*/
+		int process(void);
+
+		/**
+		* Returns the number of milliseconds after which process() must be
+		* called even if the descriptor did not become readable, or -1 if
+		* nothing is pending.
+		*/
+		int get_timeout(void);
+
+		/**
+		* Reads the hosts file at path, adding its names.
+		*/
+		void load_hosts(const std::string& path);
+
+		/**
+		* Answers hostname with addr without asking a server.
+		*/
+		void add_host(const std::string& hostname, const std::shared_ptr<net_address>& addr);
+
+		/**
+		* Sets the number of queries sent but not yet answered above which
+		* new queries wait.
+		*/
+		void set_max_in_flight(const std::size_t& count);
+	public:
+		/**
+		* Returns a descriptor which becomes readable when process() has
+		* work to do.
+		*/
+		NET_INLINE int get_descriptor(void) const;
+
+		/**
+		* Returns the number of name servers asked.
+		*/
+		NET_INLINE std::size_t get_server_count(void) const;
+	private:
+		void open(void);
+		void add_server(const socket_address& addr);
+		void load_resolv_conf(const std::string& path);
+		std::shared_ptr<lookup> start(const std::string& hostname,
+			const resolve_handler& handler);
+		bool answer_locally(const std::shared_ptr<lookup>& l);
+		void submit(const std::shared_ptr<query>& q);
+		void send(const std::shared_ptr<query>& q, const std::uint64_t& now);
+		void send_unsent(const int& fd, const std::uint64_t& now);
+		void retry(const std::shared_ptr<query>& q, const std::uint64_t& now);
+		void finish(const std::shared_ptr<query>& q,
+			const std::vector<std::vector<std::uint8_t>>& addresses);
+		void receive_udp(const int& fd, const std::uint64_t& now);
+		void start_tcp(const std::shared_ptr<query>& q, const std::uint64_t& now);
+		void process_tcp(const int& fd, const std::uint32_t& events, const std::uint64_t& now);
+		void close_tcp(const std::shared_ptr<query>& q);
+		void handle_answer(const std::shared_ptr<query>& q, const std::uint8_t* data,
+			const std::size_t& size, const bool& over_tcp, const std::uint64_t& now);
+		int udp_socket(const int& family);
+		void watch(const int& fd, const std::uint32_t& events);
+		int next_timeout(const std::uint64_t& now) const;
+		static void deliver(const std::vector<std::shared_ptr<lookup>>& done);
+		static bool encode_query(const std::string& hostname, const std::uint16_t& type,
+			std::vector<std::uint8_t>& packet);
+		static answer parse_answer(const query& q, const std::uint8_t* data,
+			const std::size_t& size, std::vector<std::vector<std::uint8_t>>& addresses);
+		static bool read_name(const std::uint8_t* data, const std::size_t& size,
+			std::size_t& offset, std::string* name);
+		static bool is_full(const int& error);
+		static bool is_from(const name_server& server,
+			const struct sockaddr_storage& addr);
+		static std::string normalize(const std::string& hostname);
+		static std::uint64_t now_millis(void);
+	private:
+		dns_resolver(const dns_resolver&);
+		dns_resolver& operator=(const dns_resolver&);
+		dns_resolver& operator=(const dns_resolver&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.dns_resolver.inl"
+#endif
+
+#endif
+
+#endif
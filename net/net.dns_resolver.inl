@@ -0,0 +1,9 @@
+NET_INLINE int net::dns_resolver::get_descriptor(void) const
+{
+	return epfd_;
+}
+
+NET_INLINE std::size_t net::dns_resolver::get_server_count(void) const
+{
+	return servers_.size();
+}
@@ -0,0 +1,79 @@
+#include "net.address_text.h"
+#include "net.endpoint.h"
+
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<net::endpoint>::value,
+	"endpoint must be trivially copyable");
+
+net::endpoint::endpoint(void)
+{
+	std::memset(&addr_, 0, sizeof(addr_));
+	addr_.sa_.sa_family = AF_UNSPEC;
+}
+
+net::endpoint::endpoint(const ip_address& addr, const std::uint16_t& port)
+{
+	std::memset(&addr_, 0, sizeof(addr_));
+	if (addr.get_family() == AF_INET6) {
+		addr_.in6_.sin6_family = AF_INET6;
+		std::memcpy(&addr_.in6_.sin6_addr, addr.get_bytes(), 16);
+	}
+	else {
+		addr_.in4_.sin_family = AF_INET;
+		std::memcpy(&addr_.in4_.sin_addr, addr.get_bytes(), 4);
+	}
+	set_port(port);
+}
+
+net::endpoint::endpoint(const sio::sockaddr_t* sa, const int& len)
+{
+	std::memset(&addr_, 0, sizeof(addr_));
+	addr_.sa_.sa_family = AF_UNSPEC;
+	if (sa == nullptr)
+		return;
+	if (sa->sa_family == AF_INET && len >= static_cast<int>(sizeof(addr_.in4_)))
+		std::memcpy(&addr_.in4_, sa, sizeof(addr_.in4_));
+	else if (sa->sa_family == AF_INET6 && len >= static_cast<int>(sizeof(addr_.in6_)))
+		std::memcpy(&addr_.in6_, sa, sizeof(addr_.in6_));
+}
+
+net::endpoint::endpoint(const socket_address& addr)
+{
+	std::memset(&addr_, 0, sizeof(addr_));
+	addr_.sa_.sa_family = AF_UNSPEC;
+	std::shared_ptr<net_address> address = addr.get_address();
+	if (address == nullptr)
+		throw unknown_host_exception(addr.get_host_name());
+	*this = endpoint(ip_address(*address), addr.get_port());
+}
+
+std::string net::endpoint::to_string(void) const
+{
+	char text[max_text_length];
+	return std::string(text, format(text));
+}
+
+char* net::endpoint::format(char* out) const
+{
+	if (addr_.sa_.sa_family == AF_INET6) {
+		*out++ = '[';
+		out = get_address().format(out);
+		*out++ = ']';
+	}
+	else
+		out = get_address().format(out);
+	*out++ = ':';
+	return address_text::format_decimal(get_port(), out);
+}
+
+net::socket_address net::endpoint::to_socket_address(void) const
+{
+	if (is_unspecified())
+		return socket_address(get_port());
+	return socket_address(get_address().to_net_address(), get_port());
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.endpoint.inl"
+#endif
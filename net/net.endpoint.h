@@ -0,0 +1,143 @@
+#ifndef __NET_ENDPOINT__
+#define __NET_ENDPOINT__
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "sio.h"
+#include "net.config.h"
+#include "net.ip_address.h"
+#include "net.socket_address.h"
+
+namespace net
+{
+	/**
+	* An IP address and port held by value as the native sockaddr, so it
+	* is passed to the system without conversion. It is trivially copyable
+	* and compares and hashes cheaply. An endpoint created by the default
+	* constructor is unspecified.
+	*/
+	class endpoint
+	{
+		union storage
+		{
+			sio::sockaddr_t sa_;
+			struct sockaddr_in in4_;
+			struct sockaddr_in6 in6_;
+		} addr_;
+	public:
+		/**
+		* Longest text written by format.
+		*/
+		static const int max_text_length = ip_address::max_text_length + 8;
+	public:
+		/**
+		* Creates an unspecified endpoint.
+		*/
+		endpoint(void);
+
+		/**
+		* Creates an endpoint from an address and a port number.
+		*/
+		endpoint(const ip_address& addr, const std::uint16_t& port);
+
+		/**
+		* Creates an endpoint from a native socket address of len bytes.
+		*/
+		endpoint(const sio::sockaddr_t* sa, const int& len);
+
+		/**
+		* Creates an endpoint from a resolved socket_address.
+		*/
+		explicit endpoint(const socket_address& addr);
+	public:
+		/**
+		* Returns the endpoint in the form address:port, with IPv6
+		* addresses in brackets.
+		*/
+		std::string to_string(void) const;
+
+		/**
+		* Writes the endpoint as to_string does to out, which must have room
+		* for max_text_length characters, and returns the end of the text.
+		* No terminating null is written.
+		*/
+		char* format(char* out) const;
+
+		/**
+		* Returns an equal socket_address.
+		*/
+		socket_address to_socket_address(void) const;
+	public:
+		/**
+		* Returns AF_INET, AF_INET6, or AF_UNSPEC if unspecified.
+		*/
+		NET_INLINE int get_family(void) const;
+
+		/**
+		* Tests if the endpoint was never given an address.
+		*/
+		NET_INLINE bool is_unspecified(void) const;
+
+		/**
+		* Returns the address of the endpoint.
+		*/
+		NET_INLINE ip_address get_address(void) const;
+
+		/**
+		* Returns the port number of the endpoint.
+		*/
+		NET_INLINE std::uint16_t get_port(void) const;
+
+		/**
+		* Sets the port number of the endpoint.
+		*/
+		NET_INLINE void set_port(const std::uint16_t& port);
+
+		/**
+		* Returns the native socket address.
+		*/
+		NET_INLINE const sio::sockaddr_t* data(void) const;
+		NET_INLINE sio::sockaddr_t* data(void);
+
+		/**
+		* Returns the length of the native socket address.
+		*/
+		NET_INLINE int size(void) const;
+
+		/**
+		* Returns the room for a native socket address, to be passed to
+		* calls which fill it.
+		*/
+		NET_INLINE static int capacity(void);
+
+		/**
+		* Returns a hash of the address and port.
+		*/
+		NET_INLINE std::size_t hash(void) const;
+	public:
+		NET_INLINE bool operator==(const endpoint& other) const;
+		NET_INLINE bool operator!=(const endpoint& other) const;
+		NET_INLINE bool operator<(const endpoint& other) const;
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<net::endpoint>
+	{
+		std::size_t operator()(const net::endpoint& ep) const
+		{
+			return ep.hash();
+		}
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.endpoint.inl"
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+NET_INLINE int net::endpoint::get_family(void) const
+{
+	return addr_.sa_.sa_family;
+}
+
+NET_INLINE bool net::endpoint::is_unspecified(void) const
+{
+	return addr_.sa_.sa_family != AF_INET && addr_.sa_.sa_family != AF_INET6;
+}
+
+NET_INLINE net::ip_address net::endpoint::get_address(void) const
+{
+	if (addr_.sa_.sa_family == AF_INET6)
+		return ip_address(reinterpret_cast<const std::uint8_t*>(&addr_.in6_.sin6_addr), 16);
+	if (addr_.sa_.sa_family == AF_INET)
+		return ip_address(reinterpret_cast<const std::uint8_t*>(&addr_.in4_.sin_addr), 4);
+	return ip_address();
+}
+
+NET_INLINE std::uint16_t net::endpoint::get_port(void) const
+{
+	// sin_port and sin6_port share their offset
+	return ntohs(addr_.in4_.sin_port);
+}
+
+NET_INLINE void net::endpoint::set_port(const std::uint16_t& port)
+{
+	addr_.in4_.sin_port = htons(port);
+}
+
+NET_INLINE const sio::sockaddr_t* net::endpoint::data(void) const
+{
+	return &addr_.sa_;
+}
+
+NET_INLINE sio::sockaddr_t* net::endpoint::data(void)
+{
+	return &addr_.sa_;
+}
+
+NET_INLINE int net::endpoint::size(void) const
+{
+	return addr_.sa_.sa_family == AF_INET6 ?
+		static_cast<int>(sizeof(addr_.in6_)) : static_cast<int>(sizeof(addr_.in4_));
+}
+
+NET_INLINE int net::endpoint::capacity(void)
+{
+	return static_cast<int>(sizeof(storage));
+}
+
+NET_INLINE std::size_t net::endpoint::hash(void) const
+{
+	std::size_t h = get_address().hash();
+	return h ^ (static_cast<std::size_t>(get_port()) * 0x9e3779b97f4a7c15ULL);
+}
+
+NET_INLINE bool net::endpoint::operator==(const endpoint& other) const
+{
+	if (addr_.sa_.sa_family != other.addr_.sa_.sa_family ||
+			addr_.in4_.sin_port != other.addr_.in4_.sin_port)
+		return false;
+	if (addr_.sa_.sa_family == AF_INET)
+		return addr_.in4_.sin_addr.s_addr == other.addr_.in4_.sin_addr.s_addr;
+	if (addr_.sa_.sa_family == AF_INET6)
+		return addr_.in6_.sin6_scope_id == other.addr_.in6_.sin6_scope_id &&
+			std::memcmp(&addr_.in6_.sin6_addr, &other.addr_.in6_.sin6_addr,
+				sizeof(addr_.in6_.sin6_addr)) == 0;
+	return true;
+}
+
+NET_INLINE bool net::endpoint::operator!=(const endpoint& other) const
+{
+	return !(*this == other);
+}
+
+NET_INLINE bool net::endpoint::operator<(const endpoint& other) const
+{
+	ip_address a = get_address();
+	ip_address b = other.get_address();
+	if (a != b)
+		return a < b;
+	if (get_port() != other.get_port())
+		return get_port() < other.get_port();
+	// the address carries no scope, which operator== compares as well
+	return addr_.sa_.sa_family == AF_INET6 &&
+		addr_.in6_.sin6_scope_id < other.addr_.in6_.sin6_scope_id;
+}
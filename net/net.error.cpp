@@ -0,0 +1,33 @@
+#include "net.error.h"
+
+namespace
+{
+	class socket_error_category : public std::error_category
+	{
+	public:
+		const char* name(void) const noexcept
+		{
+			return "net.socket";
+		}
+
+		std::string message(int value) const
+		{
+			return std::generic_category().message(value);
+		}
+
+		std::error_condition default_error_condition(int value) const noexcept
+		{
+			return std::error_condition(value, std::generic_category());
+		}
+	};
+}
+
+const std::error_category& net::socket_category(void) noexcept
+{
+	static const socket_error_category category;
+	return category;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.error.inl"
+#endif
@@ -0,0 +1,31 @@
+#ifndef __NET_ERROR__
+#define __NET_ERROR__
+
+#include "net.config.h"
+
+#include <string>
+#include <system_error>
+
+namespace net
+{
+	/**
+	* Gets the category of the error codes set by the std::error_code
+	* overloads. Values are errno values as the socket layer reports them,
+	* on Windows too, so codes compare equal to the std::errc conditions:
+	* a timeout is std::errc::timed_out, a reset peer
+	* std::errc::connection_reset and a closed socket
+	* std::errc::bad_file_descriptor.
+	*/
+	const std::error_category& socket_category(void) noexcept;
+
+	/**
+	* Makes an error code of socket_category from an errno value.
+	*/
+	NET_INLINE std::error_code make_socket_error(const int& error) noexcept;
+}
+
+#if defined(__NET_INLINE__)
+#include "net.error.inl"
+#endif
+
+#endif
@@ -0,0 +1,4 @@
+NET_INLINE std::error_code net::make_socket_error(const int& error) noexcept
+{
+	return std::error_code(error, socket_category());
+}
@@ -0,0 +1,276 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "net.exceptions.h"
+#include "net.event_loop.h"
+
+const int net::event_loop::accept_retry_delay;
+
+net::event_loop::event_loop(const int& max_events, const int& buffer_size)
+	: epfd_(-1)
+	, wakefd_(-1)
+	, stopped_(false)
+	, entries_()
+	, events_(max_events > 0 ? max_events : 256)
+	, buffer_(buffer_size > 0 ? buffer_size : 65536)
+	, timers_()
+	, idle_timeout_(0)
+{
+	try {
+		if ((epfd_ = ::epoll_create1(EPOLL_CLOEXEC)) == -1)
+			throw sio::errno_exception("epoll_create1", sio::socket_errno(errno));
+		if ((wakefd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+			throw sio::errno_exception("eventfd", sio::socket_errno(errno));
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = wakefd_;
+		if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, wakefd_, &ev) == -1)
+			throw sio::errno_exception("epoll_ctl", sio::socket_errno(errno));
+	}
+	catch (const sio::errno_exception& e) {
+		if (wakefd_ != -1)
+			::close(wakefd_);
+		if (epfd_ != -1)
+			::close(epfd_);
+		throw socket_exception(e.what());
+	}
+}
+
+net::event_loop::~event_loop(void)
+{
+	::close(wakefd_);
+	::close(epfd_);
+}
+
+void net::event_loop::add(const std::shared_ptr<net::socket>& sock,
+	const read_handler& on_read, const write_handler& on_write,
+	const close_handler& on_close)
+{
+	if (sock == nullptr || !sock->is_connected() || sock->is_closed())
+		throw socket_exception("Socket is not connected");
+	std::shared_ptr<entry> e = std::make_shared<entry>();
+	e->sock_ = sock;
+	e->on_read_ = on_read;
+	e->on_write_ = on_write;
+	e->on_close_ = on_close;
+	e->idle_ = 0;
+	e->retry_ = 0;
+	std::uint32_t events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	if (on_write != nullptr)
+		events |= EPOLLOUT;
+	int fd = sock->get_impl()->get_native_socket();
+	add(fd, e, events);
+	if (idle_timeout_ > 0) {
+		event_loop* loop = this;
+		e->idle_ = timers_.schedule(idle_timeout_, [loop, fd](void) { loop->reap(fd); });
+	}
+}
+
+void net::event_loop::add(const std::shared_ptr<net::server_socket>& server,
+	const accept_handler& on_accept, const accept_error_handler& on_accept_error)
+{
+	if (server == nullptr || !server->is_bound() || server->is_closed())
+		throw socket_exception("Socket is not bound");
+	std::shared_ptr<entry> e = std::make_shared<entry>();
+	e->server_ = server;
+	e->on_accept_ = on_accept;
+	e->on_accept_error_ = on_accept_error;
+	e->idle_ = 0;
+	e->retry_ = 0;
+	server->set_non_blocking(true);
+	add(server->get_impl()->get_native_socket(), e, EPOLLIN | EPOLLET);
+}
+
+void net::event_loop::remove(const std::shared_ptr<net::socket>& sock)
+{
+	sio::socket_t fd = sock->get_impl()->get_native_socket();
+	if (fd != sio::invalid_socket) {
+		remove(fd);
+		return;
+	}
+	// already closed: the kernel dropped the registration with the descriptor
+	for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+		if (it->second->sock_ == sock) {
+			timers_.cancel(it->second->idle_);
+			timers_.cancel(it->second->retry_);
+			entries_.erase(it);
+			return;
+		}
+	}
+}
+
+void net::event_loop::remove(const std::shared_ptr<net::server_socket>& server)
+{
+	sio::socket_t fd = server->get_impl()->get_native_socket();
+	if (fd == sio::invalid_socket)
+		return;
+	remove(fd);
+	server->set_non_blocking(false);
+}
+
+void net::event_loop::set_idle_timeout(const int& timeout)
+{
+	idle_timeout_ = timeout > 0 ? timeout : 0;
+}
+
+int net::event_loop::run_once(const int& timeout)
+{
+	int delay = timers_.next_timeout();
+	if (delay < 0 || (timeout >= 0 && timeout < delay))
+		delay = timeout;
+	int count = ::epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), delay);
+	if (count == -1) {
+		if (errno != EINTR)
+			throw socket_exception(sio::errno_exception("epoll_wait",
+				sio::socket_errno(errno)).what());
+		count = 0;
+	}
+	for (int i = 0; i < count; ++i)
+		dispatch(events_[i].data.fd, events_[i].events);
+	timers_.advance();
+	return count;
+}
+
+void net::event_loop::run(void)
+{
+	while (!stopped_)
+		run_once(-1);
+	stopped_ = false;
+}
+
+void net::event_loop::stop(void)
+{
+	stopped_ = true;
+	std::uint64_t one = 1;
+	ssize_t rc = ::write(wakefd_, &one, sizeof(one));
+	(void) rc;
+}
+
+void net::event_loop::add(const int& fd, const std::shared_ptr<entry>& e,
+	const std::uint32_t& events)
+{
+	struct epoll_event ev = {};
+	ev.events = events;
+	ev.data.fd = fd;
+	if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1)
+		throw socket_exception(sio::errno_exception("epoll_ctl",
+			sio::socket_errno(errno)).what());
+	entries_[fd] = e;
+}
+
+void net::event_loop::remove(const int& fd)
+{
+	::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+	auto it = entries_.find(fd);
+	if (it == entries_.end())
+		return;
+	timers_.cancel(it->second->idle_);
+	timers_.cancel(it->second->retry_);
+	entries_.erase(it);
+}
+
+void net::event_loop::dispatch(const int& fd, const std::uint32_t& events)
+{
+	if (fd == wakefd_) {
+		std::uint64_t count;
+		ssize_t rc = ::read(wakefd_, &count, sizeof(count));
+		(void) rc;
+		return;
+	}
+	auto it = entries_.find(fd);
+	if (it == entries_.end())
+		return;
+	std::shared_ptr<entry> e = it->second;
+	if (e->server_ != nullptr) {
+		drain_accept(fd, e);
+		return;
+	}
+	if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+		drain_read(fd, e);
+	if ((events & EPOLLOUT) && is_registered(fd, e) && e->on_write_ != nullptr)
+		e->on_write_(e->sock_);
+}
+
+void net::event_loop::drain_read(const int& fd, const std::shared_ptr<entry>& e)
+{
+	// edge-triggered: keep reading until the kernel reports it would block
+	while (is_registered(fd, e)) {
+		ssize_t count = ::recv(fd, buffer_.data(), buffer_.size(), MSG_DONTWAIT);
+		if (count > 0) {
+			if (e->idle_ != 0)
+				timers_.reschedule(e->idle_, idle_timeout_);
+			if (e->on_read_ != nullptr)
+				e->on_read_(e->sock_, buffer_.data(), static_cast<int>(count));
+			continue;
+		}
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		closed(fd, e);	// peer closed or socket failed
+		return;
+	}
+}
+
+void net::event_loop::drain_accept(const int& fd, const std::shared_ptr<entry>& e)
+{
+	// edge-triggered: keep accepting until the backlog is empty
+	while (is_registered(fd, e)) {
+		std::shared_ptr<socket> client;
+		try {
+			if ((client = e->server_->try_accept()) == nullptr)
+				return;
+		}
+		catch (const socket_exception& ex) {
+			// the edge is consumed while connections may still be pending
+			if (e->retry_ == 0) {
+				event_loop* loop = this;
+				e->retry_ = timers_.schedule(accept_retry_delay, [loop, fd, e](void) {
+					e->retry_ = 0;
+					loop->drain_accept(fd, e);
+				});
+			}
+			if (e->on_accept_error_ != nullptr)
+				e->on_accept_error_(e->server_, ex);
+			return;
+		}
+		if (e->on_accept_ != nullptr)
+			e->on_accept_(e->server_, client);
+	}
+}
+
+void net::event_loop::closed(const int& fd, const std::shared_ptr<entry>& e)
+{
+	remove(fd);
+	if (e->on_close_ != nullptr)
+		e->on_close_(e->sock_);
+}
+
+void net::event_loop::reap(const int& fd)
+{
+	// removing a socket cancels its timer, so the entry is the one timed
+	std::shared_ptr<entry> e = entries_[fd];
+	e->idle_ = 0;
+	remove(fd);
+	std::error_code ec;
+	e->sock_->close(ec);
+	if (e->on_close_ != nullptr)
+		e->on_close_(e->sock_);
+}
+
+bool net::event_loop::is_registered(const int& fd,
+	const std::shared_ptr<entry>& e) const
+{
+	auto it = entries_.find(fd);
+	return it != entries_.end() && it->second == e;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.event_loop.inl"
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef __NET_EVENT_LOOP__
+#define __NET_EVENT_LOOP__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "net.socket.h"
+#include "net.server_socket.h"
+#include "net.timer_wheel.h"
+
+namespace net
+{
+	class event_loop
+	{
+	public:
+		/**
+		* Invoked for every chunk of bytes drained from a readable socket.
+		*/
+		typedef std::function<void(const std::shared_ptr<socket>&,
+			const std::uint8_t*, const int&)> read_handler;
+
+		/**
+		* Invoked each time a socket transitions to writable.
+		*/
+		typedef std::function<void(const std::shared_ptr<socket>&)> write_handler;
+
+		/**
+		* Invoked once when the peer closed the connection or the socket
+		* failed. The socket is removed from the loop before the call.
+		*/
+		typedef std::function<void(const std::shared_ptr<socket>&)> close_handler;
+
+		/**
+		* Invoked for every connection accepted from a listening socket.
+		*/
+		typedef std::function<void(const std::shared_ptr<server_socket>&,
+			const std::shared_ptr<socket>&)> accept_handler;
+
+		/**
+		* Invoked when accepting from a listening socket failed, for example
+		* because the process ran out of descriptors.
+		*/
+		typedef std::function<void(const std::shared_ptr<server_socket>&,
+			const socket_exception&)> accept_error_handler;
+	private:
+		/**
+		* Milliseconds to wait before accepting again after a failure.
+		*/
+		static const int accept_retry_delay = 100;
+
+		struct entry
+		{
+			std::shared_ptr<socket> sock_;
+			std::shared_ptr<server_socket> server_;
+			read_handler on_read_;
+			write_handler on_write_;
+			close_handler on_close_;
+			accept_handler on_accept_;
+			accept_error_handler on_accept_error_;
+			timer_wheel::timer_id idle_;
+			timer_wheel::timer_id retry_;
+		};
+		int epfd_;
+		int wakefd_;
+		std::atomic<bool> stopped_;
+		std::unordered_map<int, std::shared_ptr<entry>> entries_;
+		std::vector<struct epoll_event> events_;
+		std::vector<std::uint8_t> buffer_;
+		timer_wheel timers_;
+		int idle_timeout_;
+	public:
+		/**
+		* Constructs an event loop polling at most max_events descriptors
+		* per wakeup and draining reads through a buffer of buffer_size bytes.
+		*/
+		event_loop(const int& max_events = 256, const int& buffer_size = 65536);
+	public:
+		virtual ~event_loop(void);
+	public:
+		/**
+		* Registers a connected socket with the loop in edge-triggered mode.
+		* On every readable edge the loop reads until the socket would block,
+		* handing each chunk to on_read. The blocking API of the socket is
+		* left untouched.
+		*/
+		void add(const std::shared_ptr<socket>& sock, const read_handler& on_read,
+			const write_handler& on_write = nullptr,
+			const close_handler& on_close = nullptr);
+
+		/**
+		* Registers a bound server socket with the loop in edge-triggered
+		* mode. On every readable edge the loop accepts until the backlog is
+		* empty. The listening socket is switched to non-blocking while
+		* registered, so a concurrent blocking accept() reports a timeout
+		* instead of waiting, and the accepted sockets are non-blocking.
+		* When accepting fails, on_accept_error is invoked and the loop
+		* drains the backlog again after a short delay, since no further
+		* edge is raised for the connections still pending.
+		*/
+		void add(const std::shared_ptr<server_socket>& server,
+			const accept_handler& on_accept,
+			const accept_error_handler& on_accept_error = nullptr);
+
+		/**
+		* Removes a socket from the loop. The socket is not closed.
+		*/
+		void remove(const std::shared_ptr<socket>& sock);
+
+		/**
+		* Removes a server socket from the loop and restores its blocking
+		* mode. The socket is not closed.
+		*/
+		void remove(const std::shared_ptr<server_socket>& server);
+
+		/**
+		* Closes connected sockets added from now on once nothing has been
+		* read from them for timeout milliseconds, invoking their
+		* on_close. Zero, the default, keeps idle sockets. Each read moves
+		* the deadline of its socket on the timer wheel of the loop, which
+		* costs the same however many sockets are registered.
+		*/
+		void set_idle_timeout(const int& timeout);
+
+		/**
+		* Waits up to timeout milliseconds for events and dispatches them,
+		* then runs the timers which are due. A negative timeout waits
+		* indefinitely, or until the next timer. Returns the number of
+		* descriptors that were ready.
+		*/
+		int run_once(const int& timeout = -1);
+
+		/**
+		* Dispatches events until stop() is called.
+		*/
+		void run(void);
+
+		/**
+		* Makes run() return after the current iteration. This is the only
+		* method which may be called from another thread.
+		*/
+		void stop(void);
+	public:
+		/**
+		* Returns the number of sockets registered with the loop.
+		*/
+		NET_INLINE std::size_t size(void) const;
+
+		/**
+		* Returns the idle timeout in milliseconds, zero if none is set.
+		*/
+		NET_INLINE int get_idle_timeout(void) const;
+
+		/**
+		* Returns the timers of the loop, which run on the loop thread from
+		* run_once().
+		*/
+		NET_INLINE timer_wheel& get_timers(void);
+	private:
+		void add(const int& fd, const std::shared_ptr<entry>& e,
+			const std::uint32_t& events);
+		void remove(const int& fd);
+		void dispatch(const int& fd, const std::uint32_t& events);
+		void drain_read(const int& fd, const std::shared_ptr<entry>& e);
+		void drain_accept(const int& fd, const std::shared_ptr<entry>& e);
+		void closed(const int& fd, const std::shared_ptr<entry>& e);
+		void reap(const int& fd);
+		bool is_registered(const int& fd, const std::shared_ptr<entry>& e) const;
+	private:
+		event_loop(const event_loop&);
+		event_loop& operator=(const event_loop&);
+		event_loop& operator=(const event_loop&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.event_loop.inl"
+#endif
+
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+
+NET_INLINE std::size_t net::event_loop::size(void) const
+{
+	return entries_.size();
+}
+
+NET_INLINE int net::event_loop::get_idle_timeout(void) const
+{
+	return idle_timeout_;
+}
+
+NET_INLINE net::timer_wheel& net::event_loop::get_timers(void)
+{
+	return timers_;
+}
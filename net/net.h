@@ -3,12 +3,31 @@
 
 #include "net.config.h"
 #include "net.exceptions.h"
+#include "net.error.h"
 
 #include "net.net_address.h"
 #include "net.net4_address.h"
 #include "net.net6_address.h"
+#include "net.address_text.h"
+#include "net.ip_address.h"
+#include "net.endpoint.h"
 #include "net.socket.h"
 #include "net.socket_address.h"
 #include "net.server_socket.h"
+#include "net.datagram_socket.h"
+#include "net.multicast_socket.h"
+#include "net.timer_wheel.h"
+#include "net.event_loop.h"
+#include "net.task.h"
+#include "net.run_loop.h"
+#include "net.sharded_acceptor.h"
+#include "net.prefix_table.h"
+#include "net.socket_filter.h"
+#include "net.io_uring_socket_impl_factory.h"
+#include "net.buffer_pool.h"
+#include "net.connection_pool.h"
+#include "net.connect_batch.h"
+#include "net.resolver_cache.h"
+#include "net.dns_resolver.h"
 
 #endif
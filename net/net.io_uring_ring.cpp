@@ -0,0 +1,414 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "sio.h"
+#include "net.exceptions.h"
+#include "net.io_uring_ring.h"
+
+net::io_uring_ring::waiter::waiter(io_uring_ring* ring)
+	: ring_(ring)
+	, res_(0)
+	, flags_(0)
+	, done_(false)
+	, abandoned_(false)
+	, ts_()
+{
+}
+
+void net::io_uring_ring::waiter::complete(const int& res, const std::uint32_t& flags)
+{
+	res_ = res;
+	flags_ = flags;
+	done_ = true;
+	if (abandoned_)
+		ring_->release(this);
+}
+
+bool net::io_uring_ring::waiter::ready(void) const
+{
+	return done_;
+}
+
+net::io_uring_ring::io_uring_ring(const unsigned& entries, const int& buffer_count,
+	const int& buffer_size, const bool& sq_poll)
+	: fd_(-1)
+	, features_(0)
+	, sq_ring_(MAP_FAILED)
+	, sq_ring_size_(0)
+	, cq_ring_(MAP_FAILED)
+	, cq_ring_size_(0)
+	, sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED))
+	, sqes_size_(0)
+	, sq_head_(nullptr)
+	, sq_tail_(nullptr)
+	, sq_array_(nullptr)
+	, sq_flags_(nullptr)
+	, sq_mask_(0)
+	, sq_entries_(0)
+	, cq_head_(nullptr)
+	, cq_tail_(nullptr)
+	, cq_mask_(0)
+	, cqes_(nullptr)
+	, to_submit_(0)
+	, has_leader_(false)
+	, sq_poll_(sq_poll)
+	, buffers_()
+	, buffer_count_(0)
+	, buffer_size_(buffer_size > 0 ? buffer_size : 4096)
+	, enter_count_(0)
+	, operation_count_(0)
+	, waiters_()
+	, idle_waiters_()
+{
+	struct io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	if (sq_poll_) {
+		params.flags = IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = 50;
+	}
+	fd_ = (int) ::syscall(__NR_io_uring_setup, entries > 0 ? entries : 256, &params);
+	if (fd_ == -1)
+		throw socket_exception(sio::errno_exception("io_uring_setup",
+			sio::socket_errno(errno)).what());
+	features_ = params.features;
+
+	sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size_ = params.cq_off.cqes +
+		params.cq_entries * sizeof(struct io_uring_cqe);
+	if (features_ & IORING_FEAT_SINGLE_MMAP) {
+		if (cq_ring_size_ > sq_ring_size_)
+			sq_ring_size_ = cq_ring_size_;
+		cq_ring_size_ = sq_ring_size_;
+	}
+	sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+	if (sq_ring_ != MAP_FAILED) {
+		cq_ring_ = (features_ & IORING_FEAT_SINGLE_MMAP) ? sq_ring_ :
+			::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+	}
+	if (cq_ring_ != MAP_FAILED) {
+		sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+		sqes_ = static_cast<struct io_uring_sqe*>(::mmap(nullptr, sqes_size_,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+			IORING_OFF_SQES));
+	}
+	if (sqes_ == MAP_FAILED) {
+		int error = errno;
+		unmap();
+		::close(fd_);
+		throw socket_exception(sio::errno_exception("mmap",
+			sio::socket_errno(error)).what());
+	}
+
+	std::uint8_t* sq = static_cast<std::uint8_t*>(sq_ring_);
+	sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	sq_flags_ = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+	sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sq_entries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+	std::uint8_t* cq = static_cast<std::uint8_t*>(cq_ring_);
+	cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	if (buffer_count > 0) {
+		buffers_.resize(static_cast<std::size_t>(buffer_count) * buffer_size_);
+		struct io_uring_sqe sqe;
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_PROVIDE_BUFFERS;
+		sqe.fd = buffer_count;
+		sqe.addr = reinterpret_cast<std::uint64_t>(buffers_.data());
+		sqe.len = buffer_size_;
+		sqe.off = 0;
+		sqe.buf_group = buffer_group;
+		// kernels without provided buffers simply receive into the caller buffer
+		if (execute(sqe) >= 0)
+			buffer_count_ = buffer_count;
+		else
+			buffers_.clear();
+	}
+}
+
+net::io_uring_ring::~io_uring_ring(void)
+{
+	unmap();
+	::close(fd_);
+}
+
+int net::io_uring_ring::execute(const struct io_uring_sqe& sqe, const int& timeout,
+	std::uint32_t* flags)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	// the kernel holds the address of w until its completion entry is
+	// reaped, so w belongs to the ring rather than to this frame
+	waiter* w = acquire();
+	bool pushed = false;
+	try {
+		if (timeout > 0) {
+			// both entries must go out in the same submission to stay linked
+			reserve(2);
+			struct io_uring_sqe op = sqe;
+			op.flags |= IOSQE_IO_LINK;
+			w->ts_.tv_sec = timeout / 1000;
+			w->ts_.tv_nsec = (timeout % 1000) * 1000000L;
+			struct io_uring_sqe link;
+			std::memset(&link, 0, sizeof(link));
+			link.opcode = IORING_OP_LINK_TIMEOUT;
+			link.fd = -1;
+			link.addr = reinterpret_cast<std::uint64_t>(&w->ts_);
+			link.len = 1;
+			push(op, reinterpret_cast<std::uint64_t>(w));
+			push(link, 0);
+		}
+		else {
+			reserve(1);
+			push(sqe, reinterpret_cast<std::uint64_t>(w));
+		}
+		pushed = true;
+		wait(lock, *w, 0);
+	}
+	catch (const socket_exception&) {
+		if (!pushed || w->done_) {
+			release(w);
+			throw;
+		}
+		// the operation is still queued or in flight: cancel it, and let
+		// its completion, whenever it is reaped, hand w back to the ring
+		w->abandoned_ = true;
+		struct io_uring_sqe cancel;
+		std::memset(&cancel, 0, sizeof(cancel));
+		cancel.opcode = IORING_OP_ASYNC_CANCEL;
+		cancel.fd = -1;
+		cancel.addr = reinterpret_cast<std::uint64_t>(w);
+		try {
+			reserve(1);
+			push(cancel, 0);
+		}
+		catch (const socket_exception&) {
+		}
+		throw;
+	}
+	if (flags != nullptr)
+		*flags = w->flags_;
+	int res = w->res_;
+	release(w);
+	return res;
+}
+
+void net::io_uring_ring::post(const struct io_uring_sqe& sqe)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	reserve(1);
+	push(sqe, 0);
+	if (has_leader_)
+		flush();
+}
+
+void net::io_uring_ring::arm(const struct io_uring_sqe& sqe, completion& c)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	reserve(1);
+	push(sqe, reinterpret_cast<std::uint64_t>(&c));
+	if (has_leader_)
+		flush();
+}
+
+bool net::io_uring_ring::wait(completion& c, const int& timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	return wait(lock, c, timeout);
+}
+
+void net::io_uring_ring::recycle_buffer(const int& id)
+{
+	struct io_uring_sqe sqe;
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_PROVIDE_BUFFERS;
+	sqe.fd = 1;
+	sqe.addr = reinterpret_cast<std::uint64_t>(get_buffer(id));
+	sqe.len = buffer_size_;
+	sqe.off = id;
+	sqe.buf_group = buffer_group;
+	post(sqe);
+}
+
+net::io_uring_ring::waiter* net::io_uring_ring::acquire(void)
+{
+	if (idle_waiters_.empty()) {
+		waiters_.emplace_back(new waiter(this));
+		return waiters_.back().get();
+	}
+	waiter* w = idle_waiters_.back();
+	idle_waiters_.pop_back();
+	w->res_ = 0;
+	w->flags_ = 0;
+	w->done_ = false;
+	w->abandoned_ = false;
+	return w;
+}
+
+void net::io_uring_ring::release(waiter* w)
+{
+	idle_waiters_.push_back(w);
+}
+
+void net::io_uring_ring::reserve(const unsigned& count)
+{
+	while (*sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) + count > sq_entries_) {
+		flush();
+		if (sq_poll_)
+			std::this_thread::yield();	// wait for the poll thread to catch up
+	}
+}
+
+void net::io_uring_ring::push(const struct io_uring_sqe& sqe,
+	const std::uint64_t& user_data)
+{
+	unsigned tail = *sq_tail_;
+	unsigned index = tail & sq_mask_;
+	sqes_[index] = sqe;
+	sqes_[index].user_data = user_data;
+	sq_array_[index] = index;
+	__atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+	++to_submit_;
+	operation_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void net::io_uring_ring::flush(void)
+{
+	if (sq_poll_) {
+		// the poll thread picks up new entries on its own unless it went idle
+		to_submit_ = 0;
+		if (__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP)
+			enter(0, 0, IORING_ENTER_SQ_WAKEUP, 0);
+		return;
+	}
+	while (to_submit_ > 0) {
+		int rc = enter(to_submit_, 0, 0, 0);
+		if (rc >= 0) {
+			to_submit_ -= rc;
+			continue;
+		}
+		if (errno == EINTR)
+			continue;
+		if (errno == EBUSY || errno == EAGAIN) {
+			// the completion queue is backed up, make room and retry
+			reap();
+			cond_.notify_all();
+			continue;
+		}
+		throw socket_exception(sio::errno_exception("io_uring_enter",
+			sio::socket_errno(errno)).what());
+	}
+}
+
+bool net::io_uring_ring::wait(std::unique_lock<std::mutex>& lock, completion& c,
+	const int& timeout)
+{
+	typedef std::chrono::steady_clock clock;
+	clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout);
+	for (;;) {
+		reap();
+		if (c.ready())
+			return true;
+		int remaining = 0;
+		if (timeout > 0) {
+			remaining = static_cast<int>(std::chrono::duration_cast<
+				std::chrono::milliseconds>(deadline - clock::now()).count());
+			if (remaining <= 0)
+				return false;
+		}
+		if (has_leader_) {
+			// the leader is blocked in the kernel and will not see our entries
+			if (to_submit_ > 0)
+				flush();
+			if (timeout > 0)
+				cond_.wait_until(lock, deadline);
+			else
+				cond_.wait(lock);
+			continue;
+		}
+		if (sq_poll_)
+			flush();
+		has_leader_ = true;
+		unsigned count = to_submit_;
+		to_submit_ = 0;
+		lock.unlock();
+		int rc = enter(count, 1, IORING_ENTER_GETEVENTS, remaining);
+		int error = errno;
+		lock.lock();
+		has_leader_ = false;
+		if (rc >= 0)
+			to_submit_ += count - rc;
+		else {
+			to_submit_ += count;
+			if (error != EINTR && error != ETIME && error != EBUSY && error != EAGAIN) {
+				cond_.notify_all();
+				throw socket_exception(sio::errno_exception("io_uring_enter",
+					sio::socket_errno(error)).what());
+			}
+		}
+		reap();
+		cond_.notify_all();
+	}
+}
+
+int net::io_uring_ring::enter(const unsigned& to_submit, const unsigned& min_complete,
+	const unsigned& flags, const int& timeout)
+{
+	enter_count_.fetch_add(1, std::memory_order_relaxed);
+	if (timeout > 0 && (features_ & IORING_FEAT_EXT_ARG)) {
+		struct __kernel_timespec ts;
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000L;
+		struct io_uring_getevents_arg arg;
+		std::memset(&arg, 0, sizeof(arg));
+		arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+		return (int) ::syscall(__NR_io_uring_enter, fd_, to_submit, min_complete,
+			flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	}
+	// without IORING_FEAT_EXT_ARG the wait is only bounded by the next
+	// completion; waiters re-check their deadline when woken
+	return (int) ::syscall(__NR_io_uring_enter, fd_, to_submit, min_complete,
+		flags, nullptr, 0);
+}
+
+void net::io_uring_ring::reap(void)
+{
+	unsigned head = *cq_head_;
+	unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head) {
+		const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+		if (cqe.user_data != 0)
+			reinterpret_cast<completion*>(cqe.user_data)->complete(cqe.res, cqe.flags);
+	}
+	__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+void net::io_uring_ring::unmap(void)
+{
+	if (sqes_ != MAP_FAILED)
+		::munmap(sqes_, sqes_size_);
+	if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+		::munmap(cq_ring_, cq_ring_size_);
+	if (sq_ring_ != MAP_FAILED)
+		::munmap(sq_ring_, sq_ring_size_);
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.io_uring_ring.inl"
+#endif
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef __NET_IO_URING_RING__
+#define __NET_IO_URING_RING__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace net
+{
+	class io_uring_ring
+	{
+	public:
+		/**
+		* Receives the completion entries of an operation submitted through
+		* the ring. Both methods are called with the ring lock held.
+		*/
+		struct completion
+		{
+			virtual void complete(const int& res, const std::uint32_t& flags) = 0;
+			virtual bool ready(void) const = 0;
+			virtual ~completion(void) {}
+		};
+	private:
+		struct waiter : public completion
+		{
+			io_uring_ring* ring_;
+			int res_;
+			std::uint32_t flags_;
+			bool done_;
+			bool abandoned_;	// its caller is gone, the completion recycles it
+			struct __kernel_timespec ts_;
+		public:
+			explicit waiter(io_uring_ring* ring);
+			void complete(const int& res, const std::uint32_t& flags);
+			bool ready(void) const;
+		};
+		int fd_;
+		std::uint32_t features_;
+		void* sq_ring_;
+		std::size_t sq_ring_size_;
+		void* cq_ring_;
+		std::size_t cq_ring_size_;
+		struct io_uring_sqe* sqes_;
+		std::size_t sqes_size_;
+		unsigned* sq_head_;
+		unsigned* sq_tail_;
+		unsigned* sq_array_;
+		unsigned* sq_flags_;
+		unsigned sq_mask_;
+		unsigned sq_entries_;
+		unsigned* cq_head_;
+		unsigned* cq_tail_;
+		unsigned cq_mask_;
+		struct io_uring_cqe* cqes_;
+		std::mutex mutex_;
+		std::condition_variable cond_;
+		unsigned to_submit_;
+		bool has_leader_;
+		bool sq_poll_;
+		std::vector<std::uint8_t> buffers_;
+		int buffer_count_;
+		int buffer_size_;
+		std::atomic<std::uint64_t> enter_count_;
+		std::atomic<std::uint64_t> operation_count_;
+		std::vector<std::unique_ptr<waiter>> waiters_;
+		std::vector<waiter*> idle_waiters_;
+	public:
+		/**
+		* Group id of the provided receive buffers.
+		*/
+		static const std::uint16_t buffer_group = 1;
+	public:
+		/**
+		* Creates a ring with room for entries submissions. When buffer_count
+		* is positive, that many receive buffers of buffer_size bytes are
+		* provided to the kernel so receives can pick a buffer only once
+		* data has arrived. With sq_poll a kernel thread consumes the
+		* submission queue, so submitting needs no system call while the
+		* thread is awake.
+		*/
+		io_uring_ring(const unsigned& entries = 256, const int& buffer_count = 0,
+			const int& buffer_size = 4096, const bool& sq_poll = false);
+	public:
+		virtual ~io_uring_ring(void);
+	public:
+		/**
+		* Submits an operation and blocks until it completes. Submissions of
+		* concurrent callers are flushed together by whichever thread enters
+		* the kernel, and a single thread reaps completions for all waiters.
+		* With a positive timeout in milliseconds the operation is linked to
+		* a timeout and completes with -ECANCELED when it expires. Returns
+		* the result of the completion entry, a negative errno on failure.
+		*/
+		int execute(const struct io_uring_sqe& sqe, const int& timeout = 0,
+			std::uint32_t* flags = nullptr);
+
+		/**
+		* Queues an operation whose completion is ignored. It is submitted
+		* with the next batch.
+		*/
+		void post(const struct io_uring_sqe& sqe);
+
+		/**
+		* Queues an operation whose completions are delivered to c, which
+		* must stay alive until its last completion entry was delivered.
+		*/
+		void arm(const struct io_uring_sqe& sqe, completion& c);
+
+		/**
+		* Waits until c is ready. A positive timeout in milliseconds bounds
+		* the wait. Returns whether c is ready.
+		*/
+		bool wait(completion& c, const int& timeout = 0);
+
+		/**
+		* Runs fn with the ring lock held, which serializes it against the
+		* delivery of completions.
+		*/
+		template <typename Fn>
+		void locked(const Fn& fn)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			fn();
+		}
+	public:
+		/**
+		* Returns the number of provided receive buffers, zero if none.
+		*/
+		NET_INLINE int get_buffer_count(void) const;
+
+		/**
+		* Returns the size of each provided receive buffer.
+		*/
+		NET_INLINE int get_buffer_size(void) const;
+
+		/**
+		* Returns the provided receive buffer with the given id.
+		*/
+		NET_INLINE std::uint8_t* get_buffer(const int& id);
+
+		/**
+		* Hands a provided receive buffer back to the kernel.
+		*/
+		void recycle_buffer(const int& id);
+	public:
+		/**
+		* Returns the number of io_uring_enter system calls made so far.
+		*/
+		NET_INLINE std::uint64_t get_enter_count(void) const;
+
+		/**
+		* Returns the number of operations submitted so far.
+		*/
+		NET_INLINE std::uint64_t get_operation_count(void) const;
+	private:
+		waiter* acquire(void);
+		void release(waiter* w);
+		void reserve(const unsigned& count);
+		void push(const struct io_uring_sqe& sqe, const std::uint64_t& user_data);
+		void flush(void);
+		bool wait(std::unique_lock<std::mutex>& lock, completion& c,
+			const int& timeout);
+		int enter(const unsigned& to_submit, const unsigned& min_complete,
+			const unsigned& flags, const int& timeout);
+		void reap(void);
+		void unmap(void);
+	private:
+		io_uring_ring(const io_uring_ring&);
+		io_uring_ring& operator=(const io_uring_ring&);
+		io_uring_ring& operator=(const io_uring_ring&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.io_uring_ring.inl"
+#endif
+
+#endif
+
+#endif
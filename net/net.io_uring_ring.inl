@@ -0,0 +1,25 @@
+
+NET_INLINE int net::io_uring_ring::get_buffer_count(void) const
+{
+	return buffer_count_;
+}
+
+NET_INLINE int net::io_uring_ring::get_buffer_size(void) const
+{
+	return buffer_size_;
+}
+
+NET_INLINE std::uint8_t* net::io_uring_ring::get_buffer(const int& id)
+{
+	return &buffers_[static_cast<std::size_t>(id) * buffer_size_];
+}
+
+NET_INLINE std::uint64_t net::io_uring_ring::get_enter_count(void) const
+{
+	return enter_count_.load(std::memory_order_relaxed);
+}
+
+NET_INLINE std::uint64_t net::io_uring_ring::get_operation_count(void) const
+{
+	return operation_count_.load(std::memory_order_relaxed);
+}
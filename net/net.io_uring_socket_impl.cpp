@@ -0,0 +1,479 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <chrono>
+#include <cstring>
+#include <ios>
+
+#include "net.error.h"
+#include "net.exceptions.h"
+#include "net.io_uring_socket_impl.h"
+#include "net.io_uring_socket_impl_factory.h"
+
+net::io_uring_socket_impl::accept_queue::accept_queue(void)
+	: fds_()
+	, error_(0)
+	, armed_(false)
+	, multishot_(true)
+	, delivered_(false)
+{
+}
+
+void net::io_uring_socket_impl::accept_queue::complete(const int& res,
+	const std::uint32_t& flags)
+{
+	if (res >= 0) {
+		fds_.push_back(res);
+		delivered_ = true;
+	}
+	else if (res == -EINVAL && multishot_ && !delivered_)
+		multishot_ = false;	// kernel without multishot accept, re-arm single shot
+	else if (res != -ECANCELED)
+		error_ = -res;
+	if (!(flags & IORING_CQE_F_MORE))
+		armed_ = false;
+}
+
+bool net::io_uring_socket_impl::accept_queue::ready(void) const
+{
+	return !fds_.empty() || error_ != 0 || !armed_;
+}
+
+net::io_uring_socket_impl::io_uring_socket_impl(
+	const std::shared_ptr<io_uring_ring>& ring)
+	: default_socket_impl()
+	, ring_(ring)
+	, accept_queue_(nullptr)
+	, receive_timeout_(0)
+	, send_timeout_(0)
+{
+}
+
+net::io_uring_socket_impl::~io_uring_socket_impl(void)
+{
+	std::error_code ec;
+	close(ec);	// a failing ring must not throw out of the destructor
+}
+
+void net::io_uring_socket_impl::accept(std::shared_ptr<net::socket_impl>& new_impl)
+{
+	if (accept_queue_ == nullptr)
+		throw socket_exception("Socket is not listening");
+	std::error_code ec;
+	accept(new_impl, ec);
+	if (ec == std::errc::timed_out)
+		throw socket_timeout_exception("accept timed out");
+	if (ec)
+		throw socket_exception(sio::errno_exception("accept", ec.value()).what());
+}
+
+void net::io_uring_socket_impl::accept(std::shared_ptr<net::socket_impl>& new_impl,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (accept_queue_ == nullptr) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	typedef std::chrono::steady_clock clock;
+	clock::time_point deadline = clock::now() +
+		std::chrono::milliseconds(receive_timeout_);
+	try {
+		for (;;) {
+			int fd = -1;
+			int error = 0;
+			bool arm = false;
+			if (pop_accepted(fd, error, arm)) {
+				if (accepted(new_impl, fd, ec) || ec)
+					return;
+				continue;
+			}
+			if (error != 0) {
+				ec = make_socket_error(sio::socket_errno(error));
+				return;
+			}
+			if (arm) {
+				struct io_uring_sqe sqe;
+				std::memset(&sqe, 0, sizeof(sqe));
+				sqe.opcode = IORING_OP_ACCEPT;
+				sqe.fd = sock_;
+				sqe.accept_flags = SOCK_CLOEXEC;
+				if (accept_queue_->multishot_)
+					sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+				ring_->arm(sqe, *accept_queue_);
+			}
+			int remaining = 0;
+			if (receive_timeout_ > 0) {
+				remaining = static_cast<int>(std::chrono::duration_cast<
+					std::chrono::milliseconds>(deadline - clock::now()).count());
+				if (remaining <= 0) {
+					ec = make_socket_error(ETIMEDOUT);
+					return;
+				}
+			}
+			if (!ring_->wait(*accept_queue_, remaining)) {
+				ec = make_socket_error(ETIMEDOUT);
+				return;
+			}
+		}
+	}
+	catch (const socket_exception&) {
+		// the ring itself failed, which is not a routine error
+		ec = std::make_error_code(std::errc::io_error);
+	}
+}
+
+void net::io_uring_socket_impl::close(void)
+{
+	release_accept_queue();
+	default_socket_impl::close();
+}
+
+void net::io_uring_socket_impl::close(std::error_code& ec) noexcept
+{
+	try {
+		release_accept_queue();
+	}
+	catch (const socket_exception&) {
+		accept_queue_ = nullptr;
+	}
+	default_socket_impl::close(ec);
+}
+
+void net::io_uring_socket_impl::release_accept_queue(void)
+{
+	if (accept_queue_ != nullptr) {
+		std::shared_ptr<accept_queue> queue = accept_queue_;
+		bool armed = false;
+		ring_->locked([&]() { armed = queue->armed_; });
+		if (armed) {
+			struct io_uring_sqe sqe;
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_ASYNC_CANCEL;
+			sqe.fd = -1;
+			sqe.addr = reinterpret_cast<std::uint64_t>(queue.get());
+			ring_->execute(sqe);
+		}
+		// the queue must outlive its last completion entry
+		for (;;) {
+			ring_->locked([&]() {
+				for (std::size_t i = 0; i < queue->fds_.size(); ++i)
+					::close(queue->fds_[i]);
+				queue->fds_.clear();
+				armed = queue->armed_;
+			});
+			if (!armed)
+				break;
+			ring_->wait(*queue);
+		}
+		accept_queue_ = nullptr;
+	}
+}
+
+void net::io_uring_socket_impl::connect(const std::shared_ptr<net::net_address>& addr,
+	const std::uint16_t& port, const int& timeout)
+{
+	std::shared_ptr<net::net_address> normal = addr->is_any_local_address() ?
+		addr->get_local_host() : addr;
+	int res = -EAFNOSUPPORT;
+	if (normal->get_family() == AF_INET) {
+		sio::sock_addr4 sa(normal->get_address(), port);
+		res = submit_connect(sa, sizeof(sa), timeout);
+	}
+	else if (normal->get_family() == AF_INET6) {
+		sio::sock_addr6 sa(normal->get_address(), port);
+		res = submit_connect(sa, sizeof(sa), timeout);
+	}
+	if (res == -ECANCELED || res == -ETIMEDOUT)
+		throw socket_timeout_exception("connect timed out");
+	if (res < 0)
+		throw socket_exception(sio::errno_exception("connect",
+			sio::socket_errno(-res)).what());
+	set_address(normal);
+	set_port(port);
+}
+
+void net::io_uring_socket_impl::connect(const endpoint& remote, const int& timeout)
+{
+	std::error_code ec;
+	connect(remote, timeout, ec);
+	if (ec == std::errc::timed_out)
+		throw socket_timeout_exception("connect timed out");
+	if (ec)
+		throw socket_exception(sio::errno_exception("connect", ec.value()).what());
+}
+
+void net::io_uring_socket_impl::connect(const endpoint& remote, const int& timeout,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	endpoint target = remote;
+	if (remote.get_address().is_any_local_address())
+		target = endpoint(ip_address::loopback(remote.get_family()), remote.get_port());
+	int res = 0;
+	try {
+		res = submit_connect(target.data(), target.size(), timeout);
+	}
+	catch (const socket_exception&) {
+		ec = std::make_error_code(std::errc::io_error);
+		return;
+	}
+	if (res == -ECANCELED || res == -ETIMEDOUT) {
+		ec = make_socket_error(ETIMEDOUT);
+		return;
+	}
+	if (res < 0) {
+		ec = make_socket_error(sio::socket_errno(-res));
+		return;
+	}
+	set_remote_endpoint(target);
+}
+
+int net::io_uring_socket_impl::read(std::uint8_t* buffer, const int& nbytes)
+{
+	if (nbytes == 0)
+		return 0;
+	if (shutdown_input_)
+		return -1;
+	int read_count = receive(buffer, nbytes, ring_->get_buffer_count() > 0);
+	if (read_count == -ENOBUFS)	// all provided buffers are in use
+		read_count = receive(buffer, nbytes, false);
+	if (read_count > 0)
+		return read_count;
+	if (read_count == 0) {
+		shutdown_input_ = true;	// peer closed
+		return -1;
+	}
+	if (read_count == -ECANCELED || read_count == -EAGAIN ||
+		read_count == -EWOULDBLOCK || read_count == -EINTR)
+		return 0;
+	throw std::ios_base::failure(sio::errno_exception("recv",
+		sio::socket_errno(-read_count)).what());
+}
+
+void net::io_uring_socket_impl::write(const std::uint8_t* buffer, const int& nbytes)
+{
+	int count = 0;
+	while (count < nbytes) {
+		struct io_uring_sqe sqe;
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_SEND;
+		sqe.fd = sock_;
+		sqe.addr = reinterpret_cast<std::uint64_t>(buffer + count);
+		sqe.len = nbytes - count;
+		sqe.msg_flags = MSG_NOSIGNAL;
+		int written = ring_->execute(sqe, send_timeout_);
+		if (written >= 0)
+			count += written;
+		else if (written == -ECANCELED)
+			throw std::ios_base::failure("send timed out");
+		else if (written != -EINTR)
+			throw std::ios_base::failure(sio::errno_exception("send",
+				sio::socket_errno(-written)).what());
+	}
+}
+
+int net::io_uring_socket_impl::try_accept(std::shared_ptr<net::socket_impl>& new_impl)
+{
+	std::error_code ec;
+	int result = try_accept(new_impl, ec);
+	if (ec)
+		throw socket_exception(sio::errno_exception("accept", ec.value()).what());
+	return result;
+}
+
+int net::io_uring_socket_impl::try_accept(std::shared_ptr<net::socket_impl>& new_impl,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	int fd = -1;
+	int error = 0;
+	bool arm = false;
+	while (accept_queue_ != nullptr && pop_accepted(fd, error, arm)) {
+		if (!accepted(new_impl, fd, ec)) {
+			if (ec)
+				return failed;
+			fd = -1;
+			continue;
+		}
+		if (non_blocking_)
+			new_impl->set_non_blocking(true, ec);
+		return ec ? failed : 0;
+	}
+	return default_socket_impl::try_accept(new_impl, ec);
+}
+
+void net::io_uring_socket_impl::listen(const int& backlog)
+{
+	default_socket_impl::listen(backlog);
+	if (accept_queue_ == nullptr)
+		accept_queue_ = std::make_shared<accept_queue>();
+}
+
+void net::io_uring_socket_impl::listen(const int& backlog, std::error_code& ec) noexcept
+{
+	default_socket_impl::listen(backlog, ec);
+	if (!ec && accept_queue_ == nullptr)
+		accept_queue_ = std::make_shared<accept_queue>();
+}
+
+void net::io_uring_socket_impl::set_option_int(const int& id, const int& val)
+{
+	default_socket_impl::set_option_int(id, val);
+	// operations submitted to the ring do not honour the socket timeouts,
+	// they are linked to ring timeouts instead
+	if (id == SO_RCVTIMEO)
+		receive_timeout_ = val;
+	else if (id == SO_SNDTIMEO)
+		send_timeout_ = val;
+}
+
+void net::io_uring_socket_impl::set_option_int(const int& level, const int& id,
+	const int& val, std::error_code& ec) noexcept
+{
+	default_socket_impl::set_option_int(level, id, val, ec);
+	if (ec || level != SOL_SOCKET)
+		return;
+	if (id == SO_RCVTIMEO)
+		receive_timeout_ = val;
+	else if (id == SO_SNDTIMEO)
+		send_timeout_ = val;
+}
+
+int net::io_uring_socket_impl::submit_connect(const sio::sockaddr_t* addr,
+	const int& len, const int& timeout)
+{
+	struct io_uring_sqe sqe;
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_CONNECT;
+	sqe.fd = sock_;
+	sqe.addr = reinterpret_cast<std::uint64_t>(addr);
+	sqe.off = len;
+	return ring_->execute(sqe, timeout);
+}
+
+int net::io_uring_socket_impl::receive(std::uint8_t* buffer, const int& nbytes,
+	const bool& select)
+{
+	struct io_uring_sqe sqe;
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_RECV;
+	sqe.fd = sock_;
+	if (select) {
+		// the kernel picks a provided buffer only once data has arrived
+		sqe.flags = IOSQE_BUFFER_SELECT;
+		sqe.buf_group = io_uring_ring::buffer_group;
+		sqe.len = nbytes < ring_->get_buffer_size() ?
+			nbytes : ring_->get_buffer_size();
+	}
+	else {
+		sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+		sqe.len = nbytes;
+	}
+	std::uint32_t flags = 0;
+	int res = ring_->execute(sqe, receive_timeout_, &flags);
+	if (flags & IORING_CQE_F_BUFFER) {
+		int id = static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT);
+		if (res > 0)
+			std::memcpy(buffer, ring_->get_buffer(id), res);
+		ring_->recycle_buffer(id);
+	}
+	return res;
+}
+
+bool net::io_uring_socket_impl::pop_accepted(int& fd, int& error, bool& arm)
+{
+	accept_queue* queue = accept_queue_.get();
+	ring_->locked([&]() {
+		if (!queue->fds_.empty()) {
+			fd = queue->fds_.front();
+			queue->fds_.pop_front();
+		}
+		else if (queue->error_ != 0) {
+			error = queue->error_;
+			queue->error_ = 0;
+		}
+		else if (!queue->armed_) {
+			queue->armed_ = true;
+			arm = true;
+		}
+	});
+	return fd != -1;
+}
+
+bool net::io_uring_socket_impl::accepted(std::shared_ptr<net::socket_impl>& new_impl,
+	const int& fd, std::error_code& ec) noexcept
+{
+	ec.clear();
+	// multishot accepts cannot report the peer address
+	endpoint peer;
+	socklen_t salen = endpoint::capacity();
+	if (::getpeername(fd, peer.data(), &salen) == -1) {
+		ec = make_socket_error(sio::socket_errno(errno));
+		::close(fd);
+		return false;
+	}
+	std::int32_t tag = 0;
+	if (!admit(fd, peer, tag))
+		return false;
+	new_impl->set_native_socket(fd);
+	new_impl->set_remote_endpoint(peer);
+	new_impl->set_tag(tag);
+	assign_local_endpoint(new_impl, ec);
+	return !ec;
+}
+
+net::io_uring_server_socket_impl::io_uring_server_socket_impl(
+	const std::shared_ptr<io_uring_ring>& ring)
+	: io_uring_socket_impl(ring)
+{
+}
+
+net::io_uring_server_socket_impl::~io_uring_server_socket_impl(void)
+{
+}
+
+void net::io_uring_server_socket_impl::create(const int& family)
+{
+	io_uring_socket_impl::create(family);
+	set_option_bool(SO_REUSEADDR, true);
+}
+
+void net::io_uring_server_socket_impl::create(const int& family,
+	std::error_code& ec) noexcept
+{
+	io_uring_socket_impl::create(family, ec);
+	if (!ec)
+		set_option_bool(SOL_SOCKET, SO_REUSEADDR, true, ec);
+}
+
+net::io_uring_socket_impl_factory::io_uring_socket_impl_factory(
+	const std::shared_ptr<io_uring_ring>& ring)
+	: ring_(ring)
+{
+}
+
+std::shared_ptr<net::socket_impl>
+net::io_uring_socket_impl_factory::create_socket_impl(void)
+{
+	return std::make_shared<io_uring_socket_impl>(ring_);
+}
+
+net::io_uring_server_socket_impl_factory::io_uring_server_socket_impl_factory(
+	const std::shared_ptr<io_uring_ring>& ring)
+	: ring_(ring)
+{
+}
+
+std::shared_ptr<net::socket_impl>
+net::io_uring_server_socket_impl_factory::create_socket_impl(void)
+{
+	return std::make_shared<io_uring_server_socket_impl>(ring_);
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.io_uring_socket_impl.inl"
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef __NET_IO_URING_SOCKET_IMPL__
+#define __NET_IO_URING_SOCKET_IMPL__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <deque>
+#include <memory>
+
+#include "net.default_socket_impl.h"
+#include "net.io_uring_ring.h"
+
+namespace net
+{
+	class io_uring_socket_impl : public default_socket_impl
+	{
+		struct accept_queue : public io_uring_ring::completion
+		{
+			std::deque<int> fds_;
+			int error_;
+			bool armed_;
+			bool multishot_;
+			bool delivered_;
+		public:
+			accept_queue(void);
+			void complete(const int& res, const std::uint32_t& flags);
+			bool ready(void) const;
+		};
+		std::shared_ptr<io_uring_ring> ring_;
+		std::shared_ptr<accept_queue> accept_queue_;
+		int receive_timeout_;
+		int send_timeout_;
+	public:
+		io_uring_socket_impl(const std::shared_ptr<io_uring_ring>& ring);
+	public:
+		virtual ~io_uring_socket_impl(void);
+	public:
+		using default_socket_impl::connect;
+		void accept(std::shared_ptr<socket_impl>& new_socket);
+		void close(void);
+		void connect(const std::shared_ptr<net_address>& addr,
+			const std::uint16_t& port, const int& timeout);
+		void connect(const endpoint& remote, const int& timeout);
+		int read(std::uint8_t* buffer, const int& nbytes);
+		void write(const std::uint8_t* buffer, const int& nbytes);
+		int try_accept(std::shared_ptr<socket_impl>& new_socket);
+		void listen(const int& backlog);
+	public:
+		void set_option_int(const int& id, const int& val);
+	public:
+		void accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept;
+		void close(std::error_code& ec) noexcept;
+		void connect(const endpoint& remote, const int& timeout,
+			std::error_code& ec) noexcept;
+		int try_accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept;
+		void listen(const int& backlog, std::error_code& ec) noexcept;
+		void set_option_int(const int& level, const int& id, const int& val,
+			std::error_code& ec) noexcept;
+	public:
+		/**
+		* Gets the ring this socket submits its operations to.
+		*/
+		NET_INLINE const std::shared_ptr<io_uring_ring>& get_ring(void) const;
+	private:
+		int submit_connect(const sio::sockaddr_t* addr, const int& len,
+			const int& timeout);
+		int receive(std::uint8_t* buffer, const int& nbytes, const bool& select);
+		bool pop_accepted(int& fd, int& error, bool& arm);
+		bool accepted(std::shared_ptr<socket_impl>& new_socket, const int& fd,
+			std::error_code& ec) noexcept;
+		void release_accept_queue(void);
+	private:
+		io_uring_socket_impl(const io_uring_socket_impl&);
+		io_uring_socket_impl& operator=(const io_uring_socket_impl&);
+		io_uring_socket_impl& operator=(const io_uring_socket_impl&&);
+	};
+
+	class io_uring_server_socket_impl : public io_uring_socket_impl
+	{
+	public:
+		io_uring_server_socket_impl(const std::shared_ptr<io_uring_ring>& ring);
+	public:
+		virtual ~io_uring_server_socket_impl(void);
+	public:
+		void create(const int& family);
+		void create(const int& family, std::error_code& ec) noexcept;
+	private:
+		io_uring_server_socket_impl(const io_uring_server_socket_impl&);
+		io_uring_server_socket_impl& operator=(const io_uring_server_socket_impl&);
+		io_uring_server_socket_impl& operator=(const io_uring_server_socket_impl&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.io_uring_socket_impl.inl"
+#endif
+
+#endif
+
+#endif
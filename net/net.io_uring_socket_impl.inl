@@ -0,0 +1,6 @@
+
+NET_INLINE const std::shared_ptr<net::io_uring_ring>&
+net::io_uring_socket_impl::get_ring(void) const
+{
+	return ring_;
+}
@@ -0,0 +1,43 @@
+#ifndef __NET_IO_URING_SOCKET_IMPL_FACTORY__
+#define __NET_IO_URING_SOCKET_IMPL_FACTORY__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include "net.socket_impl_factory.h"
+#include "net.io_uring_ring.h"
+
+namespace net
+{
+	/**
+	* Creates io_uring backed client sockets sharing one ring. Install with
+	* socket::set_socket_impl_factory.
+	*/
+	class io_uring_socket_impl_factory : public socket_impl_factory
+	{
+		std::shared_ptr<io_uring_ring> ring_;
+	public:
+		io_uring_socket_impl_factory(const std::shared_ptr<io_uring_ring>& ring);
+	public:
+		std::shared_ptr<socket_impl> create_socket_impl(void);
+	};
+
+	/**
+	* Creates io_uring backed server sockets sharing one ring. Install with
+	* server_socket::set_socket_impl_factory.
+	*/
+	class io_uring_server_socket_impl_factory : public socket_impl_factory
+	{
+		std::shared_ptr<io_uring_ring> ring_;
+	public:
+		io_uring_server_socket_impl_factory(
+			const std::shared_ptr<io_uring_ring>& ring);
+	public:
+		std::shared_ptr<socket_impl> create_socket_impl(void);
+	};
+}
+
+#endif
+
+#endif
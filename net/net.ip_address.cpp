@@ -0,0 +1,95 @@
+#include "net.address_text.h"
+#include "net.ip_address.h"
+
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_trivially_copyable<net::ip_address>::value,
+	"ip_address must be trivially copyable");
+
+net::ip_address::ip_address(void)
+	: bytes_()
+	, family_(AF_INET)
+{
+}
+
+net::ip_address::ip_address(const std::uint8_t* bytes, const int& length)
+	: bytes_()
+	, family_(length == 4 ? AF_INET : AF_INET6)
+{
+	if (length != 4 && length != 16)
+		throw std::invalid_argument("Invalid address length");
+	std::memcpy(bytes_, bytes, length);
+}
+
+net::ip_address::ip_address(const net_address& addr)
+	: bytes_()
+	, family_(static_cast<std::uint16_t>(addr.get_family()))
+{
+	std::vector<std::uint8_t> bytes = addr.get_address();
+	std::memcpy(bytes_, bytes.data(), bytes.size() < 16 ? bytes.size() : 16);
+}
+
+net::ip_address net::ip_address::of_v4(const std::uint32_t& addr)
+{
+	const std::uint8_t bytes[4] = {
+		static_cast<std::uint8_t>(addr >> 24), static_cast<std::uint8_t>(addr >> 16),
+		static_cast<std::uint8_t>(addr >> 8), static_cast<std::uint8_t>(addr)
+	};
+	return ip_address(bytes, 4);
+}
+
+net::ip_address net::ip_address::any(const int& family)
+{
+	const std::uint8_t zero[16] = {};
+	return ip_address(zero, family == AF_INET6 ? 16 : 4);
+}
+
+net::ip_address net::ip_address::loopback(const int& family)
+{
+	if (family != AF_INET6)
+		return of_v4(0x7f000001);
+	const std::uint8_t bytes[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+	return ip_address(bytes, 16);
+}
+
+bool net::ip_address::try_parse(const std::string& text, ip_address& addr)
+{
+	std::uint8_t bytes[16];
+	int length = address_text::parse(text.data(), text.data() + text.size(), bytes);
+	if (length == 0)
+		return false;
+	addr = ip_address(bytes, length);
+	return true;
+}
+
+net::ip_address net::ip_address::parse(const std::string& text)
+{
+	ip_address addr;
+	if (!try_parse(text, addr))
+		throw std::invalid_argument("Not a numeric address: " + text);
+	return addr;
+}
+
+std::string net::ip_address::to_string(void) const
+{
+	char text[max_text_length];
+	return std::string(text, format(text));
+}
+
+char* net::ip_address::format(char* out) const
+{
+	if (family_ == AF_INET6)
+		return address_text::format_v6(bytes_, out);
+	return address_text::format_v4(bytes_, out);
+}
+
+std::shared_ptr<net::net_address> net::ip_address::to_net_address(void) const
+{
+	return net_address::of(std::vector<std::uint8_t>(bytes_, bytes_ + get_length()));
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.ip_address.inl"
+#endif
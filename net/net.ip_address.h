@@ -0,0 +1,148 @@
+#ifndef __NET_IP_ADDRESS__
+#define __NET_IP_ADDRESS__
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "sio.h"
+#include "net.config.h"
+#include "net.net_address.h"
+
+namespace net
+{
+	/**
+	* An IPv4 or IPv6 address held by value. Unlike net_address it needs no
+	* allocation, is trivially copyable and compares and hashes by its
+	* bytes, so it can key containers on the per-connection path.
+	*/
+	class ip_address
+	{
+		std::uint8_t bytes_[16];
+		std::uint16_t family_;
+	public:
+		/**
+		* Longest text written by format.
+		*/
+		static const int max_text_length = 45;
+	public:
+		/**
+		* Creates the IPv4 wildcard address.
+		*/
+		ip_address(void);
+
+		/**
+		* Creates an address from its network-order bytes, 4 for IPv4 and 16
+		* for IPv6.
+		*/
+		ip_address(const std::uint8_t* bytes, const int& length);
+
+		/**
+		* Creates an address with the bytes of a net_address.
+		*/
+		explicit ip_address(const net_address& addr);
+	public:
+		/**
+		* Returns the IPv4 address held in host order by addr.
+		*/
+		static ip_address of_v4(const std::uint32_t& addr);
+
+		/**
+		* Returns the wildcard address of a family.
+		*/
+		static ip_address any(const int& family = AF_INET);
+
+		/**
+		* Returns the loopback address of a family.
+		*/
+		static ip_address loopback(const int& family = AF_INET);
+
+		/**
+		* Parses a numeric IPv4 or IPv6 address. Returns false if text is
+		* not one.
+		*/
+		static bool try_parse(const std::string& text, ip_address& addr);
+
+		/**
+		* Parses a numeric IPv4 or IPv6 address, throwing
+		* std::invalid_argument if text is not one.
+		*/
+		static ip_address parse(const std::string& text);
+	public:
+		/**
+		* Returns the address in its textual form.
+		*/
+		std::string to_string(void) const;
+
+		/**
+		* Writes the textual form of the address to out, which must have
+		* room for max_text_length characters, and returns the end of the
+		* text. No terminating null is written.
+		*/
+		char* format(char* out) const;
+
+		/**
+		* Returns an equal net_address.
+		*/
+		std::shared_ptr<net_address> to_net_address(void) const;
+	public:
+		/**
+		* Returns AF_INET or AF_INET6.
+		*/
+		NET_INLINE int get_family(void) const;
+
+		/**
+		* Returns the network-order bytes of the address.
+		*/
+		NET_INLINE const std::uint8_t* get_bytes(void) const;
+
+		/**
+		* Returns the number of bytes of the address, 4 or 16.
+		*/
+		NET_INLINE int get_length(void) const;
+
+		/**
+		* Returns an IPv4 address in host order.
+		*/
+		NET_INLINE std::uint32_t to_v4(void) const;
+
+		/**
+		* Tests if this is a wildcard address.
+		*/
+		NET_INLINE bool is_any_local_address(void) const;
+
+		/**
+		* Tests if this is a loopback address.
+		*/
+		NET_INLINE bool is_loopback_address(void) const;
+
+		/**
+		* Returns a hash of the address.
+		*/
+		NET_INLINE std::size_t hash(void) const;
+	public:
+		NET_INLINE bool operator==(const ip_address& other) const;
+		NET_INLINE bool operator!=(const ip_address& other) const;
+		NET_INLINE bool operator<(const ip_address& other) const;
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<net::ip_address>
+	{
+		std::size_t operator()(const net::ip_address& addr) const
+		{
+			return addr.hash();
+		}
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.ip_address.inl"
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+NET_INLINE int net::ip_address::get_family(void) const
+{
+	return family_;
+}
+
+NET_INLINE const std::uint8_t* net::ip_address::get_bytes(void) const
+{
+	return bytes_;
+}
+
+NET_INLINE int net::ip_address::get_length(void) const
+{
+	return family_ == AF_INET ? 4 : 16;
+}
+
+NET_INLINE std::uint32_t net::ip_address::to_v4(void) const
+{
+	return (static_cast<std::uint32_t>(bytes_[0]) << 24) |
+		(static_cast<std::uint32_t>(bytes_[1]) << 16) |
+		(static_cast<std::uint32_t>(bytes_[2]) << 8) | bytes_[3];
+}
+
+NET_INLINE bool net::ip_address::is_any_local_address(void) const
+{
+	// unused bytes of an IPv4 address are zero
+	static const std::uint8_t zero[16] = {};
+	return std::memcmp(bytes_, zero, sizeof(bytes_)) == 0;
+}
+
+NET_INLINE bool net::ip_address::is_loopback_address(void) const
+{
+	if (family_ == AF_INET)
+		return bytes_[0] == 127;
+	static const std::uint8_t loopback[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+	return std::memcmp(bytes_, loopback, sizeof(bytes_)) == 0;
+}
+
+NET_INLINE std::size_t net::ip_address::hash(void) const
+{
+	std::uint64_t lo;
+	std::uint64_t hi;
+	std::memcpy(&lo, bytes_, sizeof(lo));
+	std::memcpy(&hi, bytes_ + 8, sizeof(hi));
+	std::uint64_t h = (lo ^ (hi * 0x9e3779b97f4a7c15ULL) ^ family_) * 0xff51afd7ed558ccdULL;
+	return static_cast<std::size_t>(h ^ (h >> 33));
+}
+
+NET_INLINE bool net::ip_address::operator==(const ip_address& other) const
+{
+	return family_ == other.family_ &&
+		std::memcmp(bytes_, other.bytes_, sizeof(bytes_)) == 0;
+}
+
+NET_INLINE bool net::ip_address::operator!=(const ip_address& other) const
+{
+	return !(*this == other);
+}
+
+NET_INLINE bool net::ip_address::operator<(const ip_address& other) const
+{
+	if (family_ != other.family_)
+		return family_ < other.family_;
+	return std::memcmp(bytes_, other.bytes_, sizeof(bytes_)) < 0;
+}
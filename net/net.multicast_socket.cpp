@@ -0,0 +1,308 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "net.error.h"
+#include "net.exceptions.h"
+#include "net.multicast_socket.h"
+
+#if !defined(_WIN32)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#if defined(NET_LINUX)
+#if !defined(IP_MULTICAST_ALL)
+#define IP_MULTICAST_ALL 49
+#endif
+#if !defined(IPV6_MULTICAST_ALL)
+#define IPV6_MULTICAST_ALL 29
+#endif
+#endif
+
+namespace
+{
+	void throw_socket_error(const char* call, const std::error_code& ec)
+	{
+		throw net::socket_exception(sio::errno_exception(call, ec.value()).what());
+	}
+
+	int socket_error(void)
+	{
+#if defined(_WIN32)
+		return sio::socket_errno(::WSAGetLastError());
+#else
+		return errno;
+#endif
+	}
+
+	// binding to the group keeps the datagrams of other groups sent to
+	// the port out; Windows only binds to local addresses
+	net::endpoint feed_endpoint(const net::endpoint& group)
+	{
+		if (group.is_unspecified())
+			throw std::invalid_argument("Unspecified endpoint");
+#if defined(_WIN32)
+		return net::endpoint(net::ip_address::any(group.get_family()), group.get_port());
+#else
+		return group;
+#endif
+	}
+}
+
+// the buffer size is passed by reference, which needs its definition
+const int net::multicast_socket::default_receive_buffer_size;
+
+net::multicast_socket::multicast_socket(const std::uint16_t& port, const bool& prefer_ipv6)
+	: datagram_socket(prefer_ipv6)
+	, family_(prefer_ipv6 ? AF_INET6 : AF_INET)
+{
+	init(endpoint(ip_address::any(family_), port));
+}
+
+net::multicast_socket::multicast_socket(const endpoint& group, const int& interface_index)
+	: datagram_socket(group.get_family() == AF_INET6)
+	, family_(group.get_family() == AF_INET6 ? AF_INET6 : AF_INET)
+{
+	init(feed_endpoint(group));
+	std::error_code ec;
+	join_group(group.get_address(), interface_index, ec);
+	if (ec) {
+		close();
+		throw_socket_error("setsockopt", ec);
+	}
+}
+
+net::multicast_socket::multicast_socket(const endpoint& group, const ip_address& source,
+	const int& interface_index)
+	: datagram_socket(group.get_family() == AF_INET6)
+	, family_(group.get_family() == AF_INET6 ? AF_INET6 : AF_INET)
+{
+	init(feed_endpoint(group));
+	std::error_code ec;
+	join_source_group(group.get_address(), source, interface_index, ec);
+	if (ec) {
+		close();
+		throw_socket_error("setsockopt", ec);
+	}
+}
+
+net::multicast_socket::~multicast_socket(void)
+{
+}
+
+void net::multicast_socket::join_group(const ip_address& group, const int& interface_index)
+{
+	std::error_code ec;
+	join_group(group, interface_index, ec);
+	if (ec)
+		throw_socket_error("setsockopt", ec);
+}
+
+void net::multicast_socket::leave_group(const ip_address& group, const int& interface_index)
+{
+	std::error_code ec;
+	leave_group(group, interface_index, ec);
+	if (ec)
+		throw_socket_error("setsockopt", ec);
+}
+
+void net::multicast_socket::join_source_group(const ip_address& group,
+	const ip_address& source, const int& interface_index)
+{
+	std::error_code ec;
+	join_source_group(group, source, interface_index, ec);
+	if (ec)
+		throw_socket_error("setsockopt", ec);
+}
+
+void net::multicast_socket::leave_source_group(const ip_address& group,
+	const ip_address& source, const int& interface_index)
+{
+	std::error_code ec;
+	leave_source_group(group, source, interface_index, ec);
+	if (ec)
+		throw_socket_error("setsockopt", ec);
+}
+
+void net::multicast_socket::join_group(const ip_address& group, const int& interface_index,
+	std::error_code& ec) noexcept
+{
+	membership(true, group, nullptr, interface_index, ec);
+}
+
+void net::multicast_socket::leave_group(const ip_address& group, const int& interface_index,
+	std::error_code& ec) noexcept
+{
+	membership(false, group, nullptr, interface_index, ec);
+}
+
+void net::multicast_socket::join_source_group(const ip_address& group,
+	const ip_address& source, const int& interface_index, std::error_code& ec) noexcept
+{
+	membership(true, group, &source, interface_index, ec);
+}
+
+void net::multicast_socket::leave_source_group(const ip_address& group,
+	const ip_address& source, const int& interface_index, std::error_code& ec) noexcept
+{
+	membership(false, group, &source, interface_index, ec);
+}
+
+void net::multicast_socket::set_receive_buffer_size(const int& size)
+{
+#if defined(NET_LINUX)
+	check_open();
+	std::error_code ec;
+	get_impl()->set_option_int(SOL_SOCKET, SO_RCVBUFFORCE, size, ec);
+	if (!ec)
+		return;
+#endif
+	datagram_socket::set_receive_buffer_size(size);
+}
+
+bool net::multicast_socket::get_multicast_all(void)
+{
+#if defined(NET_LINUX)
+	return family_ == AF_INET6 ?
+		get_option(IPPROTO_IPV6, IPV6_MULTICAST_ALL) != 0 :
+		get_option(IPPROTO_IP, IP_MULTICAST_ALL) != 0;
+#else
+	return true;
+#endif
+}
+
+void net::multicast_socket::set_multicast_all(const bool& on)
+{
+#if defined(NET_LINUX)
+	if (family_ == AF_INET6)
+		set_option(IPPROTO_IPV6, IPV6_MULTICAST_ALL, on ? 1 : 0);
+	else
+		set_option(IPPROTO_IP, IP_MULTICAST_ALL, on ? 1 : 0);
+#else
+	if (!on)
+		throw_socket_error("setsockopt", make_socket_error(EOPNOTSUPP));
+#endif
+}
+
+bool net::multicast_socket::get_loopback_mode(void)
+{
+	return family_ == AF_INET6 ?
+		get_option(IPPROTO_IPV6, IPV6_MULTICAST_LOOP) != 0 :
+		get_option(IPPROTO_IP, IP_MULTICAST_LOOP) != 0;
+}
+
+void net::multicast_socket::set_loopback_mode(const bool& on)
+{
+	if (family_ == AF_INET6)
+		set_option(IPPROTO_IPV6, IPV6_MULTICAST_LOOP, on ? 1 : 0);
+	else
+		set_option(IPPROTO_IP, IP_MULTICAST_LOOP, on ? 1 : 0);
+}
+
+int net::multicast_socket::get_time_to_live(void)
+{
+	return family_ == AF_INET6 ?
+		get_option(IPPROTO_IPV6, IPV6_MULTICAST_HOPS) :
+		get_option(IPPROTO_IP, IP_MULTICAST_TTL);
+}
+
+void net::multicast_socket::set_time_to_live(const int& ttl)
+{
+	if (family_ == AF_INET6)
+		set_option(IPPROTO_IPV6, IPV6_MULTICAST_HOPS, ttl);
+	else
+		set_option(IPPROTO_IP, IP_MULTICAST_TTL, ttl);
+}
+
+void net::multicast_socket::set_interface(const int& interface_index)
+{
+	if (family_ == AF_INET6) {
+		set_option(IPPROTO_IPV6, IPV6_MULTICAST_IF, interface_index);
+		return;
+	}
+	check_open();
+#if defined(NET_LINUX)
+	struct ip_mreqn req;
+	std::memset(&req, 0, sizeof(req));
+	req.imr_ifindex = interface_index;
+	if (::setsockopt(get_impl()->get_native_socket(), IPPROTO_IP, IP_MULTICAST_IF,
+		&req, sizeof(req)) != 0)
+		throw_socket_error("setsockopt", make_socket_error(socket_error()));
+#else
+	// IPv4 selects the interface by address outside Linux
+	throw_socket_error("setsockopt", make_socket_error(EOPNOTSUPP));
+#endif
+}
+
+void net::multicast_socket::init(const endpoint& local)
+{
+	try {
+		set_reuse_address(true);
+		set_receive_buffer_size(default_receive_buffer_size);
+#if defined(NET_LINUX)
+		// kernels before 4.20 lack IPV6_MULTICAST_ALL; the socket then
+		// receives every group joined for its port, as any socket did
+		std::error_code ec;
+		if (family_ == AF_INET6)
+			get_impl()->set_option_int(IPPROTO_IPV6, IPV6_MULTICAST_ALL, 0, ec);
+		else
+			set_option(IPPROTO_IP, IP_MULTICAST_ALL, 0);
+		get_impl()->set_drop_counting(true, ec);
+		if (ec)
+			throw_socket_error("setsockopt", ec);
+#endif
+		bind(local);
+	}
+	catch (const socket_exception&) {
+		close();
+		throw;
+	}
+}
+
+void net::multicast_socket::membership(const bool& join, const ip_address& group,
+	const ip_address* source, const int& interface_index, std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return;
+	}
+#if defined(MCAST_JOIN_GROUP)
+	// the protocol-independent requests take an interface index for both
+	// families, and are the only ones to take a source for IPv6
+	const int level = group.get_family() == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+	const endpoint g(group, 0);
+	int result;
+	if (source == nullptr) {
+		struct group_req req;
+		std::memset(&req, 0, sizeof(req));
+		req.gr_interface = static_cast<std::uint32_t>(interface_index);
+		std::memcpy(&req.gr_group, g.data(), g.size());
+		result = ::setsockopt(get_impl()->get_native_socket(), level,
+			join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, (const char*) &req, sizeof(req));
+	}
+	else {
+		const endpoint s(*source, 0);
+		struct group_source_req req;
+		std::memset(&req, 0, sizeof(req));
+		req.gsr_interface = static_cast<std::uint32_t>(interface_index);
+		std::memcpy(&req.gsr_group, g.data(), g.size());
+		std::memcpy(&req.gsr_source, s.data(), s.size());
+		result = ::setsockopt(get_impl()->get_native_socket(), level,
+			join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP,
+			(const char*) &req, sizeof(req));
+	}
+	if (result != 0)
+		ec = make_socket_error(socket_error());
+#else
+	(void) join;
+	(void) group;
+	(void) source;
+	(void) interface_index;
+	ec = make_socket_error(EOPNOTSUPP);
+#endif
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.multicast_socket.inl"
+#endif
@@ -0,0 +1,154 @@
+#ifndef __NET_MULTICAST_SOCKET__
+#define __NET_MULTICAST_SOCKET__
+
+#include <cstdint>
+#include <system_error>
+
+#include "net.datagram_socket.h"
+#include "net.endpoint.h"
+#include "net.ip_address.h"
+
+namespace net
+{
+	/**
+	* A UDP socket receiving multicast feeds. It is created with
+	* SO_REUSEADDR, so several consumers may share a port, with a large
+	* receive buffer to absorb bursts, and on Linux with IP_MULTICAST_ALL
+	* disabled, so it only receives the groups it joined itself rather
+	* than every group joined on the host for its port.
+	*
+	* Groups are joined per interface, either any source (IGMPv2/MLDv1)
+	* or one source (source-specific multicast). The receives of
+	* datagram_socket apply, receive_many taking whatever the feed queued
+	* with a single call.
+	*
+	* The kernel reports the datagrams it dropped because the receive
+	* buffer was full (SO_RXQ_OVFL) and get_dropped returns that count,
+	* which tells when the consumer falls behind. It counts per socket:
+	* to count per group, use a socket per group, created bound to the
+	* group so it receives nothing else.
+	*/
+	class multicast_socket : public datagram_socket
+	{
+	public:
+		/**
+		* Receive buffer requested at creation. The kernel caps it at
+		* net.core.rmem_max unless the process has CAP_NET_ADMIN.
+		*/
+		static const int default_receive_buffer_size = 16 * 1024 * 1024;
+	private:
+		int family_;
+	public:
+		/**
+		* Creates a socket bound to the ANY address and port, which
+		* receives the groups it joins on that port.
+		*/
+		multicast_socket(const std::uint16_t& port, const bool& prefer_ipv6 = false);
+
+		/**
+		* Creates a socket for one feed: bound to group where the system
+		* allows it, and joined to it on the interface of the given index,
+		* zero letting the system choose.
+		*/
+		explicit multicast_socket(const endpoint& group, const int& interface_index = 0);
+
+		/**
+		* Creates a socket for one feed from a single source.
+		*/
+		multicast_socket(const endpoint& group, const ip_address& source,
+			const int& interface_index = 0);
+	public:
+		virtual ~multicast_socket(void);
+	public:
+		/**
+		* Joins group on the interface of the given index, zero letting the
+		* system choose, to receive from any source.
+		*/
+		virtual void join_group(const ip_address& group, const int& interface_index = 0);
+
+		/**
+		* Leaves a group joined with join_group.
+		*/
+		virtual void leave_group(const ip_address& group, const int& interface_index = 0);
+
+		/**
+		* Joins group to receive from source only.
+		*/
+		virtual void join_source_group(const ip_address& group, const ip_address& source,
+			const int& interface_index = 0);
+
+		/**
+		* Leaves a group joined with join_source_group.
+		*/
+		virtual void leave_source_group(const ip_address& group, const ip_address& source,
+			const int& interface_index = 0);
+	public:
+		/**
+		* The overloads below report failures in ec instead of throwing, and
+		* clear it on success.
+		*/
+		virtual void join_group(const ip_address& group, const int& interface_index,
+			std::error_code& ec) noexcept;
+		virtual void leave_group(const ip_address& group, const int& interface_index,
+			std::error_code& ec) noexcept;
+		virtual void join_source_group(const ip_address& group, const ip_address& source,
+			const int& interface_index, std::error_code& ec) noexcept;
+		virtual void leave_source_group(const ip_address& group, const ip_address& source,
+			const int& interface_index, std::error_code& ec) noexcept;
+	public:
+		/**
+		* Sets the receive buffer size, beyond net.core.rmem_max with
+		* SO_RCVBUFFORCE if the process is allowed to.
+		*/
+		virtual void set_receive_buffer_size(const int& size);
+
+		/**
+		* Tests and enables/disables IP_MULTICAST_ALL: receiving the
+		* datagrams of every group joined on the host for the bound port.
+		* Always enabled outside Linux.
+		*/
+		virtual bool get_multicast_all(void);
+		virtual void set_multicast_all(const bool& on);
+
+		/**
+		* Tests and enables/disables the loopback of datagrams sent to a
+		* group to the sockets of this host.
+		*/
+		virtual bool get_loopback_mode(void);
+		virtual void set_loopback_mode(const bool& on);
+
+		/**
+		* Gets and sets the time-to-live, or hop limit, of datagrams sent to
+		* a group.
+		*/
+		virtual int get_time_to_live(void);
+		virtual void set_time_to_live(const int& ttl);
+
+		/**
+		* Sets the interface datagrams sent to a group leave from, by index.
+		*/
+		virtual void set_interface(const int& interface_index);
+
+		/**
+		* Returns the number of datagrams the kernel dropped on this socket
+		* because its receive buffer was full, as of when the latest
+		* datagram received was queued: drops show once the first datagram
+		* queued after them is received. The count wraps at 2^32.
+		*/
+		NET_INLINE std::uint32_t get_dropped(void);
+	private:
+		void init(const endpoint& local);
+		void membership(const bool& join, const ip_address& group, const ip_address* source,
+			const int& interface_index, std::error_code& ec) noexcept;
+	private:
+		multicast_socket(const multicast_socket&);
+		multicast_socket& operator=(const multicast_socket&);
+		multicast_socket& operator=(const multicast_socket&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.multicast_socket.inl"
+#endif
+
+#endif
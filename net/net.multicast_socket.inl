@@ -0,0 +1,4 @@
+NET_INLINE std::uint32_t net::multicast_socket::get_dropped(void)
+{
+	return get_impl()->get_dropped();
+}
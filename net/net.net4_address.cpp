@@ -41,6 +41,10 @@ std::shared_ptr<net::net_address> net::net4_address::of(
 
 std::string net::net4_address::get_name_info(const int& flags) const
 {
+	// numeric text needs no system call
+	if (flags == NI_NUMERICHOST)
+		return to_string();
+
 	sio::sock_addr4 sa(address_);
 	char hostname[1025];
 
@@ -2,8 +2,8 @@
 #define __NET_NET4_ADDRESS__
 
 #include <memory>
-#include <sstream>
 
+#include "net.address_text.h"
 #include "net.net_address.h"
 
 namespace net
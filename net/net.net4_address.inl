@@ -42,10 +42,12 @@ NET_INLINE std::vector<std::uint8_t> net::net4_address::get_address(void) const
 
 NET_INLINE std::string net::net4_address::to_string(void) const
 {
-	std::stringstream stream;
-	stream << ((address_ >> 24) & 0xFF) << "."
-		<< ((address_ >> 16) & 0xFF) << "."
-		<< ((address_ >> 8) & 0xFF) << "."
-		<< ((address_ >> 0) & 0xFF);
-	return stream.str();
+	const std::uint8_t bytes[4] = {
+		(std::uint8_t)((address_ >> 24) & 0xFF),
+		(std::uint8_t)((address_ >> 16) & 0xFF),
+		(std::uint8_t)((address_ >> 8) & 0xFF),
+		(std::uint8_t)((address_ >> 0) & 0xFF)
+	};
+	char text[address_text::max_v4_length];
+	return std::string(text, address_text::format_v4(bytes, text));
 }
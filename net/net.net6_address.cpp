@@ -1,7 +1,6 @@
 #include <memory>
-#include <sstream>
-#include <iomanip> 
 
+#include "net.address_text.h"
 #include "net.exceptions.h"
 #include "net.net6_address.h"
 
@@ -42,6 +41,10 @@ std::shared_ptr<net::net_address> net::net6_address::of(
 
 std::string net::net6_address::get_name_info(const int& flags) const
 {
+	// numeric text needs no system call
+	if (flags == NI_NUMERICHOST)
+		return to_string();
+
 	sio::sock_addr6 sa(address_);
 	char hostname[1025];
 
@@ -56,14 +59,8 @@ std::string net::net6_address::get_name_info(const int& flags) const
 
 std::string net::net6_address::to_string(void) const
 {
-	std::stringstream stream;
-	for (std::size_t i = 0; i < 16; ++i) {
-		if (i != 0 && i % 2 == 0)
-			stream << ":";
-		stream << std::setfill('0') << std::setw(2)
-			<< std::hex << (address_[i] & 0xFF);
-	}
-	return stream.str();
+	char text[address_text::max_v6_length];
+	return std::string(text, address_text::format_v6(address_, text));
 }
 
 #if !defined(__NET_INLINE__)
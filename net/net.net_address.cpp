@@ -1,7 +1,11 @@
+#include "net.address_text.h"
 #include "net.exceptions.h"
 #include "net.net_address.h"
 #include "net.net4_address.h"
 #include "net.net6_address.h"
+#include "net.resolver_cache.h"
+
+#include <cctype>
 
 net::net_address::net_address(const int& family, const std::string& hostname)
 	: family_(family)
@@ -104,6 +108,18 @@ net::net_address::get_all_by_name(const std::string& hostname)
 std::shared_ptr<net::net_address>
 net::net_address::get_numeric_address(const std::string& address)
 {
+	std::uint8_t bytes[16];
+	int length = address_text::parse(address.data(), address.data() + address.size(), bytes);
+	if (length == 4)
+		return std::make_shared<net4_address>(std::vector<std::uint8_t>(bytes, bytes + 4), "");
+	if (length == 16)
+		return get_by_address(std::vector<std::uint8_t>(bytes, bytes + 16));
+
+	// scoped IPv6 literals and the legacy IPv4 forms which
+	// disallow_deprecated_formats rejects are left to getaddrinfo
+	if (!may_be_numeric(address))
+		return nullptr;
+
 	sio::addrinfo hints;
 	hints.ai_flags = AI_NUMERICHOST;
 	sio::addrinfo_t* result = nullptr;
@@ -130,18 +146,39 @@ bool net::net_address::disallow_deprecated_formats(
 		return false;
 	if (hostname.find(':') != std::string::npos)
 		return false;
-	try {
-		std::uint32_t notused;
-		sio::inet_pton(AF_INET, hostname.c_str(), &notused);
-		return false;
-	}
-	catch (const sio::errno_exception&) {
+	std::uint8_t notused[4];
+	return !address_text::parse_v4(hostname.data(), hostname.data() + hostname.size(), notused);
+}
+
+bool net::net_address::may_be_numeric(const std::string& address)
+{
+	if (address.find('%') != std::string::npos)
 		return true;
+	for (std::size_t i = 0; i < address.size(); ++i) {
+		char c = address[i];
+		if (!std::isxdigit(static_cast<unsigned char>(c)) && c != '.' && c != ':'
+			&& c != 'x' && c != 'X')
+			return false;
 	}
+	return true;
+}
+
+std::shared_ptr<net::net_address> net::net_address::get_local_host(
+	const bool& prefer_ipv6)
+{
+	return find_best_match(lookup_host_by_name(
+		resolver_cache::get_default().get_local_host_name()),
+		prefer_ipv6 ? AF_INET6 : AF_INET);
 }
 
 std::vector<std::shared_ptr<net::net_address>>
 net::net_address::lookup_host_by_name(const std::string& hostname)
+{
+	return resolver_cache::get_default().resolve(hostname);
+}
+
+std::vector<std::shared_ptr<net::net_address>>
+net::net_address::query_host_by_name(const std::string& hostname)
 {
 	sio::addrinfo hints;
 	hints.ai_flags = AI_ADDRCONFIG;
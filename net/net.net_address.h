@@ -46,7 +46,7 @@ namespace net
 		* Returns a net_address for the local host if possible, or the
 		* loopback address otherwise.
 		*/
-		NET_INLINE static std::shared_ptr<net_address> get_local_host(
+		static std::shared_ptr<net_address> get_local_host(
 			const bool& prefer_ipv6 = false);
 	public:
 		/**
@@ -121,10 +121,18 @@ namespace net
 			parse_numeric_address(const std::string& address);
 
 		/**
-		* Resolves a hostname to its IP addresses.
+		* Resolves a hostname to its IP addresses through
+		* resolver_cache::get_default().
 		*/
 		static std::vector<std::shared_ptr<net_address>>
 			lookup_host_by_name(const std::string& hostname);
+
+		/**
+		* Resolves a hostname to its IP addresses with the system resolver,
+		* bypassing the cache.
+		*/
+		static std::vector<std::shared_ptr<net_address>>
+			query_host_by_name(const std::string& hostname);
 	private:
 		const std::string& init_host_name(void);
 		const std::string& init_host_address(void);
@@ -140,6 +148,7 @@ namespace net
 			get_numeric_address(const std::string& address);
 		static bool disallow_deprecated_formats(
 			const std::string& hostname, const std::shared_ptr<net_address>& addr);
+		static bool may_be_numeric(const std::string& address);
 		static std::vector<std::shared_ptr<net_address>>
 			result_to_net_adresses(const sio::addrinfo_t* result);
 		static std::shared_ptr<net_address> find_best_match(
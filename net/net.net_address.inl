@@ -5,13 +5,6 @@ NET_INLINE std::shared_ptr<net::net_address> net::net_address::of(
 		prefer_ipv6 ? AF_INET6 : AF_INET);
 }
 
-NET_INLINE std::shared_ptr<net::net_address> net::net_address::get_local_host(
-	const bool& prefer_ipv6)
-{
-	return find_best_match(lookup_host_by_name(sio::uname_nodename()),
-		prefer_ipv6 ? AF_INET6 : AF_INET);
-}
-
 NET_INLINE const std::string& net::net_address::get_host_name(void) const
 {
 	return const_cast<net_address*>(this)->init_host_name();
@@ -0,0 +1,250 @@
+#include "net.address_text.h"
+#include "net.prefix_table.h"
+
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+
+net::prefix_table::prefix_table(void)
+	: entries_()
+	, prefixes_()
+{
+}
+
+net::prefix_table::~prefix_table(void)
+{
+}
+
+void net::prefix_table::insert(const ip_address& prefix, const int& length,
+	const std::int32_t& value)
+{
+	ip_address addr = prefix;
+	int bits = length;
+	normalize(addr, bits);
+	addr = mask(addr, bits);
+	prefixes_[std::make_pair(addr, bits)] = value;
+
+	entry leaf;
+	leaf.node_ = static_cast<std::uint32_t>(bits + 1);
+	leaf.value_ = value;
+	update(addr, bits, leaf, false);
+}
+
+void net::prefix_table::insert(const std::string& prefix, const std::int32_t& value)
+{
+	ip_address addr;
+	int length = 0;
+	if (!try_parse(prefix, addr, length))
+		throw std::invalid_argument("Not a prefix: " + prefix);
+	insert(addr, length, value);
+}
+
+bool net::prefix_table::remove(const ip_address& prefix, const int& length)
+{
+	ip_address addr = prefix;
+	int bits = length;
+	normalize(addr, bits);
+	addr = mask(addr, bits);
+	if (prefixes_.erase(std::make_pair(addr, bits)) == 0)
+		return false;
+
+	// the entries of the prefix fall back to the longest shorter one
+	entry cover;
+	cover.node_ = 0;
+	cover.value_ = 0;
+	for (int l = bits - 1; l >= 0; --l) {
+		std::map<std::pair<ip_address, int>, std::int32_t>::const_iterator it =
+			prefixes_.find(std::make_pair(mask(addr, l), l));
+		if (it != prefixes_.end()) {
+			cover.node_ = static_cast<std::uint32_t>(l + 1);
+			cover.value_ = it->second;
+			break;
+		}
+	}
+	update(addr, bits, cover, true);
+	return true;
+}
+
+void net::prefix_table::clear(void)
+{
+	std::vector<entry>().swap(entries_);
+	prefixes_.clear();
+}
+
+std::size_t net::prefix_table::load(std::istream& in, const std::int32_t& value)
+{
+	std::size_t count = 0;
+	std::size_t number = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		++number;
+		std::string::size_type hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+		std::string::size_type first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos)
+			continue;
+		std::string::size_type last = line.find_last_not_of(" \t\r");
+		std::string text = line.substr(first, last - first + 1);
+
+		ip_address prefix;
+		int length = 0;
+		if (!try_parse(text, prefix, length))
+			throw std::invalid_argument("Not a prefix on line " +
+				std::to_string(number) + ": " + text);
+		insert(prefix, length, value);
+		++count;
+	}
+	return count;
+}
+
+std::size_t net::prefix_table::load_file(const std::string& path,
+	const std::int32_t& value)
+{
+	std::ifstream in(path.c_str());
+	if (!in)
+		throw std::ios_base::failure("Cannot open " + path);
+	return load(in, value);
+}
+
+bool net::prefix_table::try_parse(const std::string& text, ip_address& prefix,
+	int& length)
+{
+	std::string::size_type slash = text.find('/');
+	const char* first = text.data();
+	const char* last = first + (slash == std::string::npos ? text.size() : slash);
+
+	std::uint8_t bytes[16];
+	int size = address_text::parse(first, last, bytes);
+	if (size == 0)
+		return false;
+	if (slash == std::string::npos) {
+		prefix = ip_address(bytes, size);
+		length = size * 8;
+		return true;
+	}
+
+	const char* p = last + 1;
+	const char* end = text.data() + text.size();
+	if (p == end || end - p > 3)
+		return false;
+	int bits = 0;
+	for (; p != end; ++p) {
+		if (*p < '0' || *p > '9')
+			return false;
+		bits = bits * 10 + (*p - '0');
+	}
+	if (bits > size * 8)
+		return false;
+	prefix = ip_address(bytes, size);
+	length = bits;
+	return true;
+}
+
+void net::prefix_table::update(const ip_address& prefix, const int& length,
+	const entry& leaf, const bool& restore)
+{
+	if (entries_.empty()) {
+		if (restore)
+			return;
+		entry none;
+		none.node_ = 0;
+		none.value_ = 0;
+		entries_.resize(2 * root_size, none);
+	}
+
+	const std::uint8_t* bytes = prefix.get_bytes();
+	std::size_t table = prefix.get_family() == AF_INET6 ? v6_root : 0;
+	int start = 0;
+	int stride = 16;
+	for (;;) {
+		int end = start + stride;
+		unsigned int index = bits_at(bytes, start, stride);
+		if (length <= end) {
+			// the prefix covers a range of entries at this level
+			unsigned int span = 1u << (end - length);
+			for (unsigned int i = 0; i < span; ++i)
+				fill(table + index + i, length, leaf, restore);
+			return;
+		}
+		std::size_t at = table + index;
+		if (entries_[at].node_ > 0xff)
+			table = (entries_[at].node_ >> 8) * chunk_size;
+		else if (!restore)
+			table = split(at);
+		else
+			return;
+		start = end;
+		stride = 4;
+	}
+}
+
+void net::prefix_table::fill(const std::size_t& index, const int& length,
+	const entry& leaf, const bool& restore)
+{
+	entry& e = entries_[index];
+	if (e.node_ > 0xff) {
+		std::size_t child = (e.node_ >> 8) * chunk_size;
+		for (int i = 0; i < chunk_size; ++i)
+			fill(child + i, length, leaf, restore);
+		return;
+	}
+	// longer prefixes expanded into the range keep their entries
+	std::uint32_t own = static_cast<std::uint32_t>(length + 1);
+	if (restore ? e.node_ == own : e.node_ <= own)
+		e = leaf;
+}
+
+std::size_t net::prefix_table::split(const std::size_t& index)
+{
+	std::size_t offset = entries_.size();
+	if (offset / chunk_size > 0xffffff)
+		throw std::length_error("Prefix table is full");
+	// the new chunk starts out with the entry it replaces
+	entry leaf = entries_[index];
+	entries_.resize(offset + chunk_size, leaf);
+	entries_[index].node_ = static_cast<std::uint32_t>(offset / chunk_size) << 8;
+	entries_[index].value_ = 0;
+	return offset;
+}
+
+void net::prefix_table::normalize(ip_address& prefix, int& length)
+{
+	int bits = prefix.get_length() * 8;
+	if (length < 0 || length > bits)
+		throw std::invalid_argument("Invalid prefix length");
+	// IPv4-mapped prefixes are kept with the IPv4 ones, where lookups of
+	// mapped addresses go
+	static const std::uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+	if (prefix.get_family() == AF_INET6 && length >= 96
+		&& std::memcmp(prefix.get_bytes(), mapped, sizeof(mapped)) == 0) {
+		prefix = ip_address(prefix.get_bytes() + 12, 4);
+		length -= 96;
+	}
+}
+
+net::ip_address net::prefix_table::mask(const ip_address& addr, const int& length)
+{
+	std::uint8_t bytes[16];
+	int size = addr.get_length();
+	std::memcpy(bytes, addr.get_bytes(), size);
+	int full = length / 8;
+	if (full < size) {
+		bytes[full] &= static_cast<std::uint8_t>(0xff00 >> (length % 8));
+		for (int i = full + 1; i < size; ++i)
+			bytes[i] = 0;
+	}
+	return ip_address(bytes, size);
+}
+
+unsigned int net::prefix_table::bits_at(const std::uint8_t* bytes, const int& start,
+	const int& count)
+{
+	if (count == 16)
+		return (static_cast<unsigned int>(bytes[start >> 3]) << 8) | bytes[(start >> 3) + 1];
+	return (bytes[start >> 3] >> (4 - (start & 4))) & 0xf;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.prefix_table.inl"
+#endif
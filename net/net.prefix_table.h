@@ -0,0 +1,143 @@
+#ifndef __NET_PREFIX_TABLE__
+#define __NET_PREFIX_TABLE__
+
+#include "net.config.h"
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "net.endpoint.h"
+#include "net.ip_address.h"
+
+namespace net
+{
+	/**
+	* Maps IPv4 and IPv6 prefixes in CIDR notation to values and finds the
+	* value of the longest prefix matching an address, for allow and deny
+	* lists checked on every accepted connection.
+	*
+	* Prefixes are expanded into a multibit trie: a 65536 entry root per
+	* family indexed by the first 16 bits, then 16 entry chunks indexed by
+	* 4 bits each, so an IPv4 lookup reads at most five entries while long
+	* lists of scattered prefixes stay small. IPv4-mapped IPv6 addresses
+	* are looked up as IPv4 addresses, and then against the IPv6 prefixes
+	* shorter than 96 bits which cover them.
+	*
+	* Lookups may run concurrently with each other but not with changes.
+	*/
+	class prefix_table
+	{
+		struct entry
+		{
+			std::uint32_t node_;	// chunk below << 8, or prefix length + 1, zero if none
+			std::int32_t value_;
+		};
+		static const int root_size = 65536;
+		static const int chunk_size = 16;
+		static const std::size_t v6_root = root_size;
+		std::vector<entry> entries_;
+		std::map<std::pair<ip_address, int>, std::int32_t> prefixes_;
+	public:
+		/**
+		* Creates an empty table.
+		*/
+		prefix_table(void);
+	public:
+		virtual ~prefix_table(void);
+	public:
+		/**
+		* Maps the first length bits of prefix to value, replacing the value
+		* of an equal prefix. Bits of prefix past length are ignored. Throws
+		* std::invalid_argument if length exceeds the address size.
+		*/
+		void insert(const ip_address& prefix, const int& length, const std::int32_t& value);
+
+		/**
+		* Maps a prefix given as text, either address/length or a single
+		* address, to value. Throws std::invalid_argument if the text is
+		* not a prefix.
+		*/
+		void insert(const std::string& prefix, const std::int32_t& value);
+
+		/**
+		* Removes a prefix. Returns false if it was not in the table.
+		*/
+		bool remove(const ip_address& prefix, const int& length);
+
+		/**
+		* Removes all prefixes.
+		*/
+		void clear(void);
+
+		/**
+		* Reads one prefix per line from in and maps each to value. Blank
+		* lines and text after '#' are ignored. Returns the number of
+		* prefixes read. Throws std::invalid_argument naming the line if one
+		* is not a prefix; the prefixes before it are kept.
+		*/
+		std::size_t load(std::istream& in, const std::int32_t& value);
+
+		/**
+		* Reads the file at path as load(in, value) does.
+		*/
+		std::size_t load_file(const std::string& path, const std::int32_t& value);
+
+		/**
+		* Parses address/length or a single address, whose length is then
+		* the full address size. Returns false if text is not a prefix.
+		*/
+		static bool try_parse(const std::string& text, ip_address& prefix, int& length);
+	public:
+		/**
+		* Finds the longest prefix matching addr. Returns false if none
+		* does, otherwise stores its value in value.
+		*/
+		NET_INLINE bool lookup(const ip_address& addr, std::int32_t& value) const;
+
+		/**
+		* Finds the longest prefix matching the address of peer.
+		*/
+		NET_INLINE bool lookup(const endpoint& peer, std::int32_t& value) const;
+
+		/**
+		* Tests if a prefix matches addr.
+		*/
+		NET_INLINE bool contains(const ip_address& addr) const;
+
+		/**
+		* Returns the number of prefixes in the table.
+		*/
+		NET_INLINE std::size_t size(void) const;
+
+		/**
+		* Returns the number of bytes taken by the trie.
+		*/
+		NET_INLINE std::size_t get_memory_usage(void) const;
+	private:
+		NET_INLINE bool find(const std::size_t& root, const std::uint8_t* bytes,
+			std::int32_t& value) const;
+		void update(const ip_address& prefix, const int& length,
+			const entry& leaf, const bool& restore);
+		void fill(const std::size_t& index, const int& length,
+			const entry& leaf, const bool& restore);
+		std::size_t split(const std::size_t& index);
+		static void normalize(ip_address& prefix, int& length);
+		static ip_address mask(const ip_address& addr, const int& length);
+		static unsigned int bits_at(const std::uint8_t* bytes, const int& start,
+			const int& count);
+	private:
+		prefix_table(const prefix_table&);
+		prefix_table& operator=(const prefix_table&);
+		prefix_table& operator=(const prefix_table&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.prefix_table.inl"
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+NET_INLINE bool net::prefix_table::lookup(const ip_address& addr,
+	std::int32_t& value) const
+{
+	if (entries_.empty())
+		return false;
+	const std::uint8_t* bytes = addr.get_bytes();
+	if (addr.get_family() != AF_INET6)
+		return find(0, bytes, value);
+	// IPv4-mapped peers of dual-stack listeners match IPv4 prefixes, which
+	// are longer than any IPv6 prefix covering the mapped range
+	static const std::uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+	if (std::memcmp(bytes, mapped, sizeof(mapped)) == 0 && find(0, bytes + 12, value))
+		return true;
+	return find(v6_root, bytes, value);
+}
+
+NET_INLINE bool net::prefix_table::lookup(const endpoint& peer,
+	std::int32_t& value) const
+{
+	return lookup(peer.get_address(), value);
+}
+
+NET_INLINE bool net::prefix_table::contains(const ip_address& addr) const
+{
+	std::int32_t value;
+	return lookup(addr, value);
+}
+
+NET_INLINE std::size_t net::prefix_table::size(void) const
+{
+	return prefixes_.size();
+}
+
+NET_INLINE std::size_t net::prefix_table::get_memory_usage(void) const
+{
+	return entries_.capacity() * sizeof(entry);
+}
+
+NET_INLINE bool net::prefix_table::find(const std::size_t& root,
+	const std::uint8_t* bytes, std::int32_t& value) const
+{
+	const entry* base = entries_.data();
+	const entry* e = base + root + ((bytes[0] << 8) | bytes[1]);
+	for (int i = 2; e->node_ > 0xff; ++i) {
+		e = base + (e->node_ >> 8) * chunk_size + (bytes[i] >> 4);
+		if (e->node_ <= 0xff)
+			break;
+		e = base + (e->node_ >> 8) * chunk_size + (bytes[i] & 0xf);
+	}
+	if (e->node_ == 0)
+		return false;
+	value = e->value_;
+	return true;
+}
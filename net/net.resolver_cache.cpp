@@ -0,0 +1,205 @@
+#include "net.exceptions.h"
+#include "net.resolver_cache.h"
+
+#include <chrono>
+#include <thread>
+
+net::resolver_cache::resolver_cache(const int& ttl, const int& negative_ttl,
+	const std::size_t& max_entries)
+	: lookup_(net_address::query_host_by_name)
+	, ttl_(ttl)
+	, negative_ttl_(negative_ttl)
+	, max_entries_(max_entries > 0 ? max_entries : 1)
+	, mutex_()
+	, resolved_()
+	, entries_()
+	, local_host_name_()
+	, local_host_expires_(0)
+	, hits_(0)
+	, misses_(0)
+{
+}
+
+net::resolver_cache::~resolver_cache(void)
+{
+}
+
+net::resolver_cache& net::resolver_cache::get_default(void)
+{
+	static resolver_cache* cache = new resolver_cache();
+	return *cache;
+}
+
+std::vector<std::shared_ptr<net::net_address>>
+net::resolver_cache::resolve(const std::string& hostname)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	bool waited = false;
+	for (;;) {
+		std::unordered_map<std::string, entry>::iterator it = entries_.find(hostname);
+		if (it == entries_.end())
+			break;
+		entry& e = it->second;
+		if (e.pending_) {
+			// another thread is resolving the name, share its answer
+			waited = true;
+			resolved_.wait(lock);
+			continue;
+		}
+		if (!waited && now_millis() >= e.expires_)
+			break;
+		hits_.fetch_add(1, std::memory_order_relaxed);
+		if (e.failed_)
+			throw unknown_host_exception(hostname);
+		return to_addresses(e.addresses_);
+	}
+	misses_.fetch_add(1, std::memory_order_relaxed);
+	trim(now_millis());
+	entry& e = entries_[hostname];
+	e.pending_ = true;
+	e.failed_ = false;
+	lookup_function lookup = lookup_;
+	lock.unlock();
+
+	std::vector<std::shared_ptr<net_address>> addresses;
+	bool failed = false;
+	try {
+		addresses = lookup(hostname);
+	}
+	catch (const unknown_host_exception&) {
+		failed = true;
+	}
+	catch (...) {
+		// not an answer about the name, let the next caller try again
+		lock.lock();
+		entries_.erase(hostname);
+		resolved_.notify_all();
+		throw;
+	}
+
+	lock.lock();
+	// references into the map survive rehashing and trim skips pending names
+	e.addresses_.clear();
+	for (std::size_t i = 0; i < addresses.size(); ++i)
+		e.addresses_.push_back(addresses[i]->get_address());
+	e.failed_ = failed || addresses.empty();
+	e.expires_ = now_millis() + static_cast<std::uint64_t>(
+		e.failed_ ? negative_ttl_ : ttl_);
+	e.pending_ = false;
+	resolved_.notify_all();
+	if (e.failed_)
+		throw unknown_host_exception(hostname);
+	return to_addresses(e.addresses_);
+}
+
+std::vector<std::vector<std::shared_ptr<net::net_address>>>
+net::resolver_cache::resolve_all(const std::vector<std::string>& hostnames,
+	const int& parallelism)
+{
+	std::vector<std::vector<std::shared_ptr<net_address>>> results(hostnames.size());
+	std::atomic<std::size_t> next(0);
+	std::function<void(void)> worker = [&]() {
+		for (;;) {
+			std::size_t i = next.fetch_add(1);
+			if (i >= hostnames.size())
+				return;
+			try {
+				results[i] = net_address::get_all_by_name(hostnames[i]);
+			}
+			catch (const std::exception&) {
+				// left empty
+			}
+		}
+	};
+	std::size_t count = hostnames.size();
+	if (parallelism > 0 && static_cast<std::size_t>(parallelism) < count)
+		count = static_cast<std::size_t>(parallelism);
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < count; ++i)
+		threads.push_back(std::thread(worker));
+	worker();
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	return results;
+}
+
+std::string net::resolver_cache::get_local_host_name(void)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::uint64_t now = now_millis();
+	if (local_host_name_.empty() || now >= local_host_expires_) {
+		local_host_name_ = sio::uname_nodename();
+		local_host_expires_ = now + static_cast<std::uint64_t>(ttl_);
+	}
+	return local_host_name_;
+}
+
+void net::resolver_cache::set_lookup(const lookup_function& lookup)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	lookup_ = lookup;
+}
+
+void net::resolver_cache::set_ttl(const int& ttl, const int& negative_ttl)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	ttl_ = ttl;
+	negative_ttl_ = negative_ttl;
+}
+
+void net::resolver_cache::remove(const std::string& hostname)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::unordered_map<std::string, entry>::iterator it = entries_.begin();
+	while (it != entries_.end()) {
+		if (!it->second.pending_ && (hostname.empty() || it->first == hostname))
+			it = entries_.erase(it);
+		else
+			++it;
+	}
+	local_host_expires_ = 0;
+}
+
+void net::resolver_cache::trim(const std::uint64_t& now)
+{
+	if (entries_.size() < max_entries_)
+		return;
+	std::unordered_map<std::string, entry>::iterator oldest = entries_.end();
+	std::unordered_map<std::string, entry>::iterator it = entries_.begin();
+	while (it != entries_.end()) {
+		if (it->second.pending_) {
+			++it;
+			continue;
+		}
+		if (now >= it->second.expires_) {
+			it = entries_.erase(it);
+			continue;
+		}
+		if (oldest == entries_.end() || it->second.expires_ < oldest->second.expires_)
+			oldest = it;
+		++it;
+	}
+	if (entries_.size() >= max_entries_ && oldest != entries_.end())
+		entries_.erase(oldest);
+}
+
+std::vector<std::shared_ptr<net::net_address>> net::resolver_cache::to_addresses(
+	const std::vector<std::vector<std::uint8_t>>& addresses)
+{
+	// every caller gets its own objects, they cache names lazily
+	std::vector<std::shared_ptr<net_address>> result;
+	for (std::size_t i = 0; i < addresses.size(); ++i)
+		result.push_back(net_address::of(addresses[i]));
+	return result;
+}
+
+std::uint64_t net::resolver_cache::now_millis(void)
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.resolver_cache.inl"
+#endif
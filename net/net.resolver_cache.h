@@ -0,0 +1,129 @@
+#ifndef __NET_RESOLVER_CACHE__
+#define __NET_RESOLVER_CACHE__
+
+#include "net.config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "net.net_address.h"
+
+namespace net
+{
+	/**
+	* Caches host name lookups for net_address. Successful lookups are kept
+	* for a fixed time to live, failed ones for a shorter negative time to
+	* live, and concurrent lookups of the same name share one query.
+	*/
+	class resolver_cache
+	{
+	public:
+		/**
+		* Resolves a host name, throwing unknown_host_exception if it has no
+		* addresses.
+		*/
+		typedef std::function<std::vector<std::shared_ptr<net_address>>(
+			const std::string&)> lookup_function;
+	private:
+		struct entry
+		{
+			std::vector<std::vector<std::uint8_t>> addresses_;
+			std::uint64_t expires_;
+			bool pending_;
+			bool failed_;
+		};
+		lookup_function lookup_;
+		int ttl_;
+		int negative_ttl_;
+		std::size_t max_entries_;
+		std::mutex mutex_;
+		std::condition_variable resolved_;
+		std::unordered_map<std::string, entry> entries_;
+		std::string local_host_name_;
+		std::uint64_t local_host_expires_;
+		std::atomic<std::uint64_t> hits_;
+		std::atomic<std::uint64_t> misses_;
+	public:
+		/**
+		* Creates a cache keeping successful lookups for ttl and failed ones
+		* for negative_ttl milliseconds, holding at most max_entries names.
+		* Misses are passed to net_address::query_host_by_name.
+		*/
+		resolver_cache(const int& ttl = 30000, const int& negative_ttl = 5000,
+			const std::size_t& max_entries = 4096);
+	public:
+		virtual ~resolver_cache(void);
+	public:
+		/**
+		* Returns the cache used by net_address. It is never destroyed.
+		*/
+		static resolver_cache& get_default(void);
+	public:
+		/**
+		* Returns the addresses of hostname from the cache, looking them up
+		* on a miss. Throws unknown_host_exception if the name did not
+		* resolve, which is remembered for the negative time to live.
+		*/
+		std::vector<std::shared_ptr<net_address>> resolve(const std::string& hostname);
+
+		/**
+		* Resolves several names, running up to parallelism lookups at a
+		* time. A name which did not resolve yields an empty list.
+		*/
+		std::vector<std::vector<std::shared_ptr<net_address>>> resolve_all(
+			const std::vector<std::string>& hostnames, const int& parallelism = 16);
+
+		/**
+		* Returns the name of the local host, kept for the time to live.
+		*/
+		std::string get_local_host_name(void);
+
+		/**
+		* Replaces the function which resolves the names missing in the cache.
+		*/
+		void set_lookup(const lookup_function& lookup);
+
+		/**
+		* Sets the times to live in milliseconds of successful and failed
+		* lookups made from now on.
+		*/
+		void set_ttl(const int& ttl, const int& negative_ttl);
+
+		/**
+		* Forgets a name, or every name if hostname is empty.
+		*/
+		void remove(const std::string& hostname = "");
+	public:
+		/**
+		* Returns the number of lookups answered from the cache.
+		*/
+		NET_INLINE std::uint64_t get_hit_count(void) const;
+
+		/**
+		* Returns the number of lookups passed to the resolver.
+		*/
+		NET_INLINE std::uint64_t get_miss_count(void) const;
+	private:
+		void trim(const std::uint64_t& now);
+		static std::vector<std::shared_ptr<net_address>> to_addresses(
+			const std::vector<std::vector<std::uint8_t>>& addresses);
+		static std::uint64_t now_millis(void);
+	private:
+		resolver_cache(const resolver_cache&);
+		resolver_cache& operator=(const resolver_cache&);
+		resolver_cache& operator=(const resolver_cache&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.resolver_cache.inl"
+#endif
+
+#endif
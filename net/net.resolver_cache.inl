@@ -0,0 +1,9 @@
+NET_INLINE std::uint64_t net::resolver_cache::get_hit_count(void) const
+{
+	return hits_.load(std::memory_order_relaxed);
+}
+
+NET_INLINE std::uint64_t net::resolver_cache::get_miss_count(void) const
+{
+	return misses_.load(std::memory_order_relaxed);
+}
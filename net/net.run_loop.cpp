@@ -0,0 +1,488 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX) && defined(NET_COROUTINES)
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <ios>
+
+#include "net.error.h"
+#include "net.exceptions.h"
+#include "net.run_loop.h"
+
+namespace
+{
+	void throw_failure(const char* call, const std::error_code& ec, const bool& io)
+	{
+		if (ec == std::errc::timed_out)
+			throw net::socket_timeout_exception(std::string(call) + " timed out");
+		std::string message = sio::errno_exception(call, ec.value()).what();
+		if (io)
+			throw std::ios_base::failure(message, ec);
+		throw net::socket_exception(message);
+	}
+}
+
+net::run_loop::operation::operation(run_loop& loop, const int& fd,
+	const std::uint32_t& events, const int& timeout)
+	: loop_(&loop)
+	, fd_(fd)
+	, events_(events)
+	, awaiting_(nullptr)
+	, ec_()
+	, timeout_(timeout)
+	, timer_(0)
+{
+}
+
+bool net::run_loop::operation::await_ready(void)
+{
+	// a failure to set the socket up is reported without waiting
+	return ec_ || perform();
+}
+
+void net::run_loop::operation::await_suspend(const std::coroutine_handle<>& awaiting)
+{
+	awaiting_ = awaiting;
+	loop_->wait(this);
+}
+
+net::run_loop::schedule_operation::schedule_operation(run_loop& loop)
+	: loop_(&loop)
+{
+}
+
+bool net::run_loop::schedule_operation::await_ready(void) const noexcept
+{
+	return false;
+}
+
+void net::run_loop::schedule_operation::await_suspend(
+	const std::coroutine_handle<>& awaiting)
+{
+	loop_->post(awaiting);
+}
+
+void net::run_loop::schedule_operation::await_resume(void) const noexcept
+{
+}
+
+net::run_loop::sleep_operation::sleep_operation(run_loop& loop, const int& delay)
+	: loop_(&loop)
+	, delay_(delay)
+{
+}
+
+bool net::run_loop::sleep_operation::await_ready(void) const noexcept
+{
+	return delay_ <= 0;
+}
+
+void net::run_loop::sleep_operation::await_suspend(
+	const std::coroutine_handle<>& awaiting)
+{
+	run_loop* loop = loop_;
+	std::coroutine_handle<> h = awaiting;
+	loop_->timers_.schedule(delay_, [loop, h](void) { loop->ready_.push_back(h); });
+}
+
+void net::run_loop::sleep_operation::await_resume(void) const noexcept
+{
+}
+
+net::run_loop::connect_operation::connect_operation(run_loop& loop,
+	const std::shared_ptr<net::socket>& sock, const endpoint& remote, const int& timeout)
+	: operation(loop, -1, EPOLLOUT, timeout)
+	, sock_(sock)
+	, remote_(remote)
+{
+}
+
+bool net::run_loop::connect_operation::await_ready(void)
+{
+	// the descriptor exists once the socket is bound
+	if (!sock_->is_bound()) {
+		sock_->bind(endpoint(ip_address::any(remote_.get_family()), 0), ec_);
+		if (ec_)
+			return true;
+	}
+	fd_ = sock_->get_impl()->get_native_socket();
+	if (!sock_->is_non_blocking()) {
+		sock_->set_non_blocking(true, ec_);
+		if (ec_)
+			return true;
+	}
+	sock_->connect(remote_, 0, ec_);
+	return ec_ != std::errc::operation_in_progress;
+}
+
+void net::run_loop::connect_operation::await_resume(void)
+{
+	if (ec_)
+		throw_failure("connect", ec_, false);
+}
+
+bool net::run_loop::connect_operation::perform(void)
+{
+	sock_->finish_connect(ec_);
+	return true;
+}
+
+net::run_loop::accept_operation::accept_operation(run_loop& loop,
+	const std::shared_ptr<net::server_socket>& server, const int& timeout)
+	: operation(loop, server->get_impl()->get_native_socket(), EPOLLIN, timeout)
+	, server_(server)
+	, accepted_(nullptr)
+{
+	if (!server_->is_non_blocking())
+		server_->set_non_blocking(true, ec_);
+}
+
+std::shared_ptr<net::socket> net::run_loop::accept_operation::await_resume(void)
+{
+	if (ec_)
+		throw_failure("accept", ec_, false);
+	return std::move(accepted_);
+}
+
+bool net::run_loop::accept_operation::perform(void)
+{
+	accepted_ = server_->try_accept(ec_);
+	return accepted_ != nullptr || ec_;
+}
+
+net::run_loop::read_operation::read_operation(run_loop& loop,
+	const std::shared_ptr<net::socket>& sock, std::uint8_t* buffer, const int& nbytes,
+	const int& timeout)
+	: operation(loop, sock->get_impl()->get_native_socket(), EPOLLIN | EPOLLRDHUP, timeout)
+	, sock_(sock)
+	, buffer_(buffer)
+	, nbytes_(nbytes)
+	, result_(0)
+{
+	if (!sock_->is_non_blocking())
+		sock_->set_non_blocking(true, ec_);
+}
+
+int net::run_loop::read_operation::await_resume(void)
+{
+	if (ec_)
+		throw_failure("recv", ec_, true);
+	return result_;
+}
+
+bool net::run_loop::read_operation::perform(void)
+{
+	result_ = sock_->read(buffer_, nbytes_, ec_);
+	return result_ != socket_impl::would_block;
+}
+
+net::run_loop::write_operation::write_operation(run_loop& loop,
+	const std::shared_ptr<net::socket>& sock, const std::uint8_t* buffer,
+	const int& nbytes, const int& timeout)
+	: operation(loop, sock->get_impl()->get_native_socket(), EPOLLOUT, timeout)
+	, sock_(sock)
+	, buffer_(buffer)
+	, nbytes_(nbytes)
+	, written_(0)
+{
+	if (!sock_->is_non_blocking())
+		sock_->set_non_blocking(true, ec_);
+}
+
+void net::run_loop::write_operation::await_resume(void)
+{
+	if (ec_)
+		throw_failure("send", ec_, true);
+}
+
+bool net::run_loop::write_operation::perform(void)
+{
+	do {
+		int written = sock_->write(buffer_ + written_, nbytes_ - written_, ec_);
+		if (ec_)
+			return true;
+		if (written == socket_impl::would_block)
+			return false;
+		written_ += written;
+	} while (written_ < nbytes_);
+	return true;
+}
+
+net::run_loop::run_loop(const int& max_events)
+	: epfd_(-1)
+	, wakefd_(-1)
+	, stopped_(false)
+	, waiters_()
+	, events_(max_events > 0 ? max_events : 256)
+	, ready_()
+	, mutex_()
+	, posted_()
+	, tasks_()
+	, failure_(nullptr)
+	, timers_()
+{
+	try {
+		if ((epfd_ = ::epoll_create1(EPOLL_CLOEXEC)) == -1)
+			throw sio::errno_exception("epoll_create1", sio::socket_errno(errno));
+		if ((wakefd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+			throw sio::errno_exception("eventfd", sio::socket_errno(errno));
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = wakefd_;
+		if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, wakefd_, &ev) == -1)
+			throw sio::errno_exception("epoll_ctl", sio::socket_errno(errno));
+	}
+	catch (const sio::errno_exception& e) {
+		if (wakefd_ != -1)
+			::close(wakefd_);
+		if (epfd_ != -1)
+			::close(epfd_);
+		throw socket_exception(e.what());
+	}
+}
+
+net::run_loop::~run_loop(void)
+{
+	// destroying a spawned frame destroys the tasks it awaits, down to the
+	// operation which suspended them
+	std::vector<void*> tasks(tasks_.begin(), tasks_.end());
+	tasks_.clear();
+	waiters_.clear();
+	for (std::size_t i = 0; i < tasks.size(); ++i)
+		std::coroutine_handle<>::from_address(tasks[i]).destroy();
+	::close(wakefd_);
+	::close(epfd_);
+}
+
+void net::run_loop::spawn(task<void>&& t)
+{
+	spawned s = drive(this, std::move(t));
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.insert(s.handle_.address());
+	}
+	post(s.handle_);
+}
+
+int net::run_loop::run_once(const int& timeout)
+{
+	bool posted = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		posted = !posted_.empty();
+	}
+	int delay = timers_.next_timeout();
+	if (posted)
+		delay = 0;
+	else if (delay < 0 || (timeout >= 0 && timeout < delay))
+		delay = timeout;
+	int count = ::epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), delay);
+	if (count == -1) {
+		if (errno != EINTR)
+			throw socket_exception(sio::errno_exception("epoll_wait",
+				sio::socket_errno(errno)).what());
+		count = 0;
+	}
+	for (int i = 0; i < count; ++i)
+		dispatch(events_[i].data.fd, events_[i].events);
+	// one pass over the wheel per wakeup fails the operations which are
+	// still pending when due
+	timers_.advance();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		ready_.insert(ready_.end(), posted_.begin(), posted_.end());
+		posted_.clear();
+	}
+
+	// resumed coroutines only queue others through post(), for the next round
+	int resumed = static_cast<int>(ready_.size());
+	for (int i = 0; i < resumed; ++i)
+		ready_[i].resume();
+	ready_.clear();
+	if (failure_ != nullptr) {
+		std::exception_ptr failure = failure_;
+		failure_ = nullptr;
+		std::rethrow_exception(failure);
+	}
+	return resumed;
+}
+
+void net::run_loop::run(void)
+{
+	while (!stopped_ && size() > 0)
+		run_once(-1);
+	stopped_ = false;
+}
+
+void net::run_loop::stop(void)
+{
+	stopped_ = true;
+	wake();
+}
+
+std::size_t net::run_loop::size(void)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return tasks_.size();
+}
+
+net::run_loop::spawned net::run_loop::drive(run_loop* loop, task<void> t)
+{
+	try {
+		co_await std::move(t);
+	}
+	catch (...) {
+		if (loop->failure_ == nullptr)
+			loop->failure_ = std::current_exception();
+	}
+}
+
+void net::run_loop::post(const std::coroutine_handle<>& h)
+{
+	bool idle = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		idle = posted_.empty();
+		posted_.push_back(h);
+	}
+	if (idle)
+		wake();
+}
+
+void net::run_loop::retire(const std::coroutine_handle<>& h) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.erase(h.address());
+	}
+	h.destroy();
+}
+
+void net::run_loop::wait(operation* op)
+{
+	std::unordered_map<int, waiters>::iterator it = waiters_.find(op->fd_);
+	if (it == waiters_.end()) {
+		waiters fresh = { nullptr, nullptr };
+		it = waiters_.insert(std::make_pair(op->fd_, fresh)).first;
+	}
+	waiters& w = it->second;
+	operation*& slot = (op->events_ & EPOLLOUT) ? w.writer_ : w.reader_;
+	if (slot != nullptr)
+		throw socket_exception("Operation already pending");
+	slot = op;
+	int error = arm(op->fd_, w);
+	if (error != 0) {
+		slot = nullptr;
+		release(it);
+		throw socket_exception(sio::errno_exception("epoll_ctl",
+			sio::socket_errno(error)).what());
+	}
+	if (op->timeout_ > 0) {
+		run_loop* loop = this;
+		op->timer_ = timers_.schedule(op->timeout_, [loop, op](void) { loop->expire(op); });
+	}
+}
+
+void net::run_loop::expire(operation* op)
+{
+	// the descriptor stays armed; an event for nobody is dropped
+	op->timer_ = 0;
+	std::unordered_map<int, waiters>::iterator it = waiters_.find(op->fd_);
+	if (it != waiters_.end()) {
+		if (it->second.reader_ == op)
+			it->second.reader_ = nullptr;
+		if (it->second.writer_ == op)
+			it->second.writer_ = nullptr;
+		release(it);
+	}
+	op->ec_ = make_socket_error(ETIMEDOUT);
+	ready_.push_back(op->awaiting_);
+}
+
+int net::run_loop::arm(const int& fd, waiters& w)
+{
+	struct epoll_event ev = {};
+	ev.events = EPOLLONESHOT;
+	if (w.reader_ != nullptr)
+		ev.events |= w.reader_->events_;
+	if (w.writer_ != nullptr)
+		ev.events |= w.writer_->events_;
+	ev.data.fd = fd;
+	// a descriptor waited for before stays in the epoll set, disarmed,
+	// until it is closed; a new one, or a number reused since, is added
+	if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == -1) {
+		if (errno != ENOENT)
+			return errno;
+		if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1)
+			return errno;
+	}
+	return 0;
+}
+
+void net::run_loop::dispatch(const int& fd, const std::uint32_t& events)
+{
+	if (fd == wakefd_) {
+		std::uint64_t count;
+		ssize_t rc = ::read(wakefd_, &count, sizeof(count));
+		(void) rc;
+		return;
+	}
+	std::unordered_map<int, waiters>::iterator it = waiters_.find(fd);
+	if (it == waiters_.end())
+		return;
+	waiters& w = it->second;
+	// errors and hangups complete either side, which then reports them
+	const std::uint32_t failed = EPOLLERR | EPOLLHUP;
+	if (w.reader_ != nullptr && (events & (w.reader_->events_ | failed))
+		&& w.reader_->perform()) {
+		timers_.cancel(w.reader_->timer_);
+		ready_.push_back(w.reader_->awaiting_);
+		w.reader_ = nullptr;
+	}
+	if (w.writer_ != nullptr && (events & (w.writer_->events_ | failed))
+		&& w.writer_->perform()) {
+		timers_.cancel(w.writer_->timer_);
+		ready_.push_back(w.writer_->awaiting_);
+		w.writer_ = nullptr;
+	}
+	if (w.reader_ == nullptr && w.writer_ == nullptr) {
+		release(it);
+		return;
+	}
+	int error = arm(fd, w);
+	if (error == 0)
+		return;
+	// the descriptor cannot be waited for any longer, fail what waits
+	operation* ops[2] = { w.reader_, w.writer_ };
+	for (int i = 0; i < 2; ++i) {
+		if (ops[i] != nullptr) {
+			timers_.cancel(ops[i]->timer_);
+			ops[i]->ec_ = make_socket_error(error);
+			ready_.push_back(ops[i]->awaiting_);
+		}
+	}
+	waiters_.erase(it);
+}
+
+void net::run_loop::release(const std::unordered_map<int, waiters>::iterator& it)
+{
+	// the loop does not learn when a descriptor is closed, so it forgets
+	// one as soon as nothing waits for it
+	if (it->second.reader_ == nullptr && it->second.writer_ == nullptr)
+		waiters_.erase(it);
+}
+
+void net::run_loop::wake(void)
+{
+	std::uint64_t one = 1;
+	ssize_t rc = ::write(wakefd_, &one, sizeof(one));
+	(void) rc;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.run_loop.inl"
+#endif
+
+#endif
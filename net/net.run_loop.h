@@ -0,0 +1,350 @@
+#ifndef __NET_RUN_LOOP__
+#define __NET_RUN_LOOP__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX) && defined(NET_COROUTINES)
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "net.endpoint.h"
+#include "net.socket.h"
+#include "net.server_socket.h"
+#include "net.task.h"
+#include "net.timer_wheel.h"
+
+namespace net
+{
+	/**
+	* Runs coroutines on one thread and resumes them when the sockets they
+	* wait for are ready. The operations below try the system call first
+	* and only suspend the awaiting coroutine if it would block; the loop
+	* then polls the native handle with epoll and retries the call when
+	* it is ready, so thousands of sessions written as sequential code
+	* share the thread without callbacks. A thread per loop, each with its
+	* own listening socket of a SO_REUSEPORT group, scales to a handful of
+	* cores.
+	*
+	* The operations switch their socket to non-blocking mode. Failures
+	* throw socket_exception, or std::ios_base::failure for reads and
+	* writes, as the throwing socket methods do. At most one read or
+	* accept and one write or connect may be pending on a socket at a
+	* time, and a socket must not be closed while one is. Sockets of the
+	* io_uring implementation complete their operations on the ring
+	* instead and block the loop.
+	*
+	* Each operation takes an optional timeout in milliseconds, kept on
+	* the timer wheel of the loop, which a run_once() checks once per
+	* wakeup; an operation still pending when it is due fails with
+	* socket_timeout_exception. A socket whose connect timed out is left
+	* connecting and should be closed.
+	*/
+	class run_loop
+	{
+	public:
+		/**
+		* An operation which suspends the awaiting coroutine until its
+		* socket is ready. perform() makes the system call and returns false
+		* if it would block.
+		*/
+		class operation
+		{
+			friend class run_loop;
+		protected:
+			run_loop* loop_;
+			int fd_;
+			std::uint32_t events_;
+			std::coroutine_handle<> awaiting_;
+			std::error_code ec_;
+			int timeout_;
+			timer_wheel::timer_id timer_;
+		protected:
+			operation(run_loop& loop, const int& fd, const std::uint32_t& events,
+				const int& timeout);
+		public:
+			bool await_ready(void);
+			void await_suspend(const std::coroutine_handle<>& awaiting);
+		protected:
+			virtual bool perform(void) = 0;
+		};
+
+		class schedule_operation
+		{
+			run_loop* loop_;
+		public:
+			schedule_operation(run_loop& loop);
+		public:
+			bool await_ready(void) const noexcept;
+			void await_suspend(const std::coroutine_handle<>& awaiting);
+			void await_resume(void) const noexcept;
+		};
+
+		class sleep_operation
+		{
+			run_loop* loop_;
+			int delay_;
+		public:
+			sleep_operation(run_loop& loop, const int& delay);
+		public:
+			bool await_ready(void) const noexcept;
+			void await_suspend(const std::coroutine_handle<>& awaiting);
+			void await_resume(void) const noexcept;
+		};
+
+		class connect_operation : public operation
+		{
+			std::shared_ptr<socket> sock_;
+			endpoint remote_;
+		public:
+			connect_operation(run_loop& loop, const std::shared_ptr<socket>& sock,
+				const endpoint& remote, const int& timeout);
+		public:
+			bool await_ready(void);
+			void await_resume(void);
+		protected:
+			virtual bool perform(void);
+		};
+
+		class accept_operation : public operation
+		{
+			std::shared_ptr<server_socket> server_;
+			std::shared_ptr<socket> accepted_;
+		public:
+			accept_operation(run_loop& loop, const std::shared_ptr<server_socket>& server,
+				const int& timeout);
+		public:
+			std::shared_ptr<socket> await_resume(void);
+		protected:
+			virtual bool perform(void);
+		};
+
+		class read_operation : public operation
+		{
+			std::shared_ptr<socket> sock_;
+			std::uint8_t* buffer_;
+			int nbytes_;
+			int result_;
+		public:
+			read_operation(run_loop& loop, const std::shared_ptr<socket>& sock,
+				std::uint8_t* buffer, const int& nbytes, const int& timeout);
+		public:
+			int await_resume(void);
+		protected:
+			virtual bool perform(void);
+		};
+
+		class write_operation : public operation
+		{
+			std::shared_ptr<socket> sock_;
+			const std::uint8_t* buffer_;
+			int nbytes_;
+			int written_;
+		public:
+			write_operation(run_loop& loop, const std::shared_ptr<socket>& sock,
+				const std::uint8_t* buffer, const int& nbytes, const int& timeout);
+		public:
+			void await_resume(void);
+		protected:
+			virtual bool perform(void);
+		};
+	private:
+		struct spawned
+		{
+			struct promise_type
+			{
+				run_loop* loop_;
+
+				promise_type(run_loop* loop, task<void>&) noexcept
+					: loop_(loop)
+				{
+				}
+
+				spawned get_return_object(void) noexcept
+				{
+					spawned s;
+					s.handle_ = std::coroutine_handle<promise_type>::from_promise(*this);
+					return s;
+				}
+
+				std::suspend_always initial_suspend(void) const noexcept
+				{
+					return std::suspend_always();
+				}
+
+				struct final_awaiter
+				{
+					bool await_ready(void) const noexcept
+					{
+						return false;
+					}
+
+					void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+					{
+						h.promise().loop_->retire(h);
+					}
+
+					void await_resume(void) const noexcept
+					{
+					}
+				};
+
+				final_awaiter final_suspend(void) const noexcept
+				{
+					return final_awaiter();
+				}
+
+				void return_void(void) noexcept
+				{
+				}
+
+				void unhandled_exception(void) noexcept
+				{
+					std::terminate();	// drive() catches everything
+				}
+			};
+			std::coroutine_handle<promise_type> handle_;
+		};
+
+		struct waiters
+		{
+			operation* reader_;
+			operation* writer_;
+		};
+		int epfd_;
+		int wakefd_;
+		std::atomic<bool> stopped_;
+		std::unordered_map<int, waiters> waiters_;
+		std::vector<struct epoll_event> events_;
+		std::vector<std::coroutine_handle<>> ready_;
+		std::mutex mutex_;
+		std::vector<std::coroutine_handle<>> posted_;
+		std::unordered_set<void*> tasks_;
+		std::exception_ptr failure_;
+		timer_wheel timers_;
+	public:
+		/**
+		* Constructs a loop polling at most max_events descriptors per
+		* wakeup.
+		*/
+		run_loop(const int& max_events = 256);
+	public:
+		/**
+		* Destroys the tasks which have not finished.
+		*/
+		virtual ~run_loop(void);
+	public:
+		/**
+		* Starts t on the loop thread; nothing awaits its result. An
+		* exception escaping t is rethrown from run_once() on the loop
+		* thread. May be called from any thread.
+		*/
+		void spawn(task<void>&& t);
+
+		/**
+		* Returns an awaitable which moves the awaiting coroutine to the
+		* loop thread, resuming it from run_once(). May be awaited on any
+		* thread.
+		*/
+		NET_INLINE schedule_operation schedule(void);
+
+		/**
+		* Returns an awaitable which resumes the awaiting coroutine on the
+		* loop thread once delay milliseconds have passed.
+		*/
+		NET_INLINE sleep_operation sleep_for(const int& delay);
+
+		/**
+		* Connects sock to remote, binding it to the wildcard address of
+		* the family of remote if it is unbound. A positive timeout limits
+		* the wait in milliseconds.
+		*/
+		NET_INLINE connect_operation async_connect(const std::shared_ptr<socket>& sock,
+			const endpoint& remote, const int& timeout = 0);
+
+		/**
+		* Accepts a connection on the bound server. The accepted socket is
+		* non-blocking.
+		*/
+		NET_INLINE accept_operation async_accept(const std::shared_ptr<server_socket>& server,
+			const int& timeout = 0);
+
+		/**
+		* Reads at most nbytes into buffer as soon as some are available.
+		* Returns the number of bytes read or socket_impl::end_of_stream.
+		* A timeout reading a session reaps it once it has been idle that
+		* long.
+		*/
+		NET_INLINE read_operation async_read_some(const std::shared_ptr<socket>& sock,
+			std::uint8_t* buffer, const int& nbytes, const int& timeout = 0);
+
+		/**
+		* Writes all nbytes of buffer, suspending whenever the send buffer
+		* is full. The timeout covers the whole write.
+		*/
+		NET_INLINE write_operation async_write_all(const std::shared_ptr<socket>& sock,
+			const std::uint8_t* buffer, const int& nbytes, const int& timeout = 0);
+	public:
+		/**
+		* Waits up to timeout milliseconds for sockets to be ready and
+		* resumes the coroutines waiting for them, and those moved to the
+		* loop. A negative timeout waits indefinitely. Returns the number
+		* of coroutines resumed.
+		*/
+		int run_once(const int& timeout = -1);
+
+		/**
+		* Resumes coroutines until stop() is called or every spawned task
+		* has finished.
+		*/
+		void run(void);
+
+		/**
+		* Makes run() return after the current iteration. May be called
+		* from any thread.
+		*/
+		void stop(void);
+	public:
+		/**
+		* Returns the number of spawned tasks which have not finished.
+		*/
+		std::size_t size(void);
+
+		/**
+		* Returns the timers of the loop, which run on the loop thread from
+		* run_once().
+		*/
+		NET_INLINE timer_wheel& get_timers(void);
+	private:
+		static spawned drive(run_loop* loop, task<void> t);
+		void post(const std::coroutine_handle<>& h);
+		void retire(const std::coroutine_handle<>& h) noexcept;
+		void wait(operation* op);
+		void expire(operation* op);
+		int arm(const int& fd, waiters& w);
+		void release(const std::unordered_map<int, waiters>::iterator& it);
+		void dispatch(const int& fd, const std::uint32_t& events);
+		void wake(void);
+	private:
+		run_loop(const run_loop&);
+		run_loop& operator=(const run_loop&);
+		run_loop& operator=(const run_loop&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.run_loop.inl"
+#endif
+
+#endif
+
+#endif
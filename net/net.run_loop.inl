@@ -0,0 +1,40 @@
+NET_INLINE net::run_loop::schedule_operation net::run_loop::schedule(void)
+{
+	return schedule_operation(*this);
+}
+
+NET_INLINE net::run_loop::sleep_operation net::run_loop::sleep_for(const int& delay)
+{
+	return sleep_operation(*this, delay);
+}
+
+NET_INLINE net::run_loop::connect_operation net::run_loop::async_connect(
+	const std::shared_ptr<net::socket>& sock, const endpoint& remote, const int& timeout)
+{
+	return connect_operation(*this, sock, remote, timeout);
+}
+
+NET_INLINE net::run_loop::accept_operation net::run_loop::async_accept(
+	const std::shared_ptr<net::server_socket>& server, const int& timeout)
+{
+	return accept_operation(*this, server, timeout);
+}
+
+NET_INLINE net::run_loop::read_operation net::run_loop::async_read_some(
+	const std::shared_ptr<net::socket>& sock, std::uint8_t* buffer, const int& nbytes,
+	const int& timeout)
+{
+	return read_operation(*this, sock, buffer, nbytes, timeout);
+}
+
+NET_INLINE net::run_loop::write_operation net::run_loop::async_write_all(
+	const std::shared_ptr<net::socket>& sock, const std::uint8_t* buffer,
+	const int& nbytes, const int& timeout)
+{
+	return write_operation(*this, sock, buffer, nbytes, timeout);
+}
+
+NET_INLINE net::timer_wheel& net::run_loop::get_timers(void)
+{
+	return timers_;
+}
@@ -1,13 +1,17 @@
+#include "net.error.h"
 #include "net.exceptions.h"
 #include "net.net4_address.h"
 #include "net.net6_address.h"
 #include "net.server_socket.h"
 #include "net.default_server_socket_impl.h"
 
+#include <new>
+
 std::shared_ptr<net::socket_impl_factory> net::server_socket::factory_;
 
 net::server_socket::server_socket(const bool& prefer_ipv6)
 	: impl_(nullptr)
+	, pending_(nullptr)
 	, is_bound_(false)
 	, is_closed_(false)
 {
@@ -22,13 +26,9 @@ net::server_socket::server_socket(const bool& prefer_ipv6)
 	try {
 		impl_->create(addr->get_family());
 	}
-	catch (const socket_timeout_exception& e) {
-		impl_->close();
-		throw e;
-	}
-	catch (const socket_exception& e) {
+	catch (const socket_exception&) {
 		impl_->close();
-		throw e;
+		throw;
 	}
 }
 
@@ -48,6 +48,7 @@ net::server_socket::server_socket(const std::uint16_t& port,
 net::server_socket::server_socket(const std::uint16_t& port, const int& backlog,
 		const std::shared_ptr<net::net_address>& localaddr)
 	: impl_(nullptr)
+	, pending_(nullptr)
 	, is_bound_(false)
 	, is_closed_(false)
 {
@@ -65,13 +66,9 @@ net::server_socket::server_socket(const std::uint16_t& port, const int& backlog,
 		is_bound_ = true;
 		impl_->listen(backlog > 0 ? backlog : 50);
 	}
-	catch (const socket_timeout_exception& e) {
-		impl_->close();
-		throw e;
-	}
-	catch (const socket_exception& e) {
+	catch (const socket_exception&) {
 		impl_->close();
-		throw e;
+		throw;
 	}
 }
 
@@ -88,17 +85,52 @@ std::shared_ptr<net::socket> net::server_socket::accept(void)
 	try {
 		implement_accept(sock);
 	}
-	catch (const socket_timeout_exception& e) {
+	catch (const socket_exception&) {
 		sock->close();
-		throw e;
-	}
-	catch (const socket_exception& e) {
-		sock->close();
-		throw e;
+		throw;
 	}
 	return sock;
 }
 
+std::shared_ptr<net::socket> net::server_socket::try_accept(void)
+{
+	check_open();
+	if (!is_bound())
+		throw socket_exception("Socket is not bound");
+	// the spare socket is kept across would-block results so that polling
+	// an empty backlog does not allocate
+	if (pending_ == nullptr)
+		pending_ = std::make_shared<net::socket>();
+	if (impl_->try_accept(pending_->get_impl()) == socket_impl::would_block)
+		return nullptr;
+	pending_->accepted();
+	std::shared_ptr<net::socket> sock;
+	sock.swap(pending_);
+	return sock;
+}
+
+int net::server_socket::accept_many(const int& max,
+	std::vector<std::shared_ptr<net::socket>>& out)
+{
+	check_open();
+	if (!is_bound())
+		throw socket_exception("Socket is not bound");
+	if (!is_non_blocking())
+		throw socket_exception("Socket is not in non-blocking mode");
+	int count = 0;
+	while (count < max) {
+		if (pending_ == nullptr)
+			pending_ = std::make_shared<net::socket>();
+		if (impl_->try_accept(pending_->get_impl()) == socket_impl::would_block)
+			break;
+		pending_->accepted();
+		out.push_back(std::move(pending_));
+		pending_ = nullptr;
+		++count;
+	}
+	return count;
+}
+
 void net::server_socket::bind(const net::socket_address& localaddr)
 {
 	bind(localaddr, 50);
@@ -121,9 +153,28 @@ void net::server_socket::bind(const net::socket_address& localaddr,
 		is_bound_ = true;
 		impl_->listen(backlog > 0 ? backlog : 50);
 	}
-	catch (const socket_exception& e) {
+	catch (const socket_exception&) {
+		impl_->close();
+		throw;
+	}
+}
+
+void net::server_socket::bind(const net::endpoint& localaddr, const int& backlog)
+{
+	check_open();
+	if (is_bound())
+		throw socket_exception("Socket is already bound");
+	if (localaddr.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+
+	try {
+		impl_->bind(localaddr);
+		is_bound_ = true;
+		impl_->listen(backlog > 0 ? backlog : 50);
+	}
+	catch (const socket_exception&) {
 		impl_->close();
-		throw e;
+		throw;
 	}
 }
 
@@ -145,6 +196,27 @@ void net::server_socket::set_reuse_address(const bool& reuse)
 	impl_->set_option_bool(SO_REUSEADDR, reuse);
 }
 
+bool net::server_socket::get_reuse_port(void)
+{
+	check_open();
+#if defined(SO_REUSEPORT)
+	return impl_->get_option_bool(SO_REUSEPORT);
+#else
+	return false;
+#endif
+}
+
+void net::server_socket::set_reuse_port(const bool& reuse)
+{
+	check_open();
+#if defined(SO_REUSEPORT)
+	impl_->set_option_bool(SO_REUSEPORT, reuse);
+#else
+	if (reuse)
+		throw socket_exception("SO_REUSEPORT is not supported");
+#endif
+}
+
 int net::server_socket::get_receive_buffer_size(void)
 {
 	check_open();
@@ -173,6 +245,208 @@ void net::server_socket::set_receive_timeout(const int& timeout)
 	impl_->set_option_int(SO_RCVTIMEO, timeout);
 }
 
+bool net::server_socket::is_non_blocking(void) const
+{
+	return impl_->is_non_blocking();
+}
+
+void net::server_socket::set_non_blocking(const bool& on)
+{
+	check_open();
+	impl_->set_non_blocking(on);
+}
+
+void net::server_socket::set_accept_filter(const socket_impl::accept_filter& filter)
+{
+	check_open();
+	impl_->set_accept_filter(filter);
+}
+
+void net::server_socket::attach_filter(const socket_filter& filter)
+{
+	check_open();
+	impl_->attach_filter(filter, false);
+}
+
+void net::server_socket::detach_filter(void)
+{
+	check_open();
+	impl_->detach_filter(false);
+}
+
+void net::server_socket::attach_reuseport_filter(const socket_filter& filter)
+{
+	check_open();
+	impl_->attach_filter(filter, true);
+}
+
+void net::server_socket::detach_reuseport_filter(void)
+{
+	check_open();
+	impl_->detach_filter(true);
+}
+
+std::shared_ptr<net::socket> net::server_socket::accept(std::error_code& ec) noexcept
+{
+	if (!check_open(ec) || !reserve_pending(ec))
+		return nullptr;
+	impl_->accept(pending_->get_impl(), ec);
+	if (ec)
+		return nullptr;
+	pending_->accepted();
+	std::shared_ptr<net::socket> sock;
+	sock.swap(pending_);
+	return sock;
+}
+
+std::shared_ptr<net::socket> net::server_socket::try_accept(std::error_code& ec) noexcept
+{
+	if (!check_open(ec) || !reserve_pending(ec))
+		return nullptr;
+	if (impl_->try_accept(pending_->get_impl(), ec) != 0)
+		return nullptr;
+	pending_->accepted();
+	std::shared_ptr<net::socket> sock;
+	sock.swap(pending_);
+	return sock;
+}
+
+int net::server_socket::accept_many(const int& max,
+	std::vector<std::shared_ptr<net::socket>>& out, std::error_code& ec) noexcept
+{
+	if (!check_open(ec))
+		return 0;
+	if (!is_non_blocking()) {
+		ec = make_socket_error(EINVAL);
+		return 0;
+	}
+	int count = 0;
+	while (count < max) {
+		std::shared_ptr<net::socket> sock = try_accept(ec);
+		if (sock == nullptr)
+			break;
+		try {
+			out.push_back(std::move(sock));
+		}
+		catch (const std::bad_alloc&) {
+			sock->close(ec);
+			ec = make_socket_error(ENOMEM);
+			break;
+		}
+		++count;
+	}
+	// connections handed out before a failure are kept by the caller
+	if (count > 0)
+		ec.clear();
+	return count;
+}
+
+void net::server_socket::bind(const net::endpoint& localaddr, const int& backlog,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return;
+	}
+	if (is_bound() || localaddr.is_unspecified()) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+
+	impl_->bind(localaddr, ec);
+	if (!ec) {
+		is_bound_ = true;
+		impl_->listen(backlog > 0 ? backlog : 50, ec);
+	}
+	if (ec) {
+		std::error_code ignored;
+		impl_->close(ignored);
+	}
+}
+
+void net::server_socket::close(std::error_code& ec) noexcept
+{
+	is_closed_ = true;
+	impl_->close(ec);
+}
+
+bool net::server_socket::get_reuse_address(std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return false;
+	return impl_->get_option_bool(SOL_SOCKET, SO_REUSEADDR, ec);
+}
+
+void net::server_socket::set_reuse_address(const bool& reuse, std::error_code& ec) noexcept
+{
+	if (check_open(ec, false))
+		impl_->set_option_bool(SOL_SOCKET, SO_REUSEADDR, reuse, ec);
+}
+
+bool net::server_socket::get_reuse_port(std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return false;
+#if defined(SO_REUSEPORT)
+	return impl_->get_option_bool(SOL_SOCKET, SO_REUSEPORT, ec);
+#else
+	return false;
+#endif
+}
+
+void net::server_socket::set_reuse_port(const bool& reuse, std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return;
+#if defined(SO_REUSEPORT)
+	impl_->set_option_bool(SOL_SOCKET, SO_REUSEPORT, reuse, ec);
+#else
+	if (reuse)
+		ec = make_socket_error(EOPNOTSUPP);
+#endif
+}
+
+int net::server_socket::get_receive_buffer_size(std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return 0;
+	return impl_->get_option_int(SOL_SOCKET, SO_RCVBUF, ec);
+}
+
+void net::server_socket::set_receive_buffer_size(const int& size, std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return;
+	if (size < 1)
+		ec = make_socket_error(EINVAL);
+	else
+		impl_->set_option_int(SOL_SOCKET, SO_RCVBUF, size, ec);
+}
+
+int net::server_socket::get_receive_timeout(std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return 0;
+	return impl_->get_option_int(SOL_SOCKET, SO_RCVTIMEO, ec);
+}
+
+void net::server_socket::set_receive_timeout(const int& timeout, std::error_code& ec) noexcept
+{
+	if (!check_open(ec, false))
+		return;
+	if (timeout < 0)
+		ec = make_socket_error(EINVAL);
+	else
+		impl_->set_option_int(SOL_SOCKET, SO_RCVTIMEO, timeout, ec);
+}
+
+void net::server_socket::set_non_blocking(const bool& on, std::error_code& ec) noexcept
+{
+	if (check_open(ec, false))
+		impl_->set_non_blocking(on, ec);
+}
+
 std::shared_ptr<net::net_address> net::server_socket::get_local_address(void) const
 {
 	if (!is_bound())
@@ -192,6 +466,18 @@ net::socket_address net::server_socket::get_local_socket_address(void) const
 	return socket_address(get_local_address(), get_local_port());
 }
 
+net::endpoint net::server_socket::get_local_endpoint(void) const
+{
+	if (!is_bound())
+		return endpoint();
+	if (!impl_->get_local_endpoint().is_unspecified())
+		return impl_->get_local_endpoint();
+	std::shared_ptr<net_address> addr = impl_->get_local_address();
+	if (addr == nullptr)
+		return endpoint();
+	return endpoint(ip_address(*addr), impl_->get_local_port());
+}
+
 void net::server_socket::set_socket_impl_factory(
 	const std::shared_ptr<net::socket_impl_factory>& fac)
 {
@@ -216,6 +502,31 @@ void net::server_socket::implement_accept(const std::shared_ptr<net::socket>& so
 	sock->accepted();
 }
 
+bool net::server_socket::check_open(std::error_code& ec, const bool& bound) const noexcept
+{
+	ec.clear();
+	if (is_closed())
+		ec = make_socket_error(EBADF);
+	else if (bound && !is_bound())
+		ec = make_socket_error(EINVAL);
+	return !ec;
+}
+
+bool net::server_socket::reserve_pending(std::error_code& ec) noexcept
+{
+	// as in try_accept(), the spare socket outlives failed attempts
+	if (pending_ != nullptr)
+		return true;
+	try {
+		pending_ = std::make_shared<net::socket>();
+	}
+	catch (const std::bad_alloc&) {
+		ec = make_socket_error(ENOMEM);
+		return false;
+	}
+	return true;
+}
+
 #if !defined(__NET_INLINE__)
 #include "net.server_socket.inl"
 #endif
\ No newline at end of file
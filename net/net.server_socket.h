@@ -2,9 +2,13 @@
 #define __NET_SERVER_SOCKET__
 
 #include <memory>
+#include <system_error>
+#include <vector>
 
+#include "net.endpoint.h"
 #include "net.net_address.h"
 #include "net.socket_address.h"
+#include "net.socket_filter.h"
 #include "net.socket.h"
 #include "net.socket_impl.h"
 #include "net.socket_impl_factory.h"
@@ -14,6 +18,7 @@ namespace net
 	class server_socket
 	{
 		std::shared_ptr<socket_impl> impl_;
+		std::shared_ptr<net::socket> pending_;
 		volatile bool is_bound_;
 		volatile bool is_closed_;
 	private:
@@ -65,6 +70,23 @@ namespace net
 		*/
 		virtual std::shared_ptr<net::socket> accept(void);
 
+		/**
+		* Accepts a pending connection without waiting and without raising
+		* an exception when the backlog is empty, in which case null is
+		* returned. Sockets accepted while the server socket is non-blocking
+		* are non-blocking too.
+		*/
+		virtual std::shared_ptr<net::socket> try_accept(void);
+
+		/**
+		* Drains up to max pending connections in a single call and appends
+		* them to out. The server socket must be non-blocking; the accepted
+		* sockets are created non-blocking and close-on-exec. Returns the
+		* number of sockets appended, zero if the backlog was empty.
+		*/
+		virtual int accept_many(const int& max,
+			std::vector<std::shared_ptr<net::socket>>& out);
+
 		/**
 		* Binds this server socket to the given local socket address with a maximum
 		* backlog of 50 unaccepted connections. If the localaddr is set to null
@@ -80,6 +102,13 @@ namespace net
 		*/
 		virtual void bind(const socket_address& localaddr, const int& backlog);
 
+		/**
+		* Binds this server socket to the given local endpoint and listens
+		* with the given backlog. Port zero picks any free port. The
+		* endpoint must be of the family the socket was created for.
+		*/
+		virtual void bind(const endpoint& localaddr, const int& backlog = 50);
+
 		/**
 		* Closes this server socket and its implementation. Any attempt to connect
 		* to this socket thereafter will fail.
@@ -96,6 +125,18 @@ namespace net
 		*/
 		virtual void set_reuse_address(const bool& reuse);
 
+		/**
+		* Gets the value of the socket option SO_REUSEPORT.
+		*/
+		virtual bool get_reuse_port(void);
+
+		/**
+		* Sets the value for the socket option SO_REUSEPORT. When set before
+		* binding, several server sockets may listen on the same address and
+		* the kernel balances incoming connections between them.
+		*/
+		virtual void set_reuse_port(const bool& reuse);
+
 		/**
 		* Gets the value of the socket option SO_RCVBUF.
 		*/
@@ -119,6 +160,80 @@ namespace net
 		* must be set before the blocking method was called.
 		*/
 		virtual void set_receive_timeout(const int& timeout);
+
+		/**
+		* Tests if the server socket is in non-blocking mode.
+		*/
+		virtual bool is_non_blocking(void) const;
+
+		/**
+		* Enable/disable non-blocking mode for this server socket.
+		*/
+		virtual void set_non_blocking(const bool& on);
+
+		/**
+		* Sets a filter every accepted connection passes through right after
+		* the accept system call, before a socket is handed out. Rejected
+		* connections are closed and accepting goes on with the next one;
+		* the tag of admitted ones is available from socket::get_tag(). An
+		* empty filter admits all connections, and one which throws rejects
+		* the connection. The filter runs on the accepting thread and must
+		* not block.
+		*/
+		virtual void set_accept_filter(const socket_impl::accept_filter& filter);
+
+		/**
+		* Attaches filter for the kernel to run on incoming packets, so
+		* connection requests it drops never reach the accept queue. Unlike
+		* set_accept_filter nothing is accepted and closed again. Replaces a
+		* filter attached before. Throws socket_exception where the
+		* platform does not support socket filters.
+		*/
+		virtual void attach_filter(const socket_filter& filter);
+
+		/**
+		* Detaches the filter attached with attach_filter.
+		*/
+		virtual void detach_filter(void);
+
+		/**
+		* Attaches filter to the SO_REUSEPORT group of this bound socket: its
+		* verdict for a connection request is the index, in binding order, of
+		* the socket which receives it. Verdicts past the last socket leave
+		* the choice to the kernel's hash. Applies to every socket of the
+		* group.
+		*/
+		virtual void attach_reuseport_filter(const socket_filter& filter);
+
+		/**
+		* Detaches the filter of the SO_REUSEPORT group.
+		*/
+		virtual void detach_reuseport_filter(void);
+	public:
+		/**
+		* The overloads below never throw: a failure is stored in ec, which
+		* is cleared on success, as the error_code overloads of socket do.
+		* The accepting ones return null on failure and, like try_accept(),
+		* when the backlog is empty; a blocking accept which runs into the
+		* receive timeout fails with timed_out. Binding fails with
+		* invalid_argument if the socket is already bound.
+		*/
+		virtual std::shared_ptr<net::socket> accept(std::error_code& ec) noexcept;
+		virtual std::shared_ptr<net::socket> try_accept(std::error_code& ec) noexcept;
+		virtual int accept_many(const int& max,
+			std::vector<std::shared_ptr<net::socket>>& out, std::error_code& ec) noexcept;
+		virtual void bind(const endpoint& localaddr, const int& backlog,
+			std::error_code& ec) noexcept;
+		virtual void close(std::error_code& ec) noexcept;
+		virtual bool get_reuse_address(std::error_code& ec) noexcept;
+		virtual void set_reuse_address(const bool& reuse, std::error_code& ec) noexcept;
+		virtual bool get_reuse_port(std::error_code& ec) noexcept;
+		virtual void set_reuse_port(const bool& reuse, std::error_code& ec) noexcept;
+		virtual int get_receive_buffer_size(std::error_code& ec) noexcept;
+		virtual void set_receive_buffer_size(const int& size, std::error_code& ec) noexcept;
+		virtual int get_receive_timeout(std::error_code& ec) noexcept;
+		virtual void set_receive_timeout(const int& timeout, std::error_code& ec) noexcept;
+		virtual void set_non_blocking(const bool& on, std::error_code& ec) noexcept;
 	public:
 		/**
 		* Gets the local IP address of this server socket or null if the
@@ -137,6 +252,12 @@ namespace net
 		* the socket is unbound. This is useful on multihomed hosts.
 		*/
 		virtual socket_address get_local_socket_address(void) const;
+
+		/**
+		* Gets the local endpoint of this server socket or an unspecified
+		* endpoint if the socket is unbound.
+		*/
+		virtual endpoint get_local_endpoint(void) const;
 	public:
 		/**
 		* Returns whether this server socket is bound to a local address
@@ -159,6 +280,8 @@ namespace net
 		NET_INLINE void set_impl(const std::shared_ptr<socket_impl>& impl);
 	private:
 		NET_INLINE void check_open(void) const;
+		bool check_open(std::error_code& ec, const bool& bound = true) const noexcept;
+		bool reserve_pending(std::error_code& ec) noexcept;
 	private:
 		server_socket(const server_socket&);
 		server_socket& operator=(const server_socket&);
@@ -0,0 +1,164 @@
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include "net.exceptions.h"
+#include "net.sharded_acceptor.h"
+
+net::sharded_acceptor::sharded_acceptor(const socket_address& localaddr,
+	const int& shards, const int& backlog)
+	: shards_()
+	, is_started_(false)
+	, is_closed_(false)
+{
+	std::shared_ptr<net_address> addr;
+	if ((addr = localaddr.get_address()) == nullptr)
+		throw unknown_host_exception(localaddr.get_host_name());
+	std::uint16_t port = localaddr.get_port();
+
+	int count = shards > 0 ? shards :
+		static_cast<int>(std::thread::hardware_concurrency());
+	if (count < 1)
+		count = 1;
+
+	for (int i = 0; i < count; ++i) {
+		std::unique_ptr<shard> s(new shard());
+		s->accepted_ = 0;
+		s->server_ = std::make_shared<server_socket>(
+			addr->get_family() == AF_INET6);
+		s->loop_.reset(new event_loop());
+		try {
+			s->server_->set_reuse_port(true);
+			s->server_->bind(socket_address(addr, port), backlog);
+		}
+		catch (const socket_exception&) {
+			s->server_->close();
+			close();
+			throw;
+		}
+		// an ephemeral port picked by the first shard is shared by the rest
+		port = s->server_->get_local_port();
+		shards_.emplace_back(std::move(s));
+	}
+}
+
+net::sharded_acceptor::~sharded_acceptor(void)
+{
+	close();
+}
+
+void net::sharded_acceptor::start(const accept_handler& on_accept)
+{
+	if (is_closed_)
+		throw socket_exception("Socket is closed");
+	if (is_started_)
+		throw socket_exception("Acceptor is already started");
+	std::size_t added = 0;
+	std::size_t running = 0;
+	try {
+		for (; added < shards_.size(); ++added) {
+			shard* s = shards_[added].get();
+			int index = static_cast<int>(added);
+			s->loop_->add(s->server_, [s, index, on_accept](
+				const std::shared_ptr<server_socket>&,
+				const std::shared_ptr<socket>& client) {
+				s->accepted_.fetch_add(1, std::memory_order_relaxed);
+				if (on_accept != nullptr)
+					on_accept(client, index);
+			});
+		}
+		for (; running < shards_.size(); ++running) {
+			event_loop* loop = shards_[running]->loop_.get();
+			shards_[running]->thread_ = std::thread([loop]() { loop->run(); });
+		}
+	}
+	catch (...) {
+		// leave nothing behind: the shards started so far are stopped and
+		// unregistered, and the listeners closed as the constructor does
+		// when a shard fails
+		for (std::size_t i = 0; i < running; ++i)
+			shards_[i]->loop_->stop();
+		for (std::size_t i = 0; i < running; ++i)
+			shards_[i]->thread_.join();
+		for (std::size_t i = 0; i < added; ++i) {
+			try {
+				shards_[i]->loop_->remove(shards_[i]->server_);
+			}
+			catch (const socket_exception&) {
+			}
+		}
+		close();
+		throw;
+	}
+	is_started_ = true;
+}
+
+void net::sharded_acceptor::set_accept_filter(const socket_impl::accept_filter& filter)
+{
+	if (is_started_)
+		throw socket_exception("Acceptor is already started");
+	for (std::size_t i = 0; i < shards_.size(); ++i)
+		shards_[i]->server_->set_accept_filter(filter);
+}
+
+void net::sharded_acceptor::attach_filter(const socket_filter& filter)
+{
+	if (is_closed_)
+		throw socket_exception("Socket is closed");
+	for (std::size_t i = 0; i < shards_.size(); ++i)
+		shards_[i]->server_->attach_filter(filter);
+}
+
+void net::sharded_acceptor::attach_reuseport_filter(const socket_filter& filter)
+{
+	if (is_closed_)
+		throw socket_exception("Socket is closed");
+	// the shards were bound in order, so their group indices are the
+	// shard indices, and the program is shared by the whole group
+	shards_.front()->server_->attach_reuseport_filter(filter);
+}
+
+void net::sharded_acceptor::stop(void)
+{
+	if (!is_started_)
+		return;
+	for (std::size_t i = 0; i < shards_.size(); ++i)
+		shards_[i]->loop_->stop();
+	for (std::size_t i = 0; i < shards_.size(); ++i) {
+		if (shards_[i]->thread_.joinable())
+			shards_[i]->thread_.join();
+		shards_[i]->loop_->remove(shards_[i]->server_);
+	}
+	is_started_ = false;
+}
+
+void net::sharded_acceptor::close(void)
+{
+	if (is_closed_)
+		return;
+	stop();
+	for (std::size_t i = 0; i < shards_.size(); ++i)
+		shards_[i]->server_->close();
+	is_closed_ = true;
+}
+
+std::uint64_t net::sharded_acceptor::get_accept_count(void) const
+{
+	std::uint64_t total = 0;
+	for (std::size_t i = 0; i < shards_.size(); ++i)
+		total += shards_[i]->accepted_.load(std::memory_order_relaxed);
+	return total;
+}
+
+net::socket_address net::sharded_acceptor::get_local_socket_address(void) const
+{
+	if (shards_.empty())
+		return socket_address();
+	return shards_[0]->server_->get_local_socket_address();
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.sharded_acceptor.inl"
+#endif
+
+#endif
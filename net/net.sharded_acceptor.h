@@ -0,0 +1,121 @@
+#ifndef __NET_SHARDED_ACCEPTOR__
+#define __NET_SHARDED_ACCEPTOR__
+
+#include "net.config.h"
+
+#if defined(NET_LINUX)
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "net.socket_address.h"
+#include "net.server_socket.h"
+#include "net.event_loop.h"
+
+namespace net
+{
+	class sharded_acceptor
+	{
+	public:
+		/**
+		* Invoked on the shard thread for every accepted connection.
+		*/
+		typedef std::function<void(const std::shared_ptr<socket>&,
+			const int&)> accept_handler;
+	private:
+		struct shard
+		{
+			std::shared_ptr<server_socket> server_;
+			std::unique_ptr<event_loop> loop_;
+			std::thread thread_;
+			alignas(64) std::atomic<std::uint64_t> accepted_;
+		};
+		std::vector<std::unique_ptr<shard>> shards_;
+		bool is_started_;
+		bool is_closed_;
+	public:
+		/**
+		* Opens shards server sockets with SO_REUSEPORT, all bound to
+		* localaddr with the given backlog. A shard count of zero uses one
+		* shard per hardware thread. If the port of localaddr is zero, the
+		* port assigned to the first shard is shared by the others.
+		*/
+		sharded_acceptor(const socket_address& localaddr, const int& shards = 0,
+			const int& backlog = 50);
+	public:
+		virtual ~sharded_acceptor(void);
+	public:
+		/**
+		* Starts one thread per shard, each accepting from its own server
+		* socket through an event_loop. Accepted sockets are non-blocking and
+		* handed to on_accept together with the shard index. The handler
+		* must not throw. If a shard cannot be started, the shards started
+		* before it are stopped and the acceptor is closed.
+		*/
+		void start(const accept_handler& on_accept);
+
+		/**
+		* Sets the accept filter of every shard, see
+		* server_socket::set_accept_filter. It is called on all shard
+		* threads at once. Call before start.
+		*/
+		void set_accept_filter(const socket_impl::accept_filter& filter);
+
+		/**
+		* Attaches filter to every shard, see server_socket::attach_filter.
+		*/
+		void attach_filter(const socket_filter& filter);
+
+		/**
+		* Attaches a filter whose verdict is the index of the shard which
+		* receives each connection request. Verdicts past the last shard
+		* leave the choice to the kernel's hash.
+		*/
+		void attach_reuseport_filter(const socket_filter& filter);
+
+		/**
+		* Stops and joins the shard threads. The server sockets stay open.
+		*/
+		void stop(void);
+
+		/**
+		* Stops the shard threads and closes all server sockets.
+		*/
+		void close(void);
+	public:
+		/**
+		* Returns the number of shards.
+		*/
+		NET_INLINE int get_shard_count(void) const;
+
+		/**
+		* Returns the number of connections accepted by the given shard.
+		*/
+		NET_INLINE std::uint64_t get_accept_count(const int& shard) const;
+
+		/**
+		* Returns the number of connections accepted by all shards.
+		*/
+		std::uint64_t get_accept_count(void) const;
+
+		/**
+		* Gets the local socket address all shards are bound to.
+		*/
+		socket_address get_local_socket_address(void) const;
+	private:
+		sharded_acceptor(const sharded_acceptor&);
+		sharded_acceptor& operator=(const sharded_acceptor&);
+		sharded_acceptor& operator=(const sharded_acceptor&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.sharded_acceptor.inl"
+#endif
+
+#endif
+
+#endif
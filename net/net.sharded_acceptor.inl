@@ -0,0 +1,11 @@
+
+NET_INLINE int net::sharded_acceptor::get_shard_count(void) const
+{
+	return static_cast<int>(shards_.size());
+}
+
+NET_INLINE std::uint64_t net::sharded_acceptor::get_accept_count(
+	const int& shard) const
+{
+	return shards_.at(shard)->accepted_.load(std::memory_order_relaxed);
+}
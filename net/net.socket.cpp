@@ -1,13 +1,29 @@
+#include "net.error.h"
 #include "net.exceptions.h"
 #include "net.net4_address.h"
 #include "net.net6_address.h"
 #include "net.socket.h"
 #include "net.default_socket_impl.h"
+#include "net.buffer_pool.h"
+#include "net.timer_wheel.h"
+
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 std::shared_ptr<net::socket_impl_factory> net::socket::factory_;
+int net::socket::stream_input_size_ = 8192;
+int net::socket::stream_output_size_ = 8192;
+int net::socket::connection_attempt_delay_ = 250;
 
 net::socket::socket(const bool& prefer_ipv6)
 	: impl_(nullptr)
@@ -19,8 +35,7 @@ net::socket::socket(const bool& prefer_ipv6)
 	, is_output_shutdown_(false)
 	, socketbuf_(nullptr)
 {
-	impl_ = factory_ != nullptr ? factory_->create_socket_impl() :
-		std::make_shared<default_socket_impl>();
+	impl_ = create_impl();
 	socketbuf_.set_socket_impl(impl_);
 	impl_->set_local_address(prefer_ipv6 ? net6_address::ANY : net4_address::ANY);
 }
@@ -112,6 +127,35 @@ void net::socket::connect(const socket_address& remoteaddr, const int& timeout)
 	is_connected_ = true;
 }
 
+void net::socket::bind(const endpoint& localaddr)
+{
+	if (localaddr.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+
+	check_open_and_create(true, localaddr.get_family());
+	if (is_bound())
+		throw socket_exception("Socket is already bound");
+	impl_->bind(localaddr);
+	is_bound_ = true;
+}
+
+void net::socket::connect(const endpoint& remoteaddr, const int& timeout)
+{
+	if (remoteaddr.is_unspecified())
+		throw std::invalid_argument("Unspecified endpoint");
+
+	check_open_and_create(true, remoteaddr.get_family());
+	if (is_connected())
+		throw socket_exception("Socket is already connected");
+
+	if (!is_bound()) {
+		impl_->bind(endpoint(ip_address::any(remoteaddr.get_family()), 0));
+		is_bound_ = true;
+	}
+	impl_->connect(remoteaddr, timeout);
+	is_connected_ = true;
+}
+
 void net::socket::send_urgent_data(const int& value)
 {
 	if (value < 0 || value > 255)
@@ -147,27 +191,135 @@ void net::socket::close(void)
 	impl_->close();
 }
 
+int net::socket::read(std::uint8_t* buffer, const int& nbytes)
+{
+	check_open_and_create(false, 0);
+	return impl_->try_read(buffer, nbytes);
+}
+
+int net::socket::write(const std::uint8_t* buffer, const int& nbytes)
+{
+	check_open_and_create(false, 0);
+	return impl_->try_write(buffer, nbytes);
+}
+
+int net::socket::read_v(const io_vector* vec, const int& count)
+{
+	check_open_and_create(false, 0);
+	return impl_->read_v(vec, count);
+}
+
+int net::socket::write_v(const const_io_vector* vec, const int& count)
+{
+	check_open_and_create(false, 0);
+	return impl_->write_v(vec, count);
+}
+
+void net::socket::set_zero_copy(const bool& on)
+{
+	check_open_and_create(true, impl_->get_local_family());
+	impl_->set_zero_copy(on);
+}
+
+bool net::socket::get_zero_copy(void) const
+{
+	return impl_->get_zero_copy();
+}
+
+int net::socket::send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+	const std::uint64_t& tag)
+{
+	check_open_and_create(false, 0);
+	return impl_->send_zero_copy(buffer, nbytes, tag);
+}
+
+int net::socket::reap_zero_copy(std::vector<std::uint64_t>& tags,
+	const int& timeout)
+{
+	check_open_and_create(false, 0);
+	return impl_->reap_zero_copy(tags, timeout);
+}
+
+std::uint64_t net::socket::get_zero_copy_bytes(void) const
+{
+	return impl_->get_zero_copy_bytes();
+}
+
+std::uint64_t net::socket::get_copied_bytes(void) const
+{
+	return impl_->get_copied_bytes();
+}
+
+std::int64_t net::socket::send_file(const int& fd, const std::int64_t& offset,
+	const std::int64_t& length)
+{
+	check_open_and_create(false, 0);
+	if (socketbuf_.pubsync() == -1)
+		throw std::ios_base::failure("unable to flush socket stream");
+	return impl_->send_file(fd, offset, length);
+}
+
+std::int64_t net::socket::send_file(const std::string& path,
+	const std::int64_t& offset, const std::int64_t& length)
+{
+#if defined(_WIN32)
+	int fd = ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+	if (fd == -1)
+		throw std::ios_base::failure(sio::errno_exception("open", errno).what());
+	try {
+		std::int64_t sent = send_file(fd, offset, length);
+#if defined(_WIN32)
+		::_close(fd);
+#else
+		::close(fd);
+#endif
+		return sent;
+	}
+	catch (...) {
+#if defined(_WIN32)
+		::_close(fd);
+#else
+		::close(fd);
+#endif
+		throw;
+	}
+}
+
+bool net::socket::is_non_blocking(void) const
+{
+	return impl_->is_non_blocking();
+}
+
+void net::socket::set_non_blocking(const bool& on)
+{
+	check_open_and_create(true, impl_->get_local_family());
+	impl_->set_non_blocking(on);
+}
+
 bool net::socket::get_keep_alive(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_bool(SO_KEEPALIVE);
 }
 
 void net::socket::set_keep_alive(const bool& keep_alive)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	impl_->set_option_bool(SO_KEEPALIVE, keep_alive);
 }
 
 int net::socket::get_linger(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_int(SO_LINGER);
 }
 
 void net::socket::set_linger(const bool& on, const int& timeout)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (on && timeout < 0)
 		throw std::invalid_argument("timeout < 0");
 	if (on)
@@ -178,13 +330,13 @@ void net::socket::set_linger(const bool& on, const int& timeout)
 
 int net::socket::get_receive_buffer_size(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_int(SO_RCVBUF);
 }
 
 void net::socket::set_receive_buffer_size(const int& size)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (size < 1)
 		throw std::invalid_argument("size < 1");
 	impl_->set_option_int(SO_RCVBUF, size);
@@ -192,13 +344,13 @@ void net::socket::set_receive_buffer_size(const int& size)
 
 int net::socket::get_send_buffer_size(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_int(SO_SNDBUF);
 }
 
 void net::socket::set_send_buffer_size(const int& size)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (size < 1)
 		throw std::invalid_argument("size < 1");
 	impl_->set_option_int(SO_SNDBUF, size);
@@ -206,13 +358,13 @@ void net::socket::set_send_buffer_size(const int& size)
 
 int net::socket::get_receive_timeout(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_int(SO_RCVTIMEO);
 }
 
 void net::socket::set_receive_timeout(const int& timeout)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (timeout < 0)
 		throw std::invalid_argument("timeout < 0");
 	impl_->set_option_int(SO_RCVTIMEO, timeout);
@@ -220,13 +372,13 @@ void net::socket::set_receive_timeout(const int& timeout)
 
 int net::socket::get_send_timeout(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_int(SO_SNDTIMEO);
 }
 
 void net::socket::set_send_timeout(const int& timeout)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (timeout < 0)
 		throw std::invalid_argument("timeout < 0");
 	impl_->set_option_int(SO_SNDTIMEO, timeout);
@@ -234,56 +386,390 @@ void net::socket::set_send_timeout(const int& timeout)
 
 bool net::socket::get_tcp_no_delay(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_bool(TCP_NODELAY);
 }
 
 void net::socket::set_tcp_no_delay(const bool& on)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	impl_->set_option_bool(TCP_NODELAY, on);
 }
 
 bool net::socket::get_reuse_address(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_bool(SO_REUSEADDR);
 }
 
 void net::socket::set_reuse_address(const bool& reuse)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	impl_->set_option_bool(SO_REUSEADDR, reuse);
 }
 
 bool net::socket::get_oob_inline(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	return impl_->get_option_bool(SO_OOBINLINE);
 }
 
 void net::socket::set_oob_inline(const bool& oobinline)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	impl_->set_option_bool(SO_OOBINLINE, oobinline);
 }
 
 int net::socket::get_traffic_class(void)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
-	return impl_->get_option_int(IP_TOS);
+	check_open_and_create(true, impl_->get_local_family());
+	std::error_code ec;
+	int value = get_traffic_class(ec);
+	if (ec)
+		throw socket_exception(sio::errno_exception("getsockopt", ec.value()).what());
+	return value;
 }
 
 void net::socket::set_traffic_class(const int& value)
 {
-	check_open_and_create(true, impl_->get_local_address()->get_family());
+	check_open_and_create(true, impl_->get_local_family());
 	if (value < 0 || value > 255)
 	{
 		std::ostringstream stream;
 		stream << value;
 		throw std::invalid_argument("Doesn't fit in a byte: " + stream.str());
 	}
-	impl_->set_option_int(IP_TOS, value);
+	std::error_code ec;
+	set_traffic_class(value, ec);
+	if (ec)
+		throw socket_exception(sio::errno_exception("setsockopt", ec.value()).what());
+}
+
+std::int32_t net::socket::get_tag(void) const
+{
+	return impl_ != nullptr ? impl_->get_tag() : 0;
+}
+
+void net::socket::bind(const endpoint& localaddr, std::error_code& ec) noexcept
+{
+	if (localaddr.is_unspecified()) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	if (!check_open_and_create(true, localaddr.get_family(), ec))
+		return;
+	if (is_bound()) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	impl_->bind(localaddr, ec);
+	if (!ec)
+		is_bound_ = true;
+}
+
+void net::socket::connect(const endpoint& remoteaddr, const int& timeout,
+	std::error_code& ec) noexcept
+{
+	if (remoteaddr.is_unspecified()) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	if (!check_open_and_create(true, remoteaddr.get_family(), ec))
+		return;
+	if (is_connected()) {
+		ec = make_socket_error(EISCONN);
+		return;
+	}
+
+	if (!is_bound()) {
+		impl_->bind(endpoint(ip_address::any(remoteaddr.get_family()), 0), ec);
+		if (ec)
+			return;
+		is_bound_ = true;
+	}
+	impl_->connect(remoteaddr, timeout, ec);
+	if (!ec)
+		is_connected_ = true;
+}
+
+void net::socket::finish_connect(std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (is_closed())
+		ec = make_socket_error(EBADF);
+	else if (is_connected())
+		ec = make_socket_error(EISCONN);
+	else if (!is_created_)
+		ec = make_socket_error(ENOTCONN);
+	else
+		impl_->finish_connect(ec);
+	if (!ec)
+		is_connected_ = true;
+}
+
+void net::socket::send_urgent_data(const int& value, std::error_code& ec) noexcept
+{
+	if (value < 0 || value > 255) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	if (check_open_and_create(false, 0, ec))
+		impl_->send_urgent_data(value, ec);
+}
+
+void net::socket::shutdown_input(std::error_code& ec) noexcept
+{
+	if (is_input_shutdown()) {
+		ec = make_socket_error(ENOTCONN);
+		return;
+	}
+	if (!check_open_and_create(false, 0, ec))
+		return;
+	impl_->shutdown_input(ec);
+	if (!ec)
+		is_input_shutdown_ = true;
+}
+
+void net::socket::shutdown_output(std::error_code& ec) noexcept
+{
+	if (is_output_shutdown()) {
+		ec = make_socket_error(ENOTCONN);
+		return;
+	}
+	if (!check_open_and_create(false, 0, ec))
+		return;
+	impl_->shutdown_output(ec);
+	if (!ec)
+		is_output_shutdown_ = true;
+}
+
+void net::socket::close(std::error_code& ec) noexcept
+{
+	is_closed_ = true;
+	impl_->close(ec);
+}
+
+int net::socket::read(std::uint8_t* buffer, const int& nbytes, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	return impl_->try_read(buffer, nbytes, ec);
+}
+
+int net::socket::write(const std::uint8_t* buffer, const int& nbytes,
+	std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	return impl_->try_write(buffer, nbytes, ec);
+}
+
+int net::socket::read_v(const io_vector* vec, const int& count, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	return impl_->read_v(vec, count, ec);
+}
+
+int net::socket::write_v(const const_io_vector* vec, const int& count, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	return impl_->write_v(vec, count, ec);
+}
+
+void net::socket::set_zero_copy(const bool& on, std::error_code& ec) noexcept
+{
+	if (check_open_and_create(true, impl_->get_local_family(), ec))
+		impl_->set_zero_copy(on, ec);
+}
+
+int net::socket::send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+	const std::uint64_t& tag, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	return impl_->send_zero_copy(buffer, nbytes, tag, ec);
+}
+
+std::int64_t net::socket::send_file(const int& fd, const std::int64_t& offset,
+	const std::int64_t& length, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(false, 0, ec))
+		return socket_impl::failed;
+	// the stream reports failed writes by returning -1, but may throw
+	// while it allocates its buffers
+	int flushed = -1;
+	try {
+		flushed = socketbuf_.pubsync();
+	}
+	catch (...) {
+	}
+	if (flushed == -1) {
+		ec = make_socket_error(EIO);
+		return socket_impl::failed;
+	}
+	return impl_->send_file(fd, offset, length, ec);
+}
+
+std::int64_t net::socket::send_file(const std::string& path,
+	const std::int64_t& offset, const std::int64_t& length,
+	std::error_code& ec) noexcept
+{
+#if defined(_WIN32)
+	int fd = ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+	if (fd == -1) {
+		ec = make_socket_error(errno);
+		return socket_impl::failed;
+	}
+	std::int64_t sent = send_file(fd, offset, length, ec);
+#if defined(_WIN32)
+	::_close(fd);
+#else
+	::close(fd);
+#endif
+	return sent;
+}
+
+void net::socket::set_non_blocking(const bool& on, std::error_code& ec) noexcept
+{
+	if (check_open_and_create(true, impl_->get_local_family(), ec))
+		impl_->set_non_blocking(on, ec);
+}
+
+bool net::socket::get_keep_alive(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_KEEPALIVE, ec) != 0;
+}
+
+void net::socket::set_keep_alive(const bool& keep_alive, std::error_code& ec) noexcept
+{
+	set_option(SOL_SOCKET, SO_KEEPALIVE, keep_alive ? 1 : 0, ec);
+}
+
+int net::socket::get_linger(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_LINGER, ec);
+}
+
+void net::socket::set_linger(const bool& on, const int& timeout, std::error_code& ec) noexcept
+{
+	if (on && timeout < 0) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	if (on)
+		set_option(SOL_SOCKET, SO_LINGER, timeout, ec);
+	else if (check_open_and_create(true, impl_->get_local_family(), ec))
+		impl_->set_option_bool(SOL_SOCKET, SO_LINGER, false, ec);
+}
+
+int net::socket::get_receive_buffer_size(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_RCVBUF, ec);
+}
+
+void net::socket::set_receive_buffer_size(const int& size, std::error_code& ec) noexcept
+{
+	if (size < 1) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	set_option(SOL_SOCKET, SO_RCVBUF, size, ec);
+}
+
+int net::socket::get_send_buffer_size(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_SNDBUF, ec);
+}
+
+void net::socket::set_send_buffer_size(const int& size, std::error_code& ec) noexcept
+{
+	if (size < 1) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	set_option(SOL_SOCKET, SO_SNDBUF, size, ec);
+}
+
+int net::socket::get_receive_timeout(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_RCVTIMEO, ec);
+}
+
+void net::socket::set_receive_timeout(const int& timeout, std::error_code& ec) noexcept
+{
+	if (timeout < 0) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	set_option(SOL_SOCKET, SO_RCVTIMEO, timeout, ec);
+}
+
+int net::socket::get_send_timeout(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_SNDTIMEO, ec);
+}
+
+void net::socket::set_send_timeout(const int& timeout, std::error_code& ec) noexcept
+{
+	if (timeout < 0) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	set_option(SOL_SOCKET, SO_SNDTIMEO, timeout, ec);
+}
+
+bool net::socket::get_tcp_no_delay(std::error_code& ec) noexcept
+{
+	return get_option(IPPROTO_TCP, TCP_NODELAY, ec) != 0;
+}
+
+void net::socket::set_tcp_no_delay(const bool& on, std::error_code& ec) noexcept
+{
+	set_option(IPPROTO_TCP, TCP_NODELAY, on ? 1 : 0, ec);
+}
+
+bool net::socket::get_reuse_address(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_REUSEADDR, ec) != 0;
+}
+
+void net::socket::set_reuse_address(const bool& reuse, std::error_code& ec) noexcept
+{
+	set_option(SOL_SOCKET, SO_REUSEADDR, reuse ? 1 : 0, ec);
+}
+
+bool net::socket::get_oob_inline(std::error_code& ec) noexcept
+{
+	return get_option(SOL_SOCKET, SO_OOBINLINE, ec) != 0;
+}
+
+void net::socket::set_oob_inline(const bool& oobinline, std::error_code& ec) noexcept
+{
+	set_option(SOL_SOCKET, SO_OOBINLINE, oobinline ? 1 : 0, ec);
+}
+
+int net::socket::get_traffic_class(std::error_code& ec) noexcept
+{
+	if (impl_->get_local_family() == AF_INET6)
+		return get_option(IPPROTO_IPV6, IPV6_TCLASS, ec);
+	return get_option(IPPROTO_IP, IP_TOS, ec);
+}
+
+void net::socket::set_traffic_class(const int& value, std::error_code& ec) noexcept
+{
+	if (value < 0 || value > 255) {
+		ec = make_socket_error(EINVAL);
+		return;
+	}
+	if (impl_->get_local_family() == AF_INET6)
+		set_option(IPPROTO_IPV6, IPV6_TCLASS, value, ec);
+	else
+		set_option(IPPROTO_IP, IP_TOS, value, ec);
 }
 
 std::shared_ptr<net::net_address> net::socket::get_address(void) const
@@ -324,6 +810,30 @@ net::socket_address net::socket::get_remote_socket_address(void) const
 	return socket_address(get_address(), get_port());
 }
 
+net::endpoint net::socket::get_local_endpoint(void) const
+{
+	if (!is_bound())
+		return endpoint();
+	if (!impl_->get_local_endpoint().is_unspecified())
+		return impl_->get_local_endpoint();
+	std::shared_ptr<net_address> addr = impl_->get_local_address();
+	if (addr == nullptr)
+		return endpoint();
+	return endpoint(ip_address(*addr), impl_->get_local_port());
+}
+
+net::endpoint net::socket::get_remote_endpoint(void) const
+{
+	if (!is_connected())
+		return endpoint();
+	if (!impl_->get_remote_endpoint().is_unspecified())
+		return impl_->get_remote_endpoint();
+	std::shared_ptr<net_address> addr = impl_->get_address();
+	if (addr == nullptr)
+		return endpoint();
+	return endpoint(ip_address(*addr), impl_->get_port());
+}
+
 void net::socket::set_socket_impl_factory(
 	const std::shared_ptr<net::socket_impl_factory>& fac)
 {
@@ -332,9 +842,25 @@ void net::socket::set_socket_impl_factory(
 	factory_ = fac;
 }
 
+void net::socket::set_default_stream_buffer_size(const int& input_size,
+	const int& output_size)
+{
+	if (input_size < 16 || output_size < 16)
+		throw socket_exception("Invalid buffer size");
+	stream_input_size_ = input_size;
+	stream_output_size_ = output_size;
+}
+
+void net::socket::set_connection_attempt_delay(const int& delay)
+{
+	connection_attempt_delay_ = delay;
+}
+
 void net::socket::accepted(void)
 {
-	is_created_ = is_bound_ = is_connected_ = true;
+	is_created_ = true;
+	is_bound_ = true;
+	is_connected_ = true;
 }
 
 bool net::socket::is_connected(void) const
@@ -368,6 +894,27 @@ net::socket::get_stream(void)
 	return &socketbuf_;
 }
 
+void net::socket::set_stream_buffer_size(const int& input_size,
+	const int& output_size)
+{
+	socketbuf_.set_buffer_sizes(input_size, output_size);
+}
+
+int net::socket::get_stream_input_buffer_size(void) const
+{
+	return socketbuf_.get_input_size();
+}
+
+int net::socket::get_stream_output_buffer_size(void) const
+{
+	return socketbuf_.get_output_size();
+}
+
+void net::socket::release_stream_buffers(void)
+{
+	socketbuf_.release_buffers();
+}
+
 void net::socket::try_all_addresses(const std::string& dstname,
 	const std::uint16_t& dstport,
 	const std::shared_ptr<net::net_address>& localaddr,
@@ -379,23 +926,148 @@ void net::socket::try_all_addresses(const std::string& dstname,
 	std::vector<std::shared_ptr<net_address>> dstaddrs =
 		net_address::get_all_by_name(dstname);
 
-	bool match = true;
-	for (int n = 0; n < 2; ++n) {
-		for (std::size_t i = 0; i < dstaddrs.size(); ++i) {
-			std::shared_ptr<net_address> dstaddr = dstaddrs[i];
-			if ((addr->get_family() == dstaddr->get_family()) != match)
+	// the family of the local address first, then the other one
+	std::vector<std::shared_ptr<net_address>> preferred;
+	std::vector<std::shared_ptr<net_address>> others;
+	for (std::size_t i = 0; i < dstaddrs.size(); ++i) {
+		if (addr->get_family() == dstaddrs[i]->get_family())
+			preferred.push_back(dstaddrs[i]);
+		else
+			others.push_back(dstaddrs[i]);
+	}
+
+	// a fixed local port cannot be bound by several attempts at once
+	if (connection_attempt_delay_ > 0 && localport == 0 && dstaddrs.size() > 1) {
+		std::vector<std::shared_ptr<net_address>> interleaved;
+		std::size_t p = 0;
+		std::size_t o = 0;
+		while (p < preferred.size() || o < others.size()) {
+			if (p < preferred.size())
+				interleaved.push_back(preferred[p++]);
+			if (o < others.size())
+				interleaved.push_back(others[o++]);
+		}
+		if (race_addresses(interleaved, dstport, localaddr))
+			return;
+		throw socket_exception("Cannot connect to " + dstname);
+	}
+
+	preferred.insert(preferred.end(), others.begin(), others.end());
+	for (std::size_t i = 0; i < preferred.size(); ++i) {
+		try {
+			startup_socket(preferred[i], dstport, localaddr, localport);
+			return;
+		}
+		catch (const std::exception&) {
+		}
+	}
+
+	throw socket_exception("Cannot connect to " + dstname);
+}
+
+bool net::socket::race_addresses(
+	const std::vector<std::shared_ptr<net::net_address>>& dstaddrs,
+	const std::uint16_t& dstport,
+	const std::shared_ptr<net::net_address>& localaddr)
+{
+	struct attempt
+	{
+		std::shared_ptr<socket_impl> impl_;
+		std::shared_ptr<net_address> addr_;
+	};
+	std::vector<attempt> pending;
+	std::shared_ptr<socket_impl> winner;
+	std::shared_ptr<net_address> winner_addr;
+	std::size_t next = 0;
+	std::uint64_t next_start = 0;
+	while (winner == nullptr) {
+		std::uint64_t now = timer_wheel::now_millis();
+		if (next < dstaddrs.size() && (pending.empty() || now >= next_start)) {
+			std::shared_ptr<net_address> dstaddr = dstaddrs[next++];
+			next_start = now + connection_attempt_delay_;
+			std::shared_ptr<net_address> addr = (localaddr != nullptr) ?
+				localaddr : (dstaddr->get_family() == AF_INET6) ?
+				net6_address::ANY : net4_address::ANY;
+			std::shared_ptr<socket_impl> impl = create_impl();
+			try {
+				impl->create(addr->get_family());
+				impl->bind(addr, 0);
+				if (impl->try_connect(dstaddr, dstport)) {
+					winner = impl;
+					winner_addr = dstaddr;
+					break;
+				}
+				attempt a = { impl, dstaddr };
+				pending.push_back(a);
+			}
+			catch (const socket_exception&) {
+				impl->close();
+				next_start = now;	// failed, do not wait to start the next
+			}
+			continue;
+		}
+		if (pending.empty())
+			break;
+
+		std::vector<struct pollfd> fds(pending.size());
+		for (std::size_t i = 0; i < pending.size(); ++i) {
+			fds[i].fd = pending[i].impl_->get_native_socket();
+			fds[i].events = POLLOUT;
+			fds[i].revents = 0;
+		}
+		int timeout = next < dstaddrs.size() ?
+			static_cast<int>(next_start > now ? next_start - now : 0) : -1;
+#if defined(_WIN32)
+		int ready = ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout);
+#else
+		int ready = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout);
+#endif
+		if (ready < 0) {
+#if defined(_WIN32)
+			int error = sio::socket_errno(::WSAGetLastError());
+#else
+			int error = errno;
+#endif
+			if (error == EINTR)
+				continue;
+			for (std::size_t i = 0; i < pending.size(); ++i)
+				pending[i].impl_->close();
+			throw socket_exception(sio::errno_exception("poll", error).what());
+		}
+		if (ready == 0)
+			continue;	// the next attempt is due
+		for (std::size_t i = pending.size(); i-- > 0; ) {
+			if (fds[i].revents == 0)
 				continue;
+			attempt a = pending[i];
+			pending.erase(pending.begin() + i);
 			try {
-				startup_socket(dstaddr, dstport, localaddr, localport);
-				return;
+				a.impl_->finish_connect();
+				if (winner == nullptr) {
+					winner = a.impl_;
+					winner_addr = a.addr_;
+					continue;
+				}
 			}
-			catch (const std::exception&) {
+			catch (const socket_exception&) {
+				next_start = now;	// failed, do not wait to start the next
 			}
+			a.impl_->close();
 		}
-		match = false;
 	}
-
-	throw socket_exception("Cannot connect to " + dstname);
+	for (std::size_t i = 0; i < pending.size(); ++i)
+		pending[i].impl_->close();
+	if (winner == nullptr)
+		return false;
+
+	impl_ = winner;
+	impl_->set_address(winner_addr);
+	impl_->set_port(dstport);
+	socketbuf_.reset_socket_impl(impl_);
+	is_created_ = true;
+	is_bound_ = true;
+	is_connected_ = true;
+	return true;
 }
 
 void net::socket::startup_socket(std::shared_ptr<net::net_address> dstaddr,
@@ -414,16 +1086,18 @@ void net::socket::startup_socket(std::shared_ptr<net::net_address> dstaddr,
 		impl_->connect(dstaddr, dstport);
 		is_connected_ = true;
 	}
-	catch (const socket_timeout_exception& e) {
+	catch (const socket_exception&) {
 		impl_->close();
-		throw e;
-	}
-	catch (const socket_exception& e) {
-		impl_->close();
-		throw e;
+		throw;
 	}
 }
 
+std::shared_ptr<net::socket_impl> net::socket::create_impl(void)
+{
+	return factory_ != nullptr ? factory_->create_socket_impl() :
+		std::make_shared<default_socket_impl>();
+}
+
 void net::socket::check_open_and_create(const bool& create, const int& family)
 {
 	if (is_closed())
@@ -435,24 +1109,64 @@ void net::socket::check_open_and_create(const bool& create, const int& family)
 	}
 	if (is_created_)
 		return;
-	try {
-		impl_->create(family);
+	impl_->create(family);
+	is_created_ = true;
+}
+
+bool net::socket::check_open_and_create(const bool& create, const int& family,
+	std::error_code& ec) noexcept
+{
+	ec.clear();
+	if (is_closed()) {
+		ec = make_socket_error(EBADF);
+		return false;
 	}
-	catch (const socket_exception& e) {
-		throw e;
+	if (!create) {
+		if (!is_connected()) {
+			ec = make_socket_error(ENOTCONN);
+			return false;
+		}
+		return true;
 	}
+	if (is_created_)
+		return true;
+	impl_->create(family, ec);
+	if (ec)
+		return false;
 	is_created_ = true;
+	return true;
+}
+
+int net::socket::get_option(const int& level, const int& id, std::error_code& ec) noexcept
+{
+	if (!check_open_and_create(true, impl_->get_local_family(), ec))
+		return 0;
+	return impl_->get_option_int(level, id, ec);
+}
+
+void net::socket::set_option(const int& level, const int& id, const int& value,
+	std::error_code& ec) noexcept
+{
+	if (check_open_and_create(true, impl_->get_local_family(), ec))
+		impl_->set_option_int(level, id, value, ec);
 }
 
 net::socket::socketbuf::socketbuf(const std::shared_ptr<net::socket_impl>& impl)
 	: impl_(impl)
+	, obuffer_(nullptr)
+	, ibuffer_(nullptr)
+	, osize_(stream_output_size_)
+	, isize_(stream_input_size_)
 {
-	setp(obase(), oend());
-	setg(iend(), iend(), iend());
+	// the buffers are drawn from the pool on first use
+	setp(nullptr, nullptr);
+	setg(nullptr, nullptr, nullptr);
 }
 
 net::socket::socketbuf::~socketbuf(void)
 {
+	release_output();
+	release_input();
 }
 
 void net::socket::socketbuf::set_socket_impl(
@@ -463,33 +1177,80 @@ void net::socket::socketbuf::set_socket_impl(
 	impl_ = impl;
 }
 
+void net::socket::socketbuf::reset_socket_impl(
+	const std::shared_ptr<net::socket_impl>& impl)
+{
+	// only before the socket is connected, when nothing is buffered
+	impl_ = impl;
+}
+
+void net::socket::socketbuf::set_buffer_sizes(const int& input_size,
+	const int& output_size)
+{
+	if (input_size < 16 || output_size < 16)
+		throw socket_exception("Invalid buffer size");
+	if (gptr() < egptr())
+		throw socket_exception("Stream input buffer is not empty");
+	if (!flush())
+		throw socket_exception("Unable to flush stream output buffer");
+	release_output();
+	release_input();
+	osize_ = output_size;
+	isize_ = input_size;
+}
+
+void net::socket::socketbuf::release_buffers(void)
+{
+	if (pptr() == pbase())
+		release_output();
+	if (gptr() == egptr())
+		release_input();
+}
+
 net::socket::socketbuf::int_type net::socket::socketbuf::overflow(
 	net::socket::socketbuf::int_type c)
 {
 	int_type eof = std::char_traits<char>::eof();
+	if (obuffer_ == nullptr) {
+		obuffer_ = (char*) buffer_pool::get_default().allocate(osize_);
+		setp(obase(), oend());
+	}
 	if (c != eof)
 		*pptr() = c, pbump(1);
-	return sync() == -1 ? eof : c;
+	if (pptr() < epptr())
+		return std::char_traits<char>::not_eof(c);
+	return flush() ? std::char_traits<char>::not_eof(c) : eof;
 }
 
 net::socket::socketbuf::int_type net::socket::socketbuf::underflow(void)
 {
 	if (gptr() < egptr()) // buffer not exhausted
 		return std::char_traits<char>::to_int_type(*gptr());
+	if (ibuffer_ == nullptr)
+		ibuffer_ = (char*) buffer_pool::get_default().allocate(isize_);
 	char* base = ibase();
 	char* start = base;
 	if (eback() == base) {
-		// make room for 2 putback characters
-		std::memmove(base, egptr() - 2, 2);
-		start += 2;
+		// make room for up to 2 putback characters
+		std::ptrdiff_t putback = std::min<std::ptrdiff_t>(egptr() - base, 2);
+		std::memmove(base, egptr() - putback, putback);
+		start += putback;
 	}
 	try {
 		int size = impl_->read((std::uint8_t*) start, (int)(iend() - start));
-		if (size < 1)
+		if (size == socket_impl::end_of_stream) {
+			release_input();
 			return std::char_traits<char>::eof();
+		}
+		if (size < 1) {
+			// timed out: keep the putback characters for the next read
+			setg(base, start, start);
+			return std::char_traits<char>::eof();
+		}
 		setg(base, start, start + size);
 	}
 	catch (const std::ios_base::failure&) {
+		release_input();
 		return std::char_traits<char>::eof();
 	}
 	return std::char_traits<char>::to_int_type(*gptr());
@@ -497,14 +1258,42 @@ net::socket::socketbuf::int_type net::socket::socketbuf::underflow(void)
 
 int net::socket::socketbuf::sync(void)
 {
+	if (!flush())
+		return -1;
+	release_output();	// an explicit flush usually ends a message
+	return 0;
+}
+
+bool net::socket::socketbuf::flush(void)
+{
+	if (pptr() == pbase())
+		return true;
 	try {
 		impl_->write((std::uint8_t*) pbase(), (int)(pptr() - pbase()));
 		setp(obase(), oend());
 	}
 	catch (const std::ios_base::failure&) {
-		return -1;
+		return false;
 	}
-	return 0;
+	return true;
+}
+
+void net::socket::socketbuf::release_output(void)
+{
+	if (obuffer_ == nullptr)
+		return;
+	buffer_pool::get_default().deallocate((std::uint8_t*) obuffer_, osize_);
+	obuffer_ = nullptr;
+	setp(nullptr, nullptr);
+}
+
+void net::socket::socketbuf::release_input(void)
+{
+	if (ibuffer_ == nullptr)
+		return;
+	buffer_pool::get_default().deallocate((std::uint8_t*) ibuffer_, isize_);
+	ibuffer_ = nullptr;
+	setg(nullptr, nullptr, nullptr);
 }
 
 std::streamsize net::socket::socketbuf::showmanyc(void)
@@ -512,6 +1301,85 @@ std::streamsize net::socket::socketbuf::showmanyc(void)
 	return impl_->available();
 }
 
+std::streamsize net::socket::socketbuf::xsputn(const char* s, std::streamsize n)
+{
+	std::streamsize written = 0;
+	if (n < osize_) {
+		// small writes are gathered in the buffer
+		while (written < n) {
+			if (pptr() == epptr() && overflow() == std::char_traits<char>::eof())
+				break;
+			std::streamsize count = std::min<std::streamsize>(epptr() - pptr(), n - written);
+			std::memcpy(pptr(), s + written, (std::size_t) count);
+			pbump((int) count);
+			written += count;
+		}
+		return written;
+	}
+	// large writes skip the buffer and leave together with what it holds
+	try {
+		while (written < n) {
+			int pending = (int)(pptr() - pbase());
+			int count = (int) std::min<std::streamsize>(n - written, 1 << 30);
+			const_io_vector vec[2] = {
+				{ (const std::uint8_t*) pbase(), pending },
+				{ (const std::uint8_t*) s + written, count }
+			};
+			int sent = std::max(impl_->write_v(vec, 2), 0);
+			if (sent < pending) {
+				// keep what the timeout left unsent
+				std::memmove(pbase(), pbase() + sent, pending - sent);
+				setp(obase(), oend());
+				pbump(pending - sent);
+				break;
+			}
+			if (pending > 0)
+				setp(obase(), oend());
+			written += sent - pending;
+			if (sent < pending + count)
+				break;
+		}
+	}
+	catch (const std::ios_base::failure&) {
+	}
+	catch (const socket_exception&) {
+	}
+	return written;
+}
+
+std::streamsize net::socket::socketbuf::xsgetn(char* s, std::streamsize n)
+{
+	std::streamsize count = 0;
+	while (count < n) {
+		if (gptr() < egptr()) {
+			std::streamsize size = std::min<std::streamsize>(egptr() - gptr(), n - count);
+			std::memcpy(s + count, gptr(), (std::size_t) size);
+			gbump((int) size);
+			count += size;
+			continue;
+		}
+		if (n - count < isize_) {
+			if (underflow() == std::char_traits<char>::eof())
+				break;
+			continue;
+		}
+		// large reads go straight into the caller's memory
+		int size;
+		try {
+			size = impl_->read((std::uint8_t*) s + count,
+				(int) std::min<std::streamsize>(n - count, 1 << 30));
+		}
+		catch (const std::ios_base::failure&) {
+			break;
+		}
+		if (size < 1)
+			break;
+		count += size;
+		release_input();	// the buffer holds no putback data now
+	}
+	return count;
+}
+
 #if !defined(__NET_INLINE__)
 #include "net.socket.inl"
 #endif
@@ -3,7 +3,10 @@
 
 #include <memory>
 #include <streambuf>
+#include <system_error>
+#include <vector>
 
+#include "net.endpoint.h"
 #include "net.socket_address.h"
 #include "net.socket_impl_factory.h"
 
@@ -20,6 +23,9 @@ namespace net
 		volatile bool is_output_shutdown_;
 	private:
 		static std::shared_ptr<socket_impl_factory> factory_;
+		static int stream_input_size_;
+		static int stream_output_size_;
+		static int connection_attempt_delay_;
 	public:
 		/**
 		* Creates an unconnected socket:
@@ -71,6 +77,24 @@ namespace net
 		*/
 		static void set_socket_impl_factory(
 			const std::shared_ptr<socket_impl_factory>& fac);
+
+		/**
+		* Sets the stream buffer sizes of sockets created afterwards. The
+		* default is 8 KB for each direction.
+		*/
+		static void set_default_stream_buffer_size(const int& input_size,
+			const int& output_size);
+
+		/**
+		* Sets the delay in milliseconds between the connection attempts
+		* made when a socket is connected to a host name with several
+		* addresses. The addresses of both families are interleaved and each
+		* attempt starts when the previous one failed or the delay passed,
+		* while the earlier ones go on; the first to connect is kept. The
+		* default is 250. A delay of zero or less tries the addresses one
+		* after the other.
+		*/
+		static void set_connection_attempt_delay(const int& delay);
 	public:
 		/**
 		* Binds the socket to a local address. If the address is null, then
@@ -86,6 +110,19 @@ namespace net
 		*/
 		virtual void connect(const socket_address& remoteaddr, const int& timeout = 0);
 
+		/**
+		* Binds the socket to a local endpoint. Port zero lets the system
+		* pick an ephemeral port. No net_address is created.
+		*/
+		virtual void bind(const endpoint& localaddr);
+
+		/**
+		* Connects this socket to a remote endpoint with a specified timeout
+		* value, zero meaning no timeout. No name lookup takes place and no
+		* net_address is created.
+		*/
+		virtual void connect(const endpoint& remoteaddr, const int& timeout = 0);
+
 		/**
 		* Send one byte of urgent data on the socket. The byte to be sent is
 		* the lowest eight bits of the data parameter.
@@ -112,6 +149,117 @@ namespace net
 		* Closes this socket.
 		*/
 		virtual void close(void);
+	public:
+		/**
+		* Reads at most nbytes into buffer. Returns the number of bytes read,
+		* socket_impl::end_of_stream once the peer closed the connection, or
+		* socket_impl::would_block when the socket is non-blocking and no data
+		* is pending. Would-block conditions never raise an exception.
+		*/
+		virtual int read(std::uint8_t* buffer, const int& nbytes);
+
+		/**
+		* Writes at most nbytes from buffer. Returns the number of bytes
+		* written, which may be less than nbytes on a non-blocking socket,
+		* or socket_impl::would_block when the send buffer is full.
+		*/
+		virtual int write(const std::uint8_t* buffer, const int& nbytes);
+
+		/**
+		* Reads into the count buffers of vec in order with a single system
+		* call. Returns the number of bytes read, socket_impl::end_of_stream
+		* or socket_impl::would_block as read() does.
+		*/
+		virtual int read_v(const io_vector* vec, const int& count);
+
+		/**
+		* Writes the count buffers of vec in order with a single system call
+		* where possible, so the parts of a message need not be copied into
+		* one buffer. Returns the number of bytes written, which is less than
+		* the total only on a non-blocking socket or if the send timeout
+		* expired after part of the data was sent, or socket_impl::would_block.
+		* Throws std::ios_base::failure, as write() does, if the send timeout
+		* expired before any byte was sent.
+		*/
+		virtual int write_v(const const_io_vector* vec, const int& count);
+
+		/**
+		* Enable/disable zero-copy transmission (SO_ZEROCOPY) for
+		* send_zero_copy(). Throws socket_exception where the platform does
+		* not support it.
+		*/
+		virtual void set_zero_copy(const bool& on);
+
+		/**
+		* Tests if zero-copy transmission is enabled.
+		*/
+		virtual bool get_zero_copy(void) const;
+
+		/**
+		* Sends nbytes from buffer. With zero-copy enabled, payloads of at
+		* least 64 KB are sent with MSG_ZEROCOPY: the kernel transmits
+		* straight from buffer, which must stay unchanged until
+		* reap_zero_copy() hands tag back. Smaller payloads, and all
+		* payloads once the kernel reported that it had to copy anyway, are
+		* copied and their tag is handed back right away. Returns the number
+		* of bytes sent as write_v() does.
+		*/
+		virtual int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag);
+
+		/**
+		* Appends the tags of buffers the kernel has released to tags,
+		* waiting up to timeout milliseconds if none is ready yet. Returns
+		* the number of tags appended.
+		*/
+		virtual int reap_zero_copy(std::vector<std::uint64_t>& tags,
+			const int& timeout = 0);
+
+		/**
+		* Returns the number of released bytes sent without a copy.
+		*/
+		virtual std::uint64_t get_zero_copy_bytes(void) const;
+
+		/**
+		* Returns the number of released bytes which were copied.
+		*/
+		virtual std::uint64_t get_copied_bytes(void) const;
+
+		/**
+		* Sends length bytes of the open file fd starting at offset. The
+		* bytes are moved by the kernel with sendfile, or splice through a
+		* pipe for files sendfile cannot read, and never cross user space.
+		* A negative length sends up to the end of the file. Output pending
+		* in the stream buffer is flushed first. Returns the number of bytes
+		* sent, which is less than requested if the file ended, the send
+		* timeout expired after part of the data was sent, or the socket is
+		* non-blocking and its send buffer filled up; resume at offset plus
+		* the returned count. A pipe or socket fd has no offset; the bytes
+		* read from it which did not reach the socket are kept and sent
+		* first by the next call. Throws socket_timeout_exception if the
+		* timeout expired before any byte was sent. As with write(2), a reset
+		* connection raises SIGPIPE unless the signal is ignored.
+		*/
+		virtual std::int64_t send_file(const int& fd, const std::int64_t& offset = 0,
+			const std::int64_t& length = -1);
+
+		/**
+		* Opens the named file and sends it as send_file(fd, offset, length).
+		*/
+		virtual std::int64_t send_file(const std::string& path,
+			const std::int64_t& offset = 0, const std::int64_t& length = -1);
+
+		/**
+		* Tests if the socket is in non-blocking mode.
+		*/
+		virtual bool is_non_blocking(void) const;
+
+		/**
+		* Enable/disable non-blocking mode. In non-blocking mode read() and
+		* write() return partial counts and would-block results instead of
+		* waiting.
+		*/
+		virtual void set_non_blocking(const bool& on);
 	public:
 		/**
 		* Tests if SO_KEEPALIVE is enabled.
@@ -237,6 +385,76 @@ namespace net
 		* it a hint. 
 		*/
 		virtual void set_traffic_class(const int& value);
+
+		/**
+		* Gets the tag the accept filter of the server socket gave this
+		* connection, zero if there was none.
+		*/
+		virtual std::int32_t get_tag(void) const;
+	public:
+		/**
+		* The overloads below never throw: a failure is stored in ec, which
+		* is cleared on success, and calls returning a count return
+		* socket_impl::failed. The errors are the errno values of the
+		* failing calls in socket_category(), so ec compares equal to the
+		* std::errc constants; an operation on a closed socket fails with
+		* bad_file_descriptor and a transfer on an unconnected one with
+		* not_connected. Connects, accepts and sends which time out fail
+		* with timed_out; reads, and writes on a non-blocking socket,
+		* return socket_impl::would_block as the throwing versions do.
+		*
+		* A connect with a zero timeout on a non-blocking socket fails with
+		* operation_in_progress unless the connection was made at once;
+		* once the socket is writable finish_connect() completes it, or
+		* fails with the error of the attempt.
+		*/
+		virtual void bind(const endpoint& localaddr, std::error_code& ec) noexcept;
+		virtual void connect(const endpoint& remoteaddr, const int& timeout,
+			std::error_code& ec) noexcept;
+		virtual void finish_connect(std::error_code& ec) noexcept;
+		virtual void send_urgent_data(const int& value, std::error_code& ec) noexcept;
+		virtual void shutdown_input(std::error_code& ec) noexcept;
+		virtual void shutdown_output(std::error_code& ec) noexcept;
+		virtual void close(std::error_code& ec) noexcept;
+		virtual int read(std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept;
+		virtual int write(const std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept;
+		virtual int read_v(const io_vector* vec, const int& count,
+			std::error_code& ec) noexcept;
+		virtual int write_v(const const_io_vector* vec, const int& count,
+			std::error_code& ec) noexcept;
+		virtual void set_zero_copy(const bool& on, std::error_code& ec) noexcept;
+		virtual int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag, std::error_code& ec) noexcept;
+		virtual std::int64_t send_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length, std::error_code& ec) noexcept;
+		virtual std::int64_t send_file(const std::string& path,
+			const std::int64_t& offset, const std::int64_t& length,
+			std::error_code& ec) noexcept;
+		virtual void set_non_blocking(const bool& on, std::error_code& ec) noexcept;
+	public:
+		virtual bool get_keep_alive(std::error_code& ec) noexcept;
+		virtual void set_keep_alive(const bool& keep_alive, std::error_code& ec) noexcept;
+		virtual int get_linger(std::error_code& ec) noexcept;
+		virtual void set_linger(const bool& on, const int& timeout,
+			std::error_code& ec) noexcept;
+		virtual int get_receive_buffer_size(std::error_code& ec) noexcept;
+		virtual void set_receive_buffer_size(const int& size, std::error_code& ec) noexcept;
+		virtual int get_send_buffer_size(std::error_code& ec) noexcept;
+		virtual void set_send_buffer_size(const int& size, std::error_code& ec) noexcept;
+		virtual int get_receive_timeout(std::error_code& ec) noexcept;
+		virtual void set_receive_timeout(const int& timeout, std::error_code& ec) noexcept;
+		virtual int get_send_timeout(std::error_code& ec) noexcept;
+		virtual void set_send_timeout(const int& timeout, std::error_code& ec) noexcept;
+		virtual bool get_tcp_no_delay(std::error_code& ec) noexcept;
+		virtual void set_tcp_no_delay(const bool& on, std::error_code& ec) noexcept;
+		virtual bool get_reuse_address(std::error_code& ec) noexcept;
+		virtual void set_reuse_address(const bool& reuse, std::error_code& ec) noexcept;
+		virtual bool get_oob_inline(std::error_code& ec) noexcept;
+		virtual void set_oob_inline(const bool& oobinline, std::error_code& ec) noexcept;
+		virtual int get_traffic_class(std::error_code& ec) noexcept;
+		virtual void set_traffic_class(const int& value, std::error_code& ec) noexcept;
 	public:
 		/**
 		* Returns the address to which the socket is connected. If the socket
@@ -275,6 +493,18 @@ namespace net
 		* or null if it is unconnected. 
 		*/
 		virtual socket_address get_remote_socket_address(void) const;
+
+		/**
+		* Returns the endpoint this socket is bound to, or an unspecified
+		* endpoint if it is not bound yet.
+		*/
+		virtual endpoint get_local_endpoint(void) const;
+
+		/**
+		* Returns the endpoint this socket is connected to, or an
+		* unspecified endpoint if it is unconnected.
+		*/
+		virtual endpoint get_remote_endpoint(void) const;
 	public:
 		virtual void accepted(void);
 	public:
@@ -311,12 +541,21 @@ namespace net
 			const std::uint16_t& dstport,
 			const std::shared_ptr<net_address>& localaddr,
 			const std::uint16_t& localport);
+		bool race_addresses(const std::vector<std::shared_ptr<net_address>>& dstaddrs,
+			const std::uint16_t& dstport,
+			const std::shared_ptr<net_address>& localaddr);
 		void startup_socket(std::shared_ptr<net_address> dstaddr,
 			const std::uint16_t& dstport,
 			const std::shared_ptr<net_address>& localaddr,
 			const std::uint16_t& localport);
 		void check_open_and_create(const bool& create, const int& family);
+		bool check_open_and_create(const bool& create, const int& family,
+			std::error_code& ec) noexcept;
+		int get_option(const int& level, const int& id, std::error_code& ec) noexcept;
+		void set_option(const int& level, const int& id, const int& value,
+			std::error_code& ec) noexcept;
 		void cache_local_address(void);
+		static std::shared_ptr<socket_impl> create_impl(void);
 	private:
 		socket(const socket&);
 		socket& operator=(const socket&);
@@ -325,25 +564,38 @@ namespace net
 		class socketbuf : public std::basic_streambuf<char, std::char_traits<char>>
 		{
 			std::shared_ptr<socket_impl> impl_;
-			char obuffer_[1024];
-			char ibuffer_[1024];
+			char* obuffer_;
+			char* ibuffer_;
+			int osize_;
+			int isize_;
 		public:
 			socketbuf(const std::shared_ptr<socket_impl>& impl);
 		public:
 			virtual ~socketbuf(void);
 		public:
-			NET_INLINE char* obase(int n = 0) const;
-			NET_INLINE char* oend(int n = 1024 - 1) const;
-			NET_INLINE char* ibase(int n = 0) const;
-			NET_INLINE char* iend(int n = 1024) const;
+			NET_INLINE char* obase(void) const;
+			NET_INLINE char* oend(void) const;
+			NET_INLINE char* ibase(void) const;
+			NET_INLINE char* iend(void) const;
+			NET_INLINE int get_input_size(void) const;
+			NET_INLINE int get_output_size(void) const;
 		protected:
 			typedef std::basic_streambuf<char, std::char_traits<char>>::int_type int_type;
 			virtual int_type overflow(int_type c = std::char_traits<char>::eof());
 			virtual int_type underflow(void);
 			virtual int sync(void);
 			virtual std::streamsize showmanyc(void);
+			virtual std::streamsize xsputn(const char* s, std::streamsize n);
+			virtual std::streamsize xsgetn(char* s, std::streamsize n);
 		public:
 			void set_socket_impl(const std::shared_ptr<socket_impl>& impl);
+			void reset_socket_impl(const std::shared_ptr<socket_impl>& impl);
+			void set_buffer_sizes(const int& input_size, const int& output_size);
+			void release_buffers(void);
+		private:
+			bool flush(void);
+			void release_output(void);
+			void release_input(void);
 		};
 		socketbuf socketbuf_;
 	public:
@@ -351,6 +603,32 @@ namespace net
 		* Returns an input/output stream buffer for this socket. 
 		*/
 		virtual std::basic_streambuf<char, std::char_traits<char>>* get_stream(void);
+
+		/**
+		* Sets the sizes in bytes of the input and output buffers of the
+		* stream. The buffers are drawn from buffer_pool::get_default() on
+		* first use and go back once drained, and transfers at least as
+		* large as a buffer bypass it. Pending output is flushed
+		* first; unread input must have been consumed.
+		*/
+		virtual void set_stream_buffer_size(const int& input_size,
+			const int& output_size);
+
+		/**
+		* Returns the size of the stream input buffer.
+		*/
+		virtual int get_stream_input_buffer_size(void) const;
+
+		/**
+		* Returns the size of the stream output buffer.
+		*/
+		virtual int get_stream_output_buffer_size(void) const;
+
+		/**
+		* Returns the stream buffers to the pool unless they hold data. Call
+		* it on connections which go idle.
+		*/
+		virtual void release_stream_buffers(void);
 	};
 }
 
@@ -16,22 +16,33 @@ NET_INLINE void net::socket::set_impl(const std::shared_ptr<socket_impl>& impl)
 	socketbuf_.set_socket_impl(impl);
 }
 
-NET_INLINE char* net::socket::socketbuf::obase(int n) const
+NET_INLINE char* net::socket::socketbuf::obase(void) const
 {
-	return (char*)&obuffer_[n];
+	return obuffer_;
 }
 
-NET_INLINE char* net::socket::socketbuf::oend(int n) const
+NET_INLINE char* net::socket::socketbuf::oend(void) const
 {
-	return (char*)&obuffer_[n];
+	// one spare byte takes the character passed to overflow
+	return obuffer_ + osize_ - 1;
 }
 
-NET_INLINE char* net::socket::socketbuf::ibase(int n) const
+NET_INLINE char* net::socket::socketbuf::ibase(void) const
 {
-	return (char*)&ibuffer_[n];
+	return ibuffer_;
 }
 
-NET_INLINE char* net::socket::socketbuf::iend(int n) const
+NET_INLINE char* net::socket::socketbuf::iend(void) const
 {
-	return (char*)&ibuffer_[n];
+	return ibuffer_ + isize_;
+}
+
+NET_INLINE int net::socket::socketbuf::get_input_size(void) const
+{
+	return isize_;
+}
+
+NET_INLINE int net::socket::socketbuf::get_output_size(void) const
+{
+	return osize_;
 }
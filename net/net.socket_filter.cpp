@@ -0,0 +1,203 @@
+#include "net.prefix_table.h"
+#include "net.socket_filter.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// classic BPF opcodes, as in linux/filter.h, which is not available everywhere
+	// the program is built
+	const std::uint16_t op_ld = 0x00;
+	const std::uint16_t op_ldx = 0x01;
+	const std::uint16_t op_st = 0x02;
+	const std::uint16_t op_alu = 0x04;
+	const std::uint16_t op_jmp = 0x05;
+	const std::uint16_t op_ret = 0x06;
+
+	const std::uint16_t size_w = 0x00;
+	const std::uint16_t size_h = 0x08;
+	const std::uint16_t size_b = 0x10;
+
+	const std::uint16_t mode_abs = 0x20;
+	const std::uint16_t mode_ind = 0x40;
+	const std::uint16_t mode_mem = 0x60;
+	const std::uint16_t mode_msh = 0xa0;
+
+	const std::uint16_t alu_and = 0x50;
+	const std::uint16_t alu_rsh = 0x70;
+
+	const std::uint16_t jmp_ja = 0x00;
+	const std::uint16_t jmp_jeq = 0x10;
+	const std::uint16_t jmp_jgt = 0x20;
+	const std::uint16_t jmp_jge = 0x30;
+
+	const std::uint16_t src_k = 0x00;
+
+	// loads relative to the network header, wherever the socket layer has
+	// moved the packet data to
+	const std::uint32_t net_off = static_cast<std::uint32_t>(-0x100000);
+
+	// scratch memory slots
+	const std::uint32_t slot_version = 0;
+	const std::uint32_t slot_port = 1;
+}
+
+// verdicts are passed by reference, which needs their definitions
+const std::uint32_t net::socket_filter::drop;
+const std::uint32_t net::socket_filter::accept;
+
+net::socket_filter::socket_filter(const std::uint32_t& verdict)
+	: rules_()
+	, default_(verdict)
+{
+}
+
+net::socket_filter::~socket_filter(void)
+{
+}
+
+void net::socket_filter::add_prefix(const ip_address& prefix, const int& length,
+	const std::uint32_t& verdict)
+{
+	int bits = prefix.get_length() * 8;
+	if (prefix.get_family() == AF_UNSPEC || length < 0 || length > bits)
+		throw std::invalid_argument("Invalid prefix length");
+
+	rule r;
+	r.prefix_ = prefix;
+	r.length_ = length;
+	// IPv4 packets reach dual-stack listeners as IPv4, so mapped prefixes
+	// are matched against the IPv4 header
+	static const std::uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+	if (prefix.get_family() == AF_INET6 && length >= 96
+		&& std::memcmp(prefix.get_bytes(), mapped, sizeof(mapped)) == 0) {
+		r.prefix_ = ip_address(prefix.get_bytes() + 12, 4);
+		r.length_ = length - 96;
+	}
+	r.first_port_ = 0;
+	r.last_port_ = 0;
+	r.by_port_ = false;
+	r.verdict_ = verdict;
+	rules_.push_back(r);
+}
+
+void net::socket_filter::add_prefix(const std::string& prefix, const std::uint32_t& verdict)
+{
+	ip_address addr;
+	int length = 0;
+	if (!prefix_table::try_parse(prefix, addr, length))
+		throw std::invalid_argument("Not a prefix: " + prefix);
+	add_prefix(addr, length, verdict);
+}
+
+void net::socket_filter::add_source_ports(const std::uint16_t& first,
+	const std::uint16_t& last, const std::uint32_t& verdict)
+{
+	if (first > last)
+		throw std::invalid_argument("Invalid port range");
+	rule r;
+	r.length_ = 0;
+	r.first_port_ = first;
+	r.last_port_ = last;
+	r.by_port_ = true;
+	r.verdict_ = verdict;
+	rules_.push_back(r);
+}
+
+void net::socket_filter::clear(void)
+{
+	rules_.clear();
+}
+
+std::vector<net::socket_filter::instruction> net::socket_filter::compile(void) const
+{
+	std::vector<instruction> code;
+
+	// M[0] = IP version
+	emit(code, op_ld | size_b | mode_abs, net_off);
+	emit(code, op_alu | alu_rsh | src_k, 4);
+	emit(code, op_st, slot_version);
+
+	bool ports = false;
+	for (std::size_t i = 0; i < rules_.size() && !ports; ++i)
+		ports = rules_[i].by_port_;
+	if (ports) {
+		// M[1] = source port, after the variable IPv4 header or the fixed
+		// IPv6 one
+		emit(code, op_jmp | jmp_jeq | src_k, 4, 0, 3);
+		emit(code, op_ldx | size_b | mode_msh, net_off);
+		emit(code, op_ld | size_h | mode_ind, net_off);
+		emit(code, op_jmp | jmp_ja, 1);
+		emit(code, op_ld | size_h | mode_abs, net_off + 40);
+		emit(code, op_st, slot_port);
+	}
+
+	for (std::size_t i = 0; i < rules_.size(); ++i) {
+		const rule& r = rules_[i];
+		if (r.by_port_) {
+			emit(code, op_ld | size_w | mode_mem, slot_port);
+			emit(code, op_jmp | jmp_jge | src_k, r.first_port_, 0, 2);
+			emit(code, op_jmp | jmp_jgt | src_k, r.last_port_, 1, 0);
+			emit(code, op_ret | src_k, r.verdict_);
+		}
+		else
+			emit_prefix(code, r);
+	}
+	emit(code, op_ret | src_k, default_);
+
+	if (code.size() > static_cast<std::size_t>(max_instructions))
+		throw std::length_error("Socket filter has too many rules");
+	return code;
+}
+
+void net::socket_filter::emit(std::vector<instruction>& code, const std::uint16_t& op,
+	const std::uint32_t& k, const std::uint8_t& jt, const std::uint8_t& jf)
+{
+	instruction i;
+	i.code = op;
+	i.jt = jt;
+	i.jf = jf;
+	i.k = k;
+	code.push_back(i);
+}
+
+void net::socket_filter::emit_prefix(std::vector<instruction>& code, const rule& r)
+{
+	const bool v4 = r.prefix_.get_family() == AF_INET;
+	const std::uint8_t* bytes = r.prefix_.get_bytes();
+	const std::uint32_t source = v4 ? 12 : 8;
+
+	// one test per address word the prefix reaches into, each jumping to
+	// the next rule on mismatch
+	int words = (r.length_ + 31) / 32;
+	int tests = 0;
+	for (int w = 0; w < words; ++w)
+		tests += r.length_ - w * 32 >= 32 ? 2 : 3;
+
+	emit(code, op_ld | size_w | mode_mem, slot_version);
+	emit(code, op_jmp | jmp_jeq | src_k, v4 ? 4 : 6, 0,
+		static_cast<std::uint8_t>(tests + 1));
+	for (int w = 0; w < words; ++w) {
+		std::uint32_t value = (static_cast<std::uint32_t>(bytes[w * 4]) << 24)
+			| (static_cast<std::uint32_t>(bytes[w * 4 + 1]) << 16)
+			| (static_cast<std::uint32_t>(bytes[w * 4 + 2]) << 8)
+			| bytes[w * 4 + 3];
+		int bits = r.length_ - w * 32;
+		emit(code, op_ld | size_w | mode_abs, net_off + source + w * 4);
+		tests -= 2;
+		if (bits < 32) {
+			std::uint32_t mask = ~(0xffffffffu >> bits);
+			emit(code, op_alu | alu_and | src_k, mask);
+			value &= mask;
+			--tests;
+		}
+		emit(code, op_jmp | jmp_jeq | src_k, value, 0,
+			static_cast<std::uint8_t>(tests + 1));
+	}
+	emit(code, op_ret | src_k, r.verdict_);
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.socket_filter.inl"
+#endif
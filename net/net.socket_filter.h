@@ -0,0 +1,135 @@
+#ifndef __NET_SOCKET_FILTER__
+#define __NET_SOCKET_FILTER__
+
+#include "net.config.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "net.ip_address.h"
+
+namespace net
+{
+	/**
+	* Builds a classic BPF program from a list of rules on the source of
+	* incoming packets, for the kernel to run before they reach user space.
+	* Rules match a source address prefix or a range of source ports and
+	* are tried in the order they were added; the verdict of the first
+	* match, or the default verdict, is returned.
+	*
+	* Attached with server_socket::attach_filter the verdict decides if a
+	* packet is kept: drop discards it, so a SYN from a denied peer never
+	* creates a connection. Attached with
+	* server_socket::attach_reuseport_filter the verdict is the index of
+	* the socket in the SO_REUSEPORT group which receives the connection;
+	* verdicts past the last socket, such as accept, leave the choice to
+	* the kernel's hash.
+	*
+	* Ports are read past a fixed 40 byte IPv6 header, so IPv6 packets with
+	* extension headers do not match port rules.
+	*/
+	class socket_filter
+	{
+	public:
+		/**
+		* One instruction, laid out as the kernel's struct sock_filter.
+		*/
+		struct instruction
+		{
+			std::uint16_t code;
+			std::uint8_t jt;
+			std::uint8_t jf;
+			std::uint32_t k;
+		};
+
+		/**
+		* Verdicts which discard and keep a packet.
+		*/
+		static const std::uint32_t drop = 0;
+		static const std::uint32_t accept = 0xffffffff;
+
+		/**
+		* Largest program the kernel accepts.
+		*/
+		static const int max_instructions = 4096;
+	private:
+		struct rule
+		{
+			ip_address prefix_;
+			int length_;
+			std::uint16_t first_port_;
+			std::uint16_t last_port_;
+			bool by_port_;
+			std::uint32_t verdict_;
+		};
+		std::vector<rule> rules_;
+		std::uint32_t default_;
+	public:
+		/**
+		* Creates a filter without rules which returns verdict for every
+		* packet.
+		*/
+		socket_filter(const std::uint32_t& verdict = accept);
+	public:
+		virtual ~socket_filter(void);
+	public:
+		/**
+		* Returns verdict for packets whose source address starts with the
+		* first length bits of prefix. An IPv4-mapped prefix matches IPv4
+		* packets. Throws std::invalid_argument if length exceeds the
+		* address size.
+		*/
+		void add_prefix(const ip_address& prefix, const int& length,
+			const std::uint32_t& verdict);
+
+		/**
+		* Returns verdict for packets from a prefix given as address/length
+		* or a single address.
+		*/
+		void add_prefix(const std::string& prefix, const std::uint32_t& verdict);
+
+		/**
+		* Returns verdict for TCP and UDP packets whose source port is
+		* within [first, last].
+		*/
+		void add_source_ports(const std::uint16_t& first, const std::uint16_t& last,
+			const std::uint32_t& verdict);
+
+		/**
+		* Removes all rules.
+		*/
+		void clear(void);
+
+		/**
+		* Returns the program. Throws std::length_error if it exceeds
+		* max_instructions.
+		*/
+		std::vector<instruction> compile(void) const;
+	public:
+		/**
+		* Gets the verdict for packets no rule matches.
+		*/
+		NET_INLINE std::uint32_t get_default(void) const;
+
+		/**
+		* Sets the verdict for packets no rule matches.
+		*/
+		NET_INLINE void set_default(const std::uint32_t& verdict);
+
+		/**
+		* Returns the number of rules.
+		*/
+		NET_INLINE std::size_t get_rule_count(void) const;
+	private:
+		static void emit(std::vector<instruction>& code, const std::uint16_t& op,
+			const std::uint32_t& k, const std::uint8_t& jt = 0, const std::uint8_t& jf = 0);
+		static void emit_prefix(std::vector<instruction>& code, const rule& r);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.socket_filter.inl"
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+NET_INLINE std::uint32_t net::socket_filter::get_default(void) const
+{
+	return default_;
+}
+
+NET_INLINE void net::socket_filter::set_default(const std::uint32_t& verdict)
+{
+	default_ = verdict;
+}
+
+NET_INLINE std::size_t net::socket_filter::get_rule_count(void) const
+{
+	return rules_.size();
+}
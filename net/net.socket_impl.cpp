@@ -1,5 +1,9 @@
 #include "net.socket_impl.h"
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
 net::socket_impl::socket_impl(const sio::socket_t& sock, const std::uint16_t& local_port,
 	const std::shared_ptr<net::net_address>& addr, const std::uint16_t& port)
 	: addr_(addr)
@@ -7,6 +11,11 @@ net::socket_impl::socket_impl(const sio::socket_t& sock, const std::uint16_t& lo
 	, sock_(sock)
 	, localaddr_(nullptr)
 	, localport_(local_port)
+	, remote_()
+	, local_()
+	, non_blocking_(false)
+	, accept_filter_()
+	, tag_(0)
 {
 }
 
@@ -14,6 +23,30 @@ net::socket_impl::~socket_impl(void)
 {
 }
 
+bool net::socket_impl::admit(const sio::socket_t& sock, const net::endpoint& peer,
+	std::int32_t& tag) const noexcept
+{
+	tag = 0;
+	if (!accept_filter_)
+		return true;
+	bool admitted = false;
+	try {
+		admitted = accept_filter_(peer, tag);
+	}
+	catch (...) {
+		// accepting goes on with the next connection as after a rejection
+		admitted = false;
+	}
+	if (!admitted) {
+#if defined(_WIN32)
+		::closesocket(sock);
+#else
+		::close(sock);
+#endif
+	}
+	return admitted;
+}
+
 #if !defined(__NET_INLINE__)
 #include "net.socket_impl.inl"
 #endif
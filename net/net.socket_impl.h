@@ -1,23 +1,88 @@
 #ifndef __NET_SOCKET_IMPL__
 #define __NET_SOCKET_IMPL__
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <vector>
 
 #include "sio.h"
 #include "net.config.h"
 #include "net.net_address.h"
+#include "net.endpoint.h"
 
 namespace net
 {
+	class socket_filter;
+
+	/**
+	* Describes one part of a scatter/gather transfer.
+	*/
+	struct io_vector
+	{
+		std::uint8_t* buffer;
+		int nbytes;
+	};
+
+	/**
+	* Describes one part of a gather write, which only reads the buffer.
+	*/
+	struct const_io_vector
+	{
+		const std::uint8_t* buffer;
+		int nbytes;
+	};
+
+	/**
+	* Describes one datagram of a batched transfer. To send, buffer holds
+	* nbytes of payload for peer, or for the connected peer if peer is
+	* unspecified. To receive, buffer has room for nbytes; length, peer
+	* and truncated are set to what arrived.
+	*/
+	struct datagram
+	{
+		std::uint8_t* buffer;
+		int nbytes;
+		int length;	// bytes sent or received
+		endpoint peer;
+		bool truncated;	// received datagram was longer than nbytes
+	};
+
 	class socket_impl
 	{
+	public:
+		/**
+		* Values returned by the non-blocking entries in place of a byte
+		* count.
+		*/
+		static const int end_of_stream = -1;
+		static const int would_block = -2;
+
+		/**
+		* Value returned by the std::error_code overloads in place of a
+		* byte count when they set an error.
+		*/
+		static const int failed = -3;
+
+		/**
+		* Decides on a connection accepted from peer before it is handed
+		* out. Returning false closes the connection; a tag stored in tag,
+		* which starts out as zero, is kept with the accepted socket.
+		*/
+		typedef std::function<bool(const endpoint& peer, std::int32_t& tag)> accept_filter;
 	protected:
 		std::shared_ptr<net_address> addr_;
 		std::uint16_t port_;
 		sio::socket_t sock_;
 		std::shared_ptr<net_address> localaddr_;
 		std::uint16_t localport_;
+		endpoint remote_;
+		endpoint local_;
+		bool non_blocking_;
+		accept_filter accept_filter_;
+		std::int32_t tag_;
 	public:
 		socket_impl(const sio::socket_t& sock, const std::uint16_t& local_port,
 			const std::shared_ptr<net_address>& addr, const std::uint16_t& port);
@@ -41,6 +106,11 @@ namespace net
 		virtual void bind(const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port) = 0;
 
+		/**
+		* Binds this socket to a local endpoint.
+		*/
+		virtual void bind(const endpoint& local) = 0;
+
 		/**
 		* Closes this socket. This makes later access invalid.
 		*/
@@ -67,6 +137,28 @@ namespace net
 		virtual void connect(const std::shared_ptr<net_address>& addr,
 			const std::uint16_t& port, const int& timeout) = 0;
 
+		/**
+		* Connects this socket to a remote endpoint with the given timeout.
+		* This method will block indefinitely if the timeout is set to zero.
+		*/
+		virtual void connect(const endpoint& remote, const int& timeout) = 0;
+
+		/**
+		* Starts connecting this socket to the remote host address and port
+		* number without waiting. Returns true if the connection was made at
+		* once, or false if it is in progress, in which case the socket
+		* becomes writable when it completes and finish_connect must be
+		* called.
+		*/
+		virtual bool try_connect(const std::shared_ptr<net_address>& addr,
+			const std::uint16_t& port) = 0;
+
+		/**
+		* Completes a connection started by try_connect once the socket is
+		* writable. Throws socket_exception if the connection failed.
+		*/
+		virtual void finish_connect(void) = 0;
+
 		/**
 		* Creates a new unconnected socket.
 		*/
@@ -82,6 +174,107 @@ namespace net
 		*/
 		virtual void write(const std::uint8_t* buffer, const int& nbytes) = 0;
 
+		/**
+		* Reads into the count buffers of vec in order with a single call.
+		* Returns the number of bytes read, end_of_stream once the peer
+		* closed the connection or would_block if the socket is non-blocking
+		* and nothing is pending. A blocking socket whose receive timeout
+		* expires returns would_block as well, not 0 as read() does, so that
+		* socket::read_v reports timeouts as socket::read does.
+		*/
+		virtual int read_v(const io_vector* vec, const int& count) = 0;
+
+		/**
+		* Writes the count buffers of vec in order, as few calls as possible.
+		* A blocking socket writes everything unless the send timeout expires
+		* after part of the data was sent. A non-blocking socket writes what
+		* fits into the send buffer. Returns the number of bytes written or
+		* would_block if nothing could be written.
+		*/
+		virtual int write_v(const const_io_vector* vec, const int& count) = 0;
+
+		/**
+		* Enables or disables zero-copy transmission for send_zero_copy.
+		*/
+		virtual void set_zero_copy(const bool& on) = 0;
+
+		/**
+		* Returns whether zero-copy transmission is enabled.
+		*/
+		virtual bool get_zero_copy(void) const = 0;
+
+		/**
+		* Sends nbytes from buffer. When zero-copy is enabled and the payload
+		* is large enough, the kernel transmits straight from buffer, which
+		* must then stay unchanged until reap_zero_copy has returned tag.
+		* Otherwise the bytes are copied and tag is released right away.
+		* Returns the number of bytes sent as write_v does.
+		*/
+		virtual int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag) = 0;
+
+		/**
+		* Appends the tags of buffers which the kernel has released to tags,
+		* waiting at most timeout milliseconds if none is ready. Returns the
+		* number of tags appended.
+		*/
+		virtual int reap_zero_copy(std::vector<std::uint64_t>& tags,
+			const int& timeout) = 0;
+
+		/**
+		* Returns the number of released bytes the kernel sent without
+		* copying them.
+		*/
+		virtual std::uint64_t get_zero_copy_bytes(void) const = 0;
+
+		/**
+		* Returns the number of released bytes which were copied, either
+		* because zero-copy was not used or because the kernel copied them.
+		*/
+		virtual std::uint64_t get_copied_bytes(void) const = 0;
+
+		/**
+		* Sends length bytes of the open file fd starting at offset, without
+		* copying them through user space where the platform allows it. A
+		* negative length sends up to the end of the file. The file offset
+		* of fd is not changed. Returns the number of bytes sent, which is
+		* less than length if the file ended, the send timeout expired after
+		* part of the data was sent or the socket is non-blocking and its
+		* send buffer filled up. Returns would_block if a non-blocking
+		* socket could not take any data. Bytes already read from a pipe or
+		* socket fd which did not reach the socket are kept and sent first
+		* by the next call.
+		*/
+		virtual std::int64_t send_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length) = 0;
+
+		/**
+		* Reads at most nbytes from the socket without raising an exception
+		* when no data is available. Returns the number of bytes read,
+		* end_of_stream once the peer closed the connection or would_block
+		* if the socket is non-blocking and nothing is pending.
+		*/
+		virtual int try_read(std::uint8_t* buffer, const int& nbytes) = 0;
+
+		/**
+		* Writes at most nbytes to the socket without raising an exception
+		* when the send buffer is full. Returns the number of bytes written,
+		* which may be less than nbytes, or would_block.
+		*/
+		virtual int try_write(const std::uint8_t* buffer, const int& nbytes) = 0;
+
+		/**
+		* Accepts a pending connection into new_socket without raising an
+		* exception when the backlog is empty. Returns zero on success or
+		* would_block.
+		*/
+		virtual int try_accept(std::shared_ptr<socket_impl>& new_socket) = 0;
+
+		/**
+		* Switches the socket between blocking and non-blocking mode.
+		*/
+		virtual void set_non_blocking(const bool& on) = 0;
+
 		/**
 		* Returns whether the socket supports urgent data or not.
 		*/
@@ -98,6 +291,19 @@ namespace net
 		*/
 		virtual void listen(const int& backlog) = 0;
 
+		/**
+		* Attaches filter to the socket for the kernel to run on incoming
+		* packets, replacing a filter attached before. With reuseport the
+		* program instead selects the socket of the SO_REUSEPORT group the
+		* socket belongs to which receives each new connection.
+		*/
+		virtual void attach_filter(const socket_filter& filter, const bool& reuseport) = 0;
+
+		/**
+		* Detaches the filter attached with the same reuseport flag.
+		*/
+		virtual void detach_filter(const bool& reuseport) = 0;
+
 		/**
 		* Closes the input channel of this socket.
 		*/
@@ -120,6 +326,61 @@ namespace net
 		*/
 		virtual void set_option_bool(const int& id, const bool& val) = 0;
 		virtual void set_option_int(const int& id, const int& val) = 0;
+	public:
+		/**
+		* The overloads below report failures in ec instead of throwing, and
+		* clear it on success. They make the system calls themselves, so a
+		* routine failure such as a timeout or a reset costs no more than
+		* the call which failed. Results are those of the throwing
+		* overloads, except that operations returning a byte count return
+		* failed when they set ec, and timeouts are std::errc::timed_out.
+		* A connect with a zero timeout on a non-blocking socket fails with
+		* std::errc::operation_in_progress if the connection cannot be made
+		* at once; finish_connect completes it once the socket is writable.
+		*/
+		virtual void accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept = 0;
+		virtual void bind(const endpoint& local, std::error_code& ec) noexcept = 0;
+		virtual void close(std::error_code& ec) noexcept = 0;
+		virtual void connect(const endpoint& remote, const int& timeout,
+			std::error_code& ec) noexcept = 0;
+		virtual void finish_connect(std::error_code& ec) noexcept = 0;
+		virtual void create(const int& family, std::error_code& ec) noexcept = 0;
+		virtual int read_v(const io_vector* vec, const int& count,
+			std::error_code& ec) noexcept = 0;
+		virtual int write_v(const const_io_vector* vec, const int& count,
+			std::error_code& ec) noexcept = 0;
+		virtual void set_zero_copy(const bool& on, std::error_code& ec) noexcept = 0;
+		virtual int send_zero_copy(const std::uint8_t* buffer, const int& nbytes,
+			const std::uint64_t& tag, std::error_code& ec) noexcept = 0;
+		virtual std::int64_t send_file(const int& fd, const std::int64_t& offset,
+			const std::int64_t& length, std::error_code& ec) noexcept = 0;
+		virtual int try_read(std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept = 0;
+		virtual int try_write(const std::uint8_t* buffer, const int& nbytes,
+			std::error_code& ec) noexcept = 0;
+		virtual int try_accept(std::shared_ptr<socket_impl>& new_socket,
+			std::error_code& ec) noexcept = 0;
+		virtual void set_non_blocking(const bool& on, std::error_code& ec) noexcept = 0;
+		virtual void send_urgent_data(const int& value, std::error_code& ec) noexcept = 0;
+		virtual void listen(const int& backlog, std::error_code& ec) noexcept = 0;
+		virtual void shutdown_input(std::error_code& ec) noexcept = 0;
+		virtual void shutdown_output(std::error_code& ec) noexcept = 0;
+
+		/**
+		* Gets and sets socket options at the given protocol level. Timeouts
+		* are in milliseconds; SO_LINGER is read as the linger time, or -1
+		* if lingering is off, and set from an int to turn it on or a bool
+		* to turn it off.
+		*/
+		virtual bool get_option_bool(const int& level, const int& id,
+			std::error_code& ec) noexcept = 0;
+		virtual int get_option_int(const int& level, const int& id,
+			std::error_code& ec) noexcept = 0;
+		virtual void set_option_bool(const int& level, const int& id, const bool& val,
+			std::error_code& ec) noexcept = 0;
+		virtual void set_option_int(const int& level, const int& id, const int& val,
+			std::error_code& ec) noexcept = 0;
 	public:
 		/**
 		* Gets the native socket handle of this socket.
@@ -170,6 +431,71 @@ namespace net
 		* Sets the local port number of this socket.
 		*/
 		NET_INLINE void set_local_port(const std::uint16_t& port);
+
+		/**
+		* Gets the remote endpoint of this socket, unspecified if it is only
+		* known as a net_address.
+		*/
+		NET_INLINE const endpoint& get_remote_endpoint(void) const;
+
+		/**
+		* Sets the remote endpoint of this socket. Until set_address is
+		* called again, get_address and get_port report it.
+		*/
+		NET_INLINE void set_remote_endpoint(const endpoint& remote);
+
+		/**
+		* Gets the local endpoint of this socket, unspecified if it is only
+		* known as a net_address.
+		*/
+		NET_INLINE const endpoint& get_local_endpoint(void) const;
+
+		/**
+		* Sets the local endpoint of this socket. Until set_local_address is
+		* called again, get_local_address and get_local_port report it.
+		*/
+		NET_INLINE void set_local_endpoint(const endpoint& local);
+
+		/**
+		* Gets the address family of the local address without creating a
+		* net_address.
+		*/
+		NET_INLINE int get_local_family(void) const;
+
+		/**
+		* Returns whether the socket is in non-blocking mode.
+		*/
+		NET_INLINE bool is_non_blocking(void) const;
+
+		/**
+		* Records the blocking mode of a native handle which was created
+		* non-blocking. The handle itself is not changed.
+		*/
+		NET_INLINE void set_non_blocking_flag(const bool& on);
+
+		/**
+		* Sets the filter connections accepted by this listening socket
+		* pass through, or none if filter is empty.
+		*/
+		NET_INLINE void set_accept_filter(const accept_filter& filter);
+
+		/**
+		* Gets the tag the accept filter gave this connection.
+		*/
+		NET_INLINE std::int32_t get_tag(void) const;
+
+		/**
+		* Sets the tag of this connection.
+		*/
+		NET_INLINE void set_tag(const std::int32_t& tag);
+	protected:
+		/**
+		* Passes a connection just accepted on sock from peer through the
+		* accept filter. Returns false after closing sock if the filter
+		* rejected it or threw.
+		*/
+		bool admit(const sio::socket_t& sock, const endpoint& peer,
+			std::int32_t& tag) const noexcept;
 	private:
 		socket_impl(const socket_impl&);
 		socket_impl& operator=(const socket_impl&);
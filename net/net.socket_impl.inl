@@ -10,16 +10,22 @@ NET_INLINE void net::socket_impl::set_native_socket(const sio::socket_t& sock)
 
 NET_INLINE std::shared_ptr<net::net_address> net::socket_impl::get_address(void) const
 {
+	// endpoints are turned into net_address objects only when asked for
+	if (addr_ == nullptr && !remote_.is_unspecified())
+		return remote_.get_address().to_net_address();
 	return addr_;
 }
 
 NET_INLINE void net::socket_impl::set_address(const std::shared_ptr<net::net_address>& addr)
 {
 	addr_ = addr;
+	remote_ = endpoint();
 }
 
 NET_INLINE std::uint16_t net::socket_impl::get_port(void) const
 {
+	if (addr_ == nullptr && !remote_.is_unspecified())
+		return remote_.get_port();
 	return port_;
 }
 
@@ -30,16 +36,21 @@ NET_INLINE void net::socket_impl::set_port(const std::uint16_t& port)
 
 NET_INLINE std::shared_ptr<net::net_address> net::socket_impl::get_local_address(void) const
 {
+	if (localaddr_ == nullptr && !local_.is_unspecified())
+		return local_.get_address().to_net_address();
 	return localaddr_;
 }
 
 NET_INLINE void net::socket_impl::set_local_address(const std::shared_ptr<net::net_address>& addr)
 {
 	localaddr_ = addr;
+	local_ = endpoint();
 }
 
 NET_INLINE std::uint16_t net::socket_impl::get_local_port(void) const
 {
+	if (localaddr_ == nullptr && !local_.is_unspecified())
+		return local_.get_port();
 	return localport_;
 }
 
@@ -48,3 +59,56 @@ NET_INLINE void net::socket_impl::set_local_port(const std::uint16_t& port)
 	localport_ = port;
 }
 
+NET_INLINE const net::endpoint& net::socket_impl::get_remote_endpoint(void) const
+{
+	return remote_;
+}
+
+NET_INLINE void net::socket_impl::set_remote_endpoint(const endpoint& remote)
+{
+	remote_ = remote;
+	addr_ = nullptr;
+	port_ = remote.get_port();
+}
+
+NET_INLINE const net::endpoint& net::socket_impl::get_local_endpoint(void) const
+{
+	return local_;
+}
+
+NET_INLINE void net::socket_impl::set_local_endpoint(const endpoint& local)
+{
+	local_ = local;
+	localaddr_ = nullptr;
+	localport_ = local.get_port();
+}
+
+NET_INLINE int net::socket_impl::get_local_family(void) const
+{
+	return localaddr_ != nullptr ? localaddr_->get_family() : local_.get_family();
+}
+
+NET_INLINE bool net::socket_impl::is_non_blocking(void) const
+{
+	return non_blocking_;
+}
+
+NET_INLINE void net::socket_impl::set_non_blocking_flag(const bool& on)
+{
+	non_blocking_ = on;
+}
+
+NET_INLINE void net::socket_impl::set_accept_filter(const accept_filter& filter)
+{
+	accept_filter_ = filter;
+}
+
+NET_INLINE std::int32_t net::socket_impl::get_tag(void) const
+{
+	return tag_;
+}
+
+NET_INLINE void net::socket_impl::set_tag(const std::int32_t& tag)
+{
+	tag_ = tag;
+}
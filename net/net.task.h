@@ -0,0 +1,218 @@
+#ifndef __NET_TASK__
+#define __NET_TASK__
+
+#include "net.config.h"
+
+#if defined(NET_COROUTINES)
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace net
+{
+	template <typename T>
+	class task;
+
+	/**
+	* The part of the promise of a task which does not depend on its
+	* result: the awaiting coroutine, resumed when the task finishes, and
+	* the exception which escaped it.
+	*/
+	class task_promise_base
+	{
+		std::coroutine_handle<> continuation_;
+		std::exception_ptr exception_;
+	public:
+		struct final_awaiter
+		{
+			bool await_ready(void) const noexcept
+			{
+				return false;
+			}
+
+			template <typename P>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+			{
+				// transfer straight to the awaiting coroutine, so chains of
+				// tasks do not grow the stack
+				std::coroutine_handle<> next = h.promise().continuation_;
+				return next ? next : std::noop_coroutine();
+			}
+
+			void await_resume(void) const noexcept
+			{
+			}
+		};
+	public:
+		task_promise_base(void) noexcept
+			: continuation_(nullptr)
+			, exception_(nullptr)
+		{
+		}
+	public:
+		std::suspend_always initial_suspend(void) const noexcept
+		{
+			return std::suspend_always();
+		}
+
+		final_awaiter final_suspend(void) const noexcept
+		{
+			return final_awaiter();
+		}
+
+		void unhandled_exception(void) noexcept
+		{
+			exception_ = std::current_exception();
+		}
+
+		void set_continuation(const std::coroutine_handle<>& continuation) noexcept
+		{
+			continuation_ = continuation;
+		}
+
+		void rethrow_if_failed(void) const
+		{
+			if (exception_ != nullptr)
+				std::rethrow_exception(exception_);
+		}
+	};
+
+	template <typename T>
+	class task_promise : public task_promise_base
+	{
+		std::optional<T> value_;
+	public:
+		task<T> get_return_object(void) noexcept;
+
+		template <typename U>
+		void return_value(U&& value)
+		{
+			value_.emplace(std::forward<U>(value));
+		}
+
+		T result(void)
+		{
+			rethrow_if_failed();
+			return std::move(*value_);
+		}
+	};
+
+	template <>
+	class task_promise<void> : public task_promise_base
+	{
+	public:
+		task<void> get_return_object(void) noexcept;
+
+		void return_void(void) noexcept
+		{
+		}
+
+		void result(void)
+		{
+			rethrow_if_failed();
+		}
+	};
+
+	/**
+	* A coroutine producing a T, for sequential code on sockets which must
+	* not block its thread. A task starts when it is awaited, suspending
+	* the awaiting coroutine until it has finished, and the result or the
+	* exception of the task is that of the co_await. Tasks which nothing
+	* awaits are started with run_loop::spawn().
+	*
+	* Arguments of the coroutine are copied into its frame only if they
+	* are passed by value; references must outlive the task.
+	*/
+	template <typename T = void>
+	class task
+	{
+	public:
+		typedef task_promise<T> promise_type;
+	private:
+		std::coroutine_handle<promise_type> handle_;
+	public:
+		struct awaiter
+		{
+			std::coroutine_handle<promise_type> handle_;
+
+			bool await_ready(void) const noexcept
+			{
+				return handle_.done();
+			}
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				handle_.promise().set_continuation(awaiting);
+				return handle_;
+			}
+
+			T await_resume(void)
+			{
+				return handle_.promise().result();
+			}
+		};
+	public:
+		explicit task(const std::coroutine_handle<promise_type>& handle) noexcept
+			: handle_(handle)
+		{
+		}
+
+		task(task&& other) noexcept
+			: handle_(std::exchange(other.handle_, nullptr))
+		{
+		}
+
+		task& operator=(task&& other) noexcept
+		{
+			if (this != &other) {
+				if (handle_)
+					handle_.destroy();
+				handle_ = std::exchange(other.handle_, nullptr);
+			}
+			return *this;
+		}
+	public:
+		~task(void)
+		{
+			if (handle_)
+				handle_.destroy();
+		}
+	public:
+		/**
+		* Starts the task and suspends the awaiting coroutine until it has
+		* finished. A task can be awaited once.
+		*/
+		awaiter operator co_await(void) && noexcept
+		{
+			return awaiter{ handle_ };
+		}
+
+		/**
+		* Tests if the task has finished.
+		*/
+		bool is_done(void) const noexcept
+		{
+			return !handle_ || handle_.done();
+		}
+	private:
+		task(const task&);
+		task& operator=(const task&);
+	};
+
+	template <typename T>
+	inline task<T> task_promise<T>::get_return_object(void) noexcept
+	{
+		return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+	}
+
+	inline task<void> task_promise<void>::get_return_object(void) noexcept
+	{
+		return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+	}
+}
+
+#endif
+
+#endif
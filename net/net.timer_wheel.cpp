@@ -0,0 +1,244 @@
+#include "net.timer_wheel.h"
+
+#include <chrono>
+#include <limits>
+
+net::timer_wheel::timer_wheel(const int& resolution)
+	: nodes_()
+	, free_(none)
+	, size_(0)
+	, origin_(now_millis())
+	, current_(0)
+	, resolution_(resolution > 0 ? resolution : 1)
+{
+	for (int i = 0; i <= expiring; ++i)
+		heads_[i] = none;
+	for (int i = 0; i < levels; ++i)
+		counts_[i] = 0;
+}
+
+net::timer_wheel::~timer_wheel(void)
+{
+}
+
+net::timer_wheel::timer_id net::timer_wheel::schedule(const int& delay,
+	const callback& cb)
+{
+	std::uint32_t index = free_;
+	if (index != none)
+		free_ = nodes_[index].next_;
+	else {
+		node n;
+		n.prev_ = none;
+		n.next_ = none;
+		n.generation_ = 1;
+		n.list_ = none;
+		n.due_ = 0;
+		nodes_.push_back(n);
+		index = static_cast<std::uint32_t>(nodes_.size() - 1);
+	}
+	node& n = nodes_[index];
+	n.callback_ = cb;
+	n.due_ = ticks(now_millis() + (delay > 0 ? delay : 0) + resolution_ - 1);
+	if (n.due_ <= current_)
+		n.due_ = current_ + 1;
+	insert(index);
+	++size_;
+	return (static_cast<timer_id>(n.generation_) << 32) | index;
+}
+
+bool net::timer_wheel::reschedule(const timer_id& id, const int& delay)
+{
+	std::uint32_t index = static_cast<std::uint32_t>(id);
+	if (index >= nodes_.size() || nodes_[index].list_ == none
+		|| nodes_[index].generation_ != static_cast<std::uint32_t>(id >> 32))
+		return false;
+	node& n = nodes_[index];
+	unlink(index);
+	n.due_ = ticks(now_millis() + (delay > 0 ? delay : 0) + resolution_ - 1);
+	if (n.due_ <= current_)
+		n.due_ = current_ + 1;
+	insert(index);
+	return true;
+}
+
+bool net::timer_wheel::cancel(const timer_id& id)
+{
+	std::uint32_t index = static_cast<std::uint32_t>(id);
+	if (index >= nodes_.size() || nodes_[index].list_ == none
+		|| nodes_[index].generation_ != static_cast<std::uint32_t>(id >> 32))
+		return false;
+	unlink(index);
+	release(index);
+	--size_;
+	return true;
+}
+
+int net::timer_wheel::advance(void)
+{
+	return advance(now_millis());
+}
+
+int net::timer_wheel::advance(const std::uint64_t& now)
+{
+	std::uint64_t target = ticks(now);
+	while (current_ < target) {
+		// skip the ticks where nothing is due and no wheel with timers turns
+		std::uint64_t next = next_tick();
+		if (next == 0 || next > target) {
+			current_ = target;
+			break;
+		}
+		current_ = next;
+		if ((current_ & (slots - 1)) == 0) {
+			// a turn of a wheel brings the next slot of the wheel above down
+			for (int level = 1; level < levels; ++level) {
+				int slot = static_cast<int>(current_ >> (level * slot_bits)) & (slots - 1);
+				cascade(level * slots + slot);
+				if (slot != 0)
+					break;
+			}
+		}
+		std::uint32_t list = static_cast<std::uint32_t>(current_ & (slots - 1));
+		while (heads_[list] != none) {
+			std::uint32_t index = heads_[list];
+			unlink(index);
+			link(index, expiring);
+		}
+	}
+	return expire();
+}
+
+int net::timer_wheel::next_timeout(void) const
+{
+	if (heads_[expiring] != none)
+		return 0;
+	if (size_ == 0)
+		return -1;
+	std::uint64_t next = next_tick();
+	if (counts_[0] > 0) {
+		// the finest wheel holds the timers due within a turn, by tick
+		for (next = current_ + 1; heads_[next & (slots - 1)] == none; ++next)
+			;
+	}
+	std::uint64_t due = origin_ + next * resolution_;
+	std::uint64_t now = now_millis();
+	if (due <= now)
+		return 0;
+	if (due - now > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+		return std::numeric_limits<int>::max();
+	return static_cast<int>(due - now);
+}
+
+std::uint64_t net::timer_wheel::now_millis(void)
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::uint64_t net::timer_wheel::ticks(const std::uint64_t& now) const
+{
+	return now > origin_ ? (now - origin_) / resolution_ : 0;
+}
+
+std::uint64_t net::timer_wheel::next_tick(void) const
+{
+	// the next tick of the finest wheel holding timers: the next tick if
+	// that is the finest, or else the next turn of the wheel below it
+	std::uint64_t step = 1;
+	for (int level = 0; level < levels; ++level) {
+		if (counts_[level] > 0)
+			return (current_ | (step - 1)) + 1;
+		step <<= slot_bits;
+	}
+	return 0;
+}
+
+void net::timer_wheel::insert(const std::uint32_t& index)
+{
+	std::uint64_t due = nodes_[index].due_;
+	std::uint64_t delta = due - current_;
+	int level = 0;
+	while (level < levels - 1 && delta >= (static_cast<std::uint64_t>(1) << ((level + 1) * slot_bits)))
+		++level;
+	if (level == levels - 1) {
+		// beyond the coarsest wheel: wait in its last slot and be placed again
+		const std::uint64_t span = static_cast<std::uint64_t>(1) << (levels * slot_bits);
+		if (delta >= span)
+			due = current_ + span - 1;
+	}
+	int slot = static_cast<int>(due >> (level * slot_bits)) & (slots - 1);
+	link(index, static_cast<std::uint32_t>(level * slots + slot));
+}
+
+void net::timer_wheel::link(const std::uint32_t& index, const std::uint32_t& list)
+{
+	node& n = nodes_[index];
+	n.list_ = list;
+	n.prev_ = none;
+	n.next_ = heads_[list];
+	if (n.next_ != none)
+		nodes_[n.next_].prev_ = index;
+	heads_[list] = index;
+	if (list != static_cast<std::uint32_t>(expiring))
+		++counts_[level_of(list)];
+}
+
+void net::timer_wheel::unlink(const std::uint32_t& index)
+{
+	node& n = nodes_[index];
+	if (n.prev_ != none)
+		nodes_[n.prev_].next_ = n.next_;
+	else
+		heads_[n.list_] = n.next_;
+	if (n.next_ != none)
+		nodes_[n.next_].prev_ = n.prev_;
+	if (n.list_ != static_cast<std::uint32_t>(expiring))
+		--counts_[level_of(n.list_)];
+	n.list_ = none;
+}
+
+void net::timer_wheel::release(const std::uint32_t& index)
+{
+	node& n = nodes_[index];
+	n.callback_ = nullptr;
+	if (++n.generation_ == 0)
+		n.generation_ = 1;	// ids are never zero
+	n.next_ = free_;
+	free_ = index;
+}
+
+void net::timer_wheel::cascade(const int& list)
+{
+	std::uint32_t index = heads_[list];
+	heads_[list] = none;
+	while (index != none) {
+		std::uint32_t next = nodes_[index].next_;
+		--counts_[level_of(static_cast<std::uint32_t>(list))];
+		insert(index);
+		index = next;
+	}
+}
+
+int net::timer_wheel::expire(void)
+{
+	int count = 0;
+	while (heads_[expiring] != none) {
+		std::uint32_t index = heads_[expiring];
+		unlink(index);
+		// the callback may start timers, which can reuse the node
+		callback cb;
+		cb.swap(nodes_[index].callback_);
+		release(index);
+		--size_;
+		++count;
+		if (cb != nullptr)
+			cb();
+	}
+	return count;
+}
+
+#if !defined(__NET_INLINE__)
+#include "net.timer_wheel.inl"
+#endif
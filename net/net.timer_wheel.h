@@ -0,0 +1,144 @@
+#ifndef __NET_TIMER_WHEEL__
+#define __NET_TIMER_WHEEL__
+
+#include "net.config.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace net
+{
+	/**
+	* Runs callbacks after a delay, for the connect, idle and I/O
+	* timeouts of many sockets served by one loop. Timers are kept in four
+	* wheels of 256 slots, each slot of a wheel spanning a whole turn of
+	* the wheel below, so starting, moving and cancelling a timer takes
+	* constant time however many are pending, and advance() visits a
+	* slot per tick only while timers are due within the next turn of
+	* the finest wheel. A timer is due at most one tick late; timers due
+	* further out than 2^32 ticks wait in the coarsest wheel.
+	*
+	* Time is read from a monotonic clock in milliseconds. A timer_wheel
+	* belongs to the thread which advances it: callbacks run on that
+	* thread, from advance(), and may start and cancel timers.
+	*/
+	class timer_wheel
+	{
+	public:
+		/**
+		* Invoked once when a timer is due.
+		*/
+		typedef std::function<void(void)> callback;
+
+		/**
+		* Names a timer until it is due or cancelled; zero names none.
+		*/
+		typedef std::uint64_t timer_id;
+	private:
+		static const int levels = 4;
+		static const int slot_bits = 8;
+		static const int slots = 1 << slot_bits;
+		static const std::uint32_t none = 0xffffffff;
+		static const int expiring = levels * slots;	// list of due timers being run
+		struct node
+		{
+			std::uint32_t prev_;
+			std::uint32_t next_;
+			std::uint32_t generation_;
+			std::uint32_t list_;	// slot, expiring, or none when free
+			std::uint64_t due_;	// tick
+			callback callback_;
+		};
+		std::vector<node> nodes_;
+		std::uint32_t free_;
+		std::uint32_t heads_[expiring + 1];
+		std::size_t counts_[levels];
+		std::size_t size_;
+		std::uint64_t origin_;
+		std::uint64_t current_;
+		int resolution_;
+	public:
+		/**
+		* Creates a wheel ticking every resolution milliseconds, starting
+		* now.
+		*/
+		timer_wheel(const int& resolution = 1);
+	public:
+		virtual ~timer_wheel(void);
+	public:
+		/**
+		* Starts a timer which invokes cb once delay milliseconds from now
+		* have passed. Returns the timer's id.
+		*/
+		timer_id schedule(const int& delay, const callback& cb);
+
+		/**
+		* Moves a pending timer to delay milliseconds from now, as when the
+		* idle timeout of a connection starts over. Returns false if id
+		* names no pending timer.
+		*/
+		bool reschedule(const timer_id& id, const int& delay);
+
+		/**
+		* Cancels a pending timer. Returns false if id names no pending
+		* timer, as when it is due already.
+		*/
+		bool cancel(const timer_id& id);
+
+		/**
+		* Invokes the callbacks of the timers due by now and returns their
+		* number. If a callback throws, the exception propagates and the
+		* other due timers run on the next call.
+		*/
+		int advance(void);
+
+		/**
+		* Invokes the callbacks of the timers due by now, a time of
+		* now_millis().
+		*/
+		int advance(const std::uint64_t& now);
+
+		/**
+		* Returns the number of milliseconds until advance() has to be
+		* called next, zero if timers are due, or -1 if none is pending.
+		* Suited as the timeout of a poll.
+		*/
+		int next_timeout(void) const;
+
+		/**
+		* Reads the monotonic clock the wheel runs on, in milliseconds.
+		*/
+		static std::uint64_t now_millis(void);
+	public:
+		/**
+		* Returns the number of pending timers.
+		*/
+		NET_INLINE std::size_t size(void) const;
+
+		/**
+		* Returns the tick length in milliseconds.
+		*/
+		NET_INLINE int get_resolution(void) const;
+	private:
+		std::uint64_t ticks(const std::uint64_t& now) const;
+		std::uint64_t next_tick(void) const;
+		void insert(const std::uint32_t& index);
+		void link(const std::uint32_t& index, const std::uint32_t& list);
+		void unlink(const std::uint32_t& index);
+		void release(const std::uint32_t& index);
+		void cascade(const int& list);
+		int expire(void);
+		NET_INLINE static int level_of(const std::uint32_t& list);
+	private:
+		timer_wheel(const timer_wheel&);
+		timer_wheel& operator=(const timer_wheel&);
+		timer_wheel& operator=(const timer_wheel&&);
+	};
+}
+
+#if defined(__NET_INLINE__)
+#include "net.timer_wheel.inl"
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+NET_INLINE std::size_t net::timer_wheel::size(void) const
+{
+	return size_;
+}
+
+NET_INLINE int net::timer_wheel::get_resolution(void) const
+{
+	return resolution_;
+}
+
+NET_INLINE int net::timer_wheel::level_of(const std::uint32_t& list)
+{
+	return static_cast<int>(list >> slot_bits);
+}